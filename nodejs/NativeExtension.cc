@@ -5,6 +5,7 @@
 #include "ne_dbops.h"
 #include "ne_share.h"
 #include "ne_login.h"
+#include "ne_pointcloud.h"
 #include "ddb.h"
 
 using v8::FunctionTemplate;
@@ -18,6 +19,7 @@ NAN_MODULE_INIT(InitAll) {
     NAN_EXPORT(target, info);
 	NAN_EXPORT(target, _thumbs_getFromUserCache);
     NAN_EXPORT(target, _tile_getFromUserCache);
+    NAN_EXPORT(target, _userCache_getStats);
     NAN_EXPORT(target, init);
     NAN_EXPORT(target, add);
     NAN_EXPORT(target, remove);
@@ -25,6 +27,13 @@ NAN_MODULE_INIT(InitAll) {
     NAN_EXPORT(target, list);
     NAN_EXPORT(target, login);
     NAN_EXPORT(target, chattr);
+    NAN_EXPORT(target, stats);
+    NAN_EXPORT(target, flights);
+    NAN_EXPORT(target, search);
+    NAN_EXPORT(target, _pointcloud_info);
+    NAN_EXPORT(target, _pointcloud_hierarchy);
+    NAN_EXPORT(target, _pointcloud_query);
+    NAN_EXPORT(target, _pointcloud_node);
 
 	DDBRegisterProcess();
 }
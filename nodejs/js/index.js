@@ -17,6 +17,8 @@ const ddb = {
     thumbs,
 
     tile: {},
+    userCache: {},
+    pointCloud: {},
 
     registerNativeBindings: function(n){
         this.getVersion = n.getVersion;
@@ -40,6 +42,47 @@ const ddb = {
             });
         };
 
+        // Hit/miss counters of the in-memory index of thumbnails and tiles
+        this.userCache.getStats = n._userCache_getStats;
+
+        this.pointCloud.info = async function(ddbPath, path) {
+            return new Promise((resolve, reject) => {
+                n._pointcloud_info(ddbPath, path, (err, result) => {
+                    if (err) reject(err);
+                    else resolve(result);
+                });
+            });
+        };
+
+        this.pointCloud.hierarchy = async function(ddbPath, path, key = "0-0-0-0") {
+            return new Promise((resolve, reject) => {
+                n._pointcloud_hierarchy(ddbPath, path, key, (err, result) => {
+                    if (err) reject(err);
+                    else resolve(result);
+                });
+            });
+        };
+
+        // bbox: [minX, minY, maxX, maxY] in the coordinates of the point cloud
+        this.pointCloud.query = async function(ddbPath, path, bbox, options = {}) {
+            return new Promise((resolve, reject) => {
+                n._pointcloud_query(ddbPath, path, bbox[0], bbox[1], bbox[2], bbox[3], options, (err, result) => {
+                    if (err) reject(err);
+                    else resolve(result);
+                });
+            });
+        };
+
+        // Empty key returns the header (ept.json for EPT, LAS header and VLRs for COPC)
+        this.pointCloud.node = async function(ddbPath, path, key) {
+            return new Promise((resolve, reject) => {
+                n._pointcloud_node(ddbPath, path, key, (err, result) => {
+                    if (err) reject(err);
+                    else resolve(result);
+                });
+            });
+        };
+
         this.info = async function(paths, options = {}) {
             return new Promise((resolve, reject) => {
                 if (typeof paths === "string") paths = [paths];
@@ -123,6 +166,33 @@ const ddb = {
             });
         };
 
+        this.stats = async function(ddbPath){
+            return new Promise((resolve, reject) => {
+                n.stats(ddbPath, (err, stats) => {
+                    if (err) reject(err);
+                    else resolve(stats);
+                });
+            });
+        };
+
+        this.flights = async function(ddbPath, options = {}){
+            return new Promise((resolve, reject) => {
+                n.flights(ddbPath, options, (err, flights) => {
+                    if (err) reject(err);
+                    else resolve(flights);
+                });
+            });
+        };
+
+        this.search = async function(ddbPath, query, options = {}){
+            return new Promise((resolve, reject) => {
+                n.search(ddbPath, query, options, (err, entries) => {
+                    if (err) reject(err);
+                    else resolve(entries);
+                });
+            });
+        };
+
         // Guarantees that paths are expressed with
         // a ddbPath root or are absolute paths
         this._resolvePaths = function(ddbPath, paths){
@@ -255,3 +255,136 @@ NAN_METHOD(chattr) {
 
     Nan::AsyncQueueWorker(new ChattrWorker(callback, ddbPath, attrsJson));
 }
+
+
+class StatsWorker : public Nan::AsyncWorker {
+ public:
+  StatsWorker(Nan::Callback *callback, const std::string &ddbPath)
+    : AsyncWorker(callback, "nan:StatsWorker"),
+      ddbPath(ddbPath) {}
+  ~StatsWorker() {}
+
+  void Execute () {
+    if (DDBStats(ddbPath.c_str(), &output, "json") != DDBERR_NONE){
+        SetErrorMessage(DDBGetLastError());
+    }
+  }
+
+  void HandleOKCallback () {
+     Nan::HandleScope scope;
+
+     Nan::JSON json;
+     v8::Local<v8::Value> argv[] = {
+         Nan::Null(),
+         json.Parse(Nan::New<v8::String>(output).ToLocalChecked()).ToLocalChecked()
+     };
+
+     delete output;
+     callback->Call(2, argv, async_resource);
+   }
+
+ private:
+    std::string ddbPath;
+    char *output;
+};
+
+NAN_METHOD(stats) {
+    ASSERT_NUM_PARAMS(2);
+
+    BIND_STRING_PARAM(ddbPath, 0);
+    BIND_FUNCTION_PARAM(callback, 1);
+
+    Nan::AsyncQueueWorker(new StatsWorker(callback, ddbPath));
+}
+
+
+class FlightsWorker : public Nan::AsyncWorker {
+ public:
+  FlightsWorker(Nan::Callback *callback, const std::string &ddbPath, bool update)
+    : AsyncWorker(callback, "nan:FlightsWorker"),
+      ddbPath(ddbPath), update(update) {}
+  ~FlightsWorker() {}
+
+  void Execute () {
+    if (DDBFlights(ddbPath.c_str(), update, &output, "json") != DDBERR_NONE){
+        SetErrorMessage(DDBGetLastError());
+    }
+  }
+
+  void HandleOKCallback () {
+     Nan::HandleScope scope;
+
+     Nan::JSON json;
+     v8::Local<v8::Value> argv[] = {
+         Nan::Null(),
+         json.Parse(Nan::New<v8::String>(output).ToLocalChecked()).ToLocalChecked()
+     };
+
+     delete output;
+     callback->Call(2, argv, async_resource);
+   }
+
+ private:
+    std::string ddbPath;
+    bool update;
+    char *output;
+};
+
+NAN_METHOD(flights) {
+    ASSERT_NUM_PARAMS(3);
+
+    BIND_STRING_PARAM(ddbPath, 0);
+    BIND_OBJECT_PARAM(obj, 1);
+    BIND_OBJECT_VAR(obj, bool, update, true);
+    BIND_FUNCTION_PARAM(callback, 2);
+
+    Nan::AsyncQueueWorker(new FlightsWorker(callback, ddbPath, update));
+}
+
+
+class SearchWorker : public Nan::AsyncWorker {
+ public:
+  SearchWorker(Nan::Callback *callback, const std::string &ddbPath, const std::string &query, int limit, int offset)
+    : AsyncWorker(callback, "nan:SearchWorker"),
+      ddbPath(ddbPath), query(query), limit(limit), offset(offset) {}
+  ~SearchWorker() {}
+
+  void Execute () {
+    if (DDBSearch(ddbPath.c_str(), query.c_str(), &output, "json", limit, offset) != DDBERR_NONE){
+        SetErrorMessage(DDBGetLastError());
+    }
+  }
+
+  void HandleOKCallback () {
+     Nan::HandleScope scope;
+
+     Nan::JSON json;
+     v8::Local<v8::Value> argv[] = {
+         Nan::Null(),
+         json.Parse(Nan::New<v8::String>(output).ToLocalChecked()).ToLocalChecked()
+     };
+
+     delete output;
+     callback->Call(2, argv, async_resource);
+   }
+
+ private:
+    std::string ddbPath;
+    std::string query;
+    int limit;
+    int offset;
+    char *output;
+};
+
+NAN_METHOD(search) {
+    ASSERT_NUM_PARAMS(4);
+
+    BIND_STRING_PARAM(ddbPath, 0);
+    BIND_STRING_PARAM(query, 1);
+    BIND_OBJECT_PARAM(obj, 2);
+    BIND_OBJECT_VAR(obj, int, limit, 100);
+    BIND_OBJECT_VAR(obj, int, offset, 0);
+    BIND_FUNCTION_PARAM(callback, 3);
+
+    Nan::AsyncQueueWorker(new SearchWorker(callback, ddbPath, query, limit, offset));
+}
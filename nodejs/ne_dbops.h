@@ -11,6 +11,9 @@ NAN_METHOD(add);
 NAN_METHOD(remove);
 NAN_METHOD(list);
 NAN_METHOD(chattr);
+NAN_METHOD(stats);
+NAN_METHOD(flights);
+NAN_METHOD(search);
 
 
 #endif
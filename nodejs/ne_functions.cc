@@ -9,6 +9,7 @@
 #include "dbops.h"
 #include "info.h"
 #include "thumbs.h"
+#include "usercache.h"
 #include "entry.h"
 
 NAN_METHOD(getVersion) {
@@ -182,3 +183,12 @@ NAN_METHOD(_tile_getFromUserCache) {
     Nan::AsyncQueueWorker(new GetTileFromUserCacheWorker(callback, geotiffPath, tz, tx, ty, tileSize, tms, forceRecreate));
 }
 
+NAN_METHOD(_userCache_getStats) {
+    const json stats = {
+        {"thumbs", ddb::UserCacheIndex::thumbs().getStats().toJSON()},
+        {"tiles", ddb::UserCacheIndex::tiles().getStats().toJSON()}
+    };
+
+    Nan::JSON json;
+    info.GetReturnValue().Set(json.Parse(Nan::New<v8::String>(stats.dump()).ToLocalChecked()).ToLocalChecked());
+}
@@ -11,5 +11,6 @@ NAN_METHOD(getDefaultRegistry);
 NAN_METHOD(info);
 NAN_METHOD(_thumbs_getFromUserCache);
 NAN_METHOD(_tile_getFromUserCache);
+NAN_METHOD(_userCache_getStats);
 
 #endif
@@ -81,5 +81,12 @@ inline std::vector<std::string> v8ArrayToStrVec(const v8::Local<v8::Array> &arra
     } \
     int __name = Nan::To<int>(info[__num].As<v8::Int32>()).FromJust();
 
+#define BIND_DOUBLE_PARAM(__name, __num) \
+    if (!info[__num]->IsNumber()){ \
+        Nan::ThrowError("Argument " #__num " must be a number"); \
+        return; \
+    } \
+    double __name = Nan::To<double>(info[__num]).FromJust();
+
 
 #endif
@@ -0,0 +1,126 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <functional>
+#include "ddb.h"
+#include "ne_pointcloud.h"
+#include "ne_helpers.h"
+
+// Runs a C API call that outputs a JSON string
+class PointCloudJSONWorker : public Nan::AsyncWorker {
+ public:
+  PointCloudJSONWorker(Nan::Callback *callback, const std::function<DDBErr(char **)> &call)
+    : AsyncWorker(callback, "nan:PointCloudJSONWorker"),
+      call(call), output(nullptr) {}
+  ~PointCloudJSONWorker() {}
+
+  void Execute () {
+    if (call(&output) != DDBERR_NONE){
+        SetErrorMessage(DDBGetLastError());
+    }
+  }
+
+  void HandleOKCallback () {
+     Nan::HandleScope scope;
+
+     Nan::JSON json;
+     v8::Local<v8::Value> argv[] = {
+         Nan::Null(),
+         json.Parse(Nan::New<v8::String>(output).ToLocalChecked()).ToLocalChecked()
+     };
+
+     free(output);
+     callback->Call(2, argv, async_resource);
+   }
+
+ private:
+    std::function<DDBErr(char **)> call;
+    char *output;
+};
+
+NAN_METHOD(_pointcloud_info) {
+    ASSERT_NUM_PARAMS(3);
+
+    BIND_STRING_PARAM(ddbPath, 0);
+    BIND_STRING_PARAM(path, 1);
+    BIND_FUNCTION_PARAM(callback, 2);
+
+    Nan::AsyncQueueWorker(new PointCloudJSONWorker(callback, [ddbPath, path](char **output){
+        return DDBPointCloudInfo(ddbPath.c_str(), path.c_str(), output);
+    }));
+}
+
+NAN_METHOD(_pointcloud_hierarchy) {
+    ASSERT_NUM_PARAMS(4);
+
+    BIND_STRING_PARAM(ddbPath, 0);
+    BIND_STRING_PARAM(path, 1);
+    BIND_STRING_PARAM(key, 2);
+    BIND_FUNCTION_PARAM(callback, 3);
+
+    Nan::AsyncQueueWorker(new PointCloudJSONWorker(callback, [ddbPath, path, key](char **output){
+        return DDBPointCloudHierarchy(ddbPath.c_str(), path.c_str(), key.c_str(), output);
+    }));
+}
+
+NAN_METHOD(_pointcloud_query) {
+    ASSERT_NUM_PARAMS(8);
+
+    BIND_STRING_PARAM(ddbPath, 0);
+    BIND_STRING_PARAM(path, 1);
+    BIND_DOUBLE_PARAM(minX, 2);
+    BIND_DOUBLE_PARAM(minY, 3);
+    BIND_DOUBLE_PARAM(maxX, 4);
+    BIND_DOUBLE_PARAM(maxY, 5);
+    BIND_OBJECT_PARAM(obj, 6);
+    BIND_OBJECT_VAR(obj, int, maxDepth, -1);
+    BIND_FUNCTION_PARAM(callback, 7);
+
+    Nan::AsyncQueueWorker(new PointCloudJSONWorker(callback, [=](char **output){
+        return DDBPointCloudQuery(ddbPath.c_str(), path.c_str(), minX, minY, maxX, maxY, maxDepth, output);
+    }));
+}
+
+class PointCloudNodeWorker : public Nan::AsyncWorker {
+ public:
+  PointCloudNodeWorker(Nan::Callback *callback, const std::string &ddbPath, const std::string &path, const std::string &key)
+    : AsyncWorker(callback, "nan:PointCloudNodeWorker"),
+      ddbPath(ddbPath), path(path), key(key), data(nullptr), size(0) {}
+  ~PointCloudNodeWorker() {}
+
+  void Execute () {
+    if (DDBPointCloudNode(ddbPath.c_str(), path.c_str(), key.c_str(), &data, &size) != DDBERR_NONE){
+        SetErrorMessage(DDBGetLastError());
+    }
+  }
+
+  void HandleOKCallback () {
+     Nan::HandleScope scope;
+
+     // The buffer takes ownership of data
+     v8::Local<v8::Value> argv[] = {
+         Nan::Null(),
+         Nan::NewBuffer(reinterpret_cast<char *>(data), static_cast<uint32_t>(size)).ToLocalChecked()
+     };
+
+     callback->Call(2, argv, async_resource);
+   }
+
+ private:
+    std::string ddbPath;
+    std::string path;
+    std::string key;
+    uint8_t *data;
+    size_t size;
+};
+
+NAN_METHOD(_pointcloud_node) {
+    ASSERT_NUM_PARAMS(4);
+
+    BIND_STRING_PARAM(ddbPath, 0);
+    BIND_STRING_PARAM(path, 1);
+    BIND_STRING_PARAM(key, 2);
+    BIND_FUNCTION_PARAM(callback, 3);
+
+    Nan::AsyncQueueWorker(new PointCloudNodeWorker(callback, ddbPath, path, key));
+}
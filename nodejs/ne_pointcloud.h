@@ -0,0 +1,14 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef NE_POINTCLOUD_H
+#define NE_POINTCLOUD_H
+
+#include <nan.h>
+
+NAN_METHOD(_pointcloud_info);
+NAN_METHOD(_pointcloud_hierarchy);
+NAN_METHOD(_pointcloud_query);
+NAN_METHOD(_pointcloud_node);
+
+#endif
@@ -45,4 +45,81 @@ describe('ddbops', function() {
 
         await assert.rejects(ddb.chattr(ddbPath, { invalid: "123" }));        
     })
-});
\ No newline at end of file
+
+    it ('should be able to call stats()', async function(){
+        this.timeout(8000);
+
+        const t = new TestArea("stats", true);
+        const f = t.getFolder(".");
+        await ddb.init(f);
+
+        const imagePath = await t.downloadTestAsset("https://raw.githubusercontent.com/DroneDB/test_data/master/test-datasets/drone_dataset_brighton_beach/DJI_0018.JPG",
+            "DJI_0018.JPG");
+        await ddb.add(f, imagePath);
+
+        const stats = await ddb.stats(f);
+        assert.equal(stats.entries, 1);
+        assert.equal(stats.types.GeoImage.count, 1);
+        assert.ok(stats.totalSize > 0);
+        assert.equal(stats.cameras.length, 1);
+        assert.ok(Array.isArray(stats.extent));
+    });
+
+    it ('should be able to call flights()', async function(){
+        this.timeout(8000);
+
+        const t = new TestArea("flights", true);
+        const f = t.getFolder(".");
+        await ddb.init(f);
+
+        const imagePath = await t.downloadTestAsset("https://raw.githubusercontent.com/DroneDB/test_data/master/test-datasets/drone_dataset_brighton_beach/DJI_0018.JPG",
+            "DJI_0018.JPG");
+        await ddb.add(f, imagePath);
+
+        let flights = await ddb.flights(f, { update: false });
+        assert.equal(flights.length, 0);
+
+        flights = await ddb.flights(f);
+        assert.equal(flights.length, 1);
+        assert.equal(flights[0].images, 1);
+        assert.equal(flights[0].thumbnail, "DJI_0018.JPG");
+    });
+
+    it ('should be able to call search()', async function(){
+        this.timeout(8000);
+
+        const t = new TestArea("search", true);
+        const f = t.getFolder(".");
+        await ddb.init(f);
+
+        const imagePath = await t.downloadTestAsset("https://raw.githubusercontent.com/DroneDB/test_data/master/test-datasets/drone_dataset_brighton_beach/DJI_0018.JPG",
+            "DJI_0018.JPG");
+        await ddb.add(f, imagePath);
+
+        let entries = await ddb.search(f, "0018");
+        assert.equal(entries.length, 1);
+        assert.equal(entries[0].path, "DJI_0018.JPG");
+
+        entries = await ddb.search(f, "0018", { offset: 1 });
+        assert.equal(entries.length, 0);
+
+        await assert.rejects(ddb.search(f, ""));
+    });
+
+    it ('should reject pointCloud calls for entries that have not been built', async function(){
+        this.timeout(8000);
+
+        const t = new TestArea("pointCloud", true);
+        const f = t.getFolder(".");
+        await ddb.init(f);
+
+        const pcPath = await t.downloadTestAsset("https://github.com/DroneDB/test_data/raw/master/brighton/point_cloud.laz",
+            "point_cloud.laz");
+        await ddb.add(f, pcPath);
+
+        await assert.rejects(ddb.pointCloud.info(f, "point_cloud.laz"), /not been built/);
+        await assert.rejects(ddb.pointCloud.hierarchy(f, "point_cloud.laz", "not-a-key"));
+        await assert.rejects(ddb.pointCloud.query(f, "missing.laz", [0, 0, 1, 1]));
+        await assert.rejects(ddb.pointCloud.node(f, "point_cloud.laz", "0-0-0-0"));
+    });
+});
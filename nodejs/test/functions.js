@@ -70,6 +70,19 @@ describe('functions', function() {
     assert.ok(isPng(tile));
   });
 
+  it('should serve repeated tile requests from memory', async function(){
+    this.timeout(10000);
+    const t = new TestArea("tile");
+    const geotiffPath = await t.downloadTestAsset("https://raw.githubusercontent.com/DroneDB/test_data/master/brighton/odm_orthophoto.tif", 
+                              "ortho.tif");
+    const tile = await ddb.tile.getFromUserCache(geotiffPath, 19, 128168, 339545);
+    const before = ddb.userCache.getStats().tiles;
+    assert.equal(await ddb.tile.getFromUserCache(geotiffPath, 19, 128168, 339545), tile);
+    const after = ddb.userCache.getStats().tiles;
+    assert.equal(after.hits, before.hits + 1);
+    assert.ok(after.hitRate > 0);
+  });
+
   it('should fail grecefully when tile.getFromUserCache() is called on invalid file', async function(){
     await assert.rejects(ddb.tile.getFromUserCache("nonexistant", 19, 128168, 339545));
   });
@@ -2,28 +2,58 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <cmath>
+#include <sstream>
 #include "basicgeometry.h"
 #include "exceptions.h"
 #include "utils.h"
 
 namespace ddb{
 
+// Same output as json::dump()
+static void appendJsonNumber(std::string &out, double v){
+    if (!std::isfinite(v)){
+        out += "null";
+        return;
+    }
+    char buf[64];
+    const char *end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, static_cast<size_t>(end - buf));
+}
+
+static void appendJsonCoordinates(std::string &out, const Point &p){
+    out += '[';
+    appendJsonNumber(out, p.x);
+    out += ',';
+    appendJsonNumber(out, p.y);
+    out += ',';
+    appendJsonNumber(out, p.z);
+    out += ']';
+}
+
+void BasicGeometry::writeGeoJSON(std::string &out) const{
+    out += R"({"crs":{"properties":{"name":"EPSG:4326"},"type":"name"},"geometry":)";
+    writeGeoJSONGeometry(out);
+    out += R"(,"properties":{},"type":"Feature"})";
+}
+
 std::string BasicPointGeometry::toWkt() const{
     if (empty()) return "";
     return utils::stringFormat("POINT Z (%lf %lf %lf)", points[0].x, points[0].y, points[0].z);
 }
 
+void BasicPointGeometry::writeGeoJSONGeometry(std::string &out) const{
+    out += R"({"coordinates":)";
+    if (empty()) out += "[]";
+    else appendJsonCoordinates(out, points[0]);
+    out += R"(,"type":"Point"})";
+}
+
 json BasicPointGeometry::toGeoJSON() const{
     json j;
     initGeoJsonBase(j);
     j["geometry"]["type"] = "Point";
-    j["geometry"]["coordinates"] = json::array();
-
-    if (!empty()){
-        j["geometry"]["coordinates"] += points[0].x;
-        j["geometry"]["coordinates"] += points[0].y;
-        j["geometry"]["coordinates"] += points[0].z;
-    }
+    j["geometry"]["coordinates"] = empty() ? json::array() : json::array({points[0].x, points[0].y, points[0].z});
     return j;
 }
 
@@ -42,23 +72,29 @@ std::string BasicPolygonGeometry::toWkt() const{
     return os.str();
 }
 
+void BasicPolygonGeometry::writeGeoJSONGeometry(std::string &out) const{
+    out += R"({"coordinates":[[)";
+    bool first = true;
+    for (auto &p : points){
+        if (!first) out += ',';
+        appendJsonCoordinates(out, p);
+        first = false;
+    }
+    out += R"(]],"type":"Polygon"})";
+}
+
 json BasicPolygonGeometry::toGeoJSON() const{
     json j;
     initGeoJsonBase(j);
     j["geometry"]["type"] = "Polygon";
-    j["geometry"]["coordinates"] = json::array();
-    json poly = json::array();
 
+    json poly = json::array();
+    poly.get_ref<json::array_t &>().reserve(points.size());
     for (auto &p : points){
-        json c = json::array();
-        c += p.x;
-        c += p.y;
-        c += p.z;
-
-        poly += c;
+        poly.push_back(json::array({p.x, p.y, p.z}));
     }
 
-    j["geometry"]["coordinates"] += poly;
+    j["geometry"]["coordinates"] = json::array({std::move(poly)});
 
     return j;
 }
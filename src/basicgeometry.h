@@ -6,6 +6,7 @@
 #define BASICGEOMETRY_H
 
 #include <string>
+#include <vector>
 #include <iomanip>
 #include "json.h"
 #include "ddb_export.h"
@@ -25,6 +26,50 @@ inline std::ostream& operator<<(std::ostream& os, const Point& p){
     return os;
 }
 
+// Most geometries are a single point or a 5 point ring (footprints, raster
+// bounds), these are stored inline without allocating
+#define DDB_GEOMETRY_INLINE_POINTS 5
+
+class PointList{
+    Point local[DDB_GEOMETRY_INLINE_POINTS];
+    std::vector<Point> heap; // All the points, once there are too many to fit inline
+    size_t count = 0;
+public:
+    DDB_DLL Point *data() { return count > DDB_GEOMETRY_INLINE_POINTS ? heap.data() : local; }
+    DDB_DLL const Point *data() const { return count > DDB_GEOMETRY_INLINE_POINTS ? heap.data() : local; }
+
+    DDB_DLL Point *begin() { return data(); }
+    DDB_DLL Point *end() { return data() + count; }
+    DDB_DLL const Point *begin() const { return data(); }
+    DDB_DLL const Point *end() const { return data() + count; }
+
+    DDB_DLL Point &operator[](size_t i) { return data()[i]; }
+    DDB_DLL const Point &operator[](size_t i) const { return data()[i]; }
+    DDB_DLL Point &front() { return data()[0]; }
+    DDB_DLL Point &back() { return data()[count - 1]; }
+
+    DDB_DLL size_t size() const { return count; }
+    DDB_DLL bool empty() const { return count == 0; }
+
+    DDB_DLL void push_back(const Point &p){
+        if (count < DDB_GEOMETRY_INLINE_POINTS){
+            local[count] = p;
+        }else{
+            if (count == DDB_GEOMETRY_INLINE_POINTS){
+                heap.reserve(DDB_GEOMETRY_INLINE_POINTS * 2);
+                heap.assign(local, local + DDB_GEOMETRY_INLINE_POINTS);
+            }
+            heap.push_back(p);
+        }
+        count++;
+    }
+
+    DDB_DLL void clear(){
+        heap.clear();
+        count = 0;
+    }
+};
+
 struct BasicGeometry{
     DDB_DLL BasicGeometry() {}
 
@@ -38,7 +83,13 @@ struct BasicGeometry{
     DDB_DLL virtual std::string toWkt() const = 0;
     DDB_DLL virtual json toGeoJSON() const = 0;
 
-    std::vector<Point> points;
+    // Append to out without intermediate strings or json objects
+    DDB_DLL virtual void writeGeoJSONGeometry(std::string &out) const = 0;
+
+    // Same output as toGeoJSON().dump()
+    DDB_DLL void writeGeoJSON(std::string &out) const;
+
+    PointList points;
 protected:
     void initGeoJsonBase(json &j) const;
 };
@@ -55,11 +106,13 @@ inline std::ostream& operator<<(std::ostream& os, const BasicGeometry& g)
 struct BasicPointGeometry : BasicGeometry{
     DDB_DLL virtual std::string toWkt() const override;
     DDB_DLL virtual json toGeoJSON() const override;
+    DDB_DLL virtual void writeGeoJSONGeometry(std::string &out) const override;
 };
 
 struct BasicPolygonGeometry : BasicGeometry{
     DDB_DLL virtual std::string toWkt() const override;
     DDB_DLL virtual json toGeoJSON() const override;
+    DDB_DLL virtual void writeGeoJSONGeometry(std::string &out) const override;
 };
 
 enum BasicGeometryType {
@@ -10,25 +10,59 @@
 #include "dbops.h"
 #include "exceptions.h"
 #include "mio.h"
+#include "overviews.h"
 
 namespace ddb {
 
 void build_internal(Database* db, const Entry& e,
                            const std::string& outputPath, std::ostream& output,
-                           bool force) {
+                           bool force, bool buildCopcOutput) {
                                
     LOGD << "Building entry " << e.path << " type " << e.type;
 
+#ifndef DDB_COPC
+    if (buildCopcOutput) throw InvalidArgsException("COPC output is not available (DroneDB was built without DDB_COPC)");
+#endif
+
     const auto baseOutputPath = fs::path(outputPath) / e.hash;
+
+    if (e.type == GeoRaster) {
+        // Overviews reference the source file, which must not be a hardlink
+        // that goes away after the build
+        const auto o = baseOutputPath / "overviews";
+        if (!force && fs::exists(o)) return;
+
+        const auto rasterPath = rootDirectory(db) / e.path;
+        const auto tmp = baseOutputPath / "overviews-tmp";
+        io::assureIsRemoved(tmp);
+
+        try{
+            if (buildOverviews(rasterPath.string(), (tmp / DDB_OVERVIEWS_FILE).string())) {
+                io::assureIsRemoved(o);
+                fs::rename(tmp, o);
+                output << o.string() << std::endl;
+            }
+        }catch(...){
+            io::assureIsRemoved(tmp);
+            throw;
+        }
+
+        return;
+    }
+
     std::string o;
+    std::string copc;
 
     if (e.type == PointCloud) {
         o = (baseOutputPath / "ept").string();
+        if (buildCopcOutput) copc = (baseOutputPath / "copc" / DDB_COPC_FILE).string();
     }else{
         return; // No build needed
     }
 
-    if (fs::exists(o) && !force) {
+    const bool buildO = force || !fs::exists(o);
+    const bool buildCopcFile = !copc.empty() && (force || !fs::exists(copc));
+    if (!buildO && !buildCopcFile) {
         return;
     }
 
@@ -57,9 +91,31 @@ void build_internal(Database* db, const Entry& e,
         if (e.type == PointCloud) {
             const std::vector vec = {relativePath};
 
-            buildEpt(vec, o);
-
-            output << o << std::endl;
+            if (buildO) buildEpt(vec, o);
+
+            // Single file alternative to EPT, easier to move around and
+            // to serve with range requests
+#ifdef DDB_COPC
+            if (buildCopcFile) {
+                buildCopc(vec, copc);
+                output << copc << std::endl;
+            }
+#endif
+
+            // Replace the bounding box with the outline of the points
+            try{
+                BasicPolygonGeometry footprint;
+                if (getPointCloudFootprint(relativePath, footprint)){
+                    auto q = db->query("UPDATE entries SET polygon_geom = GeomFromText(?, 4326) WHERE path = ?");
+                    q->bind(1, footprint.toWkt());
+                    q->bind(2, e.path);
+                    q->execute();
+                }
+            }catch(const AppException &err){
+                LOGD << "Cannot compute footprint of " << e.path << ": " << err.what();
+            }
+
+            if (buildO) output << o << std::endl;
         }
 
         io::assureIsRemoved(hardlink);
@@ -70,24 +126,25 @@ void build_internal(Database* db, const Entry& e,
 }
 
 void build_all(Database* db, const std::string& outputPath,
-               std::ostream& output, bool force) {
+               std::ostream& output, bool force, bool copc) {
 
     LOGD << "In build_all('" << outputPath << "')";
 
     // List all matching files in DB
-    auto q = db->query("SELECT path, hash, type, meta, mtime, size, depth FROM entries WHERE type = ?");
+    auto q = db->query("SELECT path, hash, type, meta, mtime, size, depth FROM entries WHERE type = ? OR type = ?");
     q->bind(1, EntryType::PointCloud);
+    q->bind(2, EntryType::GeoRaster);
 
     while (q->fetch()) {
         Entry e(*q);
 
         // Call build on each of them
-        build_internal(db, e, outputPath, output, force);
+        build_internal(db, e, outputPath, output, force, copc);
     }
 }
 
 void build(Database* db, const std::string& path, const std::string& outputPath,
-           std::ostream& output, bool force) {
+           std::ostream& output, bool force, bool copc) {
 
     LOGD << "In build('" << path << "','" << outputPath << "')";
 
@@ -96,7 +153,7 @@ void build(Database* db, const std::string& path, const std::string& outputPath,
     const bool entryExists = getEntry(db, path, &e) != nullptr;
     if (!entryExists) throw InvalidArgsException(path + " is not a valid path in the database.");
 
-    build_internal(db, e, outputPath, output, force);
+    build_internal(db, e, outputPath, output, force, copc);
 }
 
 }  // namespace ddb
@@ -11,11 +11,15 @@
 namespace ddb {
 
 #define DDB_BUILD_PATH "build"
+#define DDB_COPC_FILE "cloud.copc.laz"
 
+// Point clouds are built to EPT and, if copc is true,
+// also to a single COPC file (only in builds with DDB_COPC)
 DDB_DLL void build_all(Database* db, const std::string& outputPath,
-                       std::ostream& output, bool force = false);
+                       std::ostream& output, bool force = false, bool copc = false);
 DDB_DLL void build(Database* db, const std::string& path,
-                   const std::string& outputPath, std::ostream& output, bool force = false);
+                   const std::string& outputPath, std::ostream& output, bool force = false,
+                   bool copc = false);
 
 }
 
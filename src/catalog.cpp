@@ -0,0 +1,358 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <ctime>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+#include "catalog.h"
+#include "ddb.h"
+#include "dbops.h"
+#include "entry_types.h"
+#include "exceptions.h"
+#include "logger.h"
+#include "mio.h"
+#include "userprofile.h"
+
+namespace ddb {
+
+// The extent is also stored in an R*Tree, which holds 32 bit floats
+// (rounded outwards): it narrows down the candidates, the exact
+// bounds in datasets do the rest
+const char *catalogDdl = R"<<<(
+  CREATE TABLE IF NOT EXISTS datasets (
+      id INTEGER PRIMARY KEY,
+      path TEXT NOT NULL UNIQUE,
+      mtime INTEGER,
+      changes INTEGER,
+      entries INTEGER,
+      images INTEGER,
+      size INTEGER,
+      min_capture_time REAL,
+      max_capture_time REAL,
+      min_lon REAL,
+      min_lat REAL,
+      max_lon REAL,
+      max_lat REAL
+  );
+  CREATE INDEX IF NOT EXISTS ix_datasets_capture_time ON datasets (min_capture_time, max_capture_time);
+  CREATE VIRTUAL TABLE IF NOT EXISTS datasets_extent USING rtree(id, min_lon, max_lon, min_lat, max_lat);
+)<<<";
+
+Catalog::Catalog(const std::string &file){
+    const std::string f = file.empty() ? UserProfile::get()->getCatalogFile().string() : file;
+    db.open(f);
+    db.setJournalMode("wal");
+    db.exec(catalogDdl);
+
+    if (!db.columnExists("datasets", "changes")){
+        LOGD << "Adding changes column to catalog";
+        db.exec("ALTER TABLE datasets ADD COLUMN changes INTEGER");
+    }
+}
+
+json DatasetSummary::toJSON() const{
+    json j = {
+        {"path", path},
+        {"mtime", mtime},
+        {"entries", entries},
+        {"images", images},
+        {"size", size}
+    };
+
+    if (std::isnan(minCaptureTime)) j["captureTime"] = nullptr;
+    else j["captureTime"] = {minCaptureTime, maxCaptureTime};
+
+    if (hasExtent) j["extent"] = {minLon, minLat, maxLon, maxLat};
+    else j["extent"] = nullptr;
+
+    return j;
+}
+
+// Reads the mtime attribute and the change counter of a dataset index
+// through a read only connection, without migrating its schema.
+// A missing counter is -1.
+static void readVersion(const fs::path &dataset, time_t &mtime, long long &changes){
+    mtime = 0;
+    changes = -1;
+
+    SqliteDatabase db;
+    db.open((dataset / DDB_FOLDER / "dbase.sqlite").string(), true);
+    if (!db.tableExists("attributes")) return;
+
+    auto q = db.query("SELECT name, ivalue FROM attributes WHERE name IN ('mtime', 'stats_changes')");
+    while (q->fetch()){
+        if (q->isNull(1)) continue;
+        if (q->getText(0) == "mtime") mtime = static_cast<time_t>(q->getInt64(1));
+        else changes = q->getInt64(1);
+    }
+}
+
+// Fills summary for a dataset, unless its mtime attribute is knownMtime
+// and its change counter is knownChanges (the mtime attribute has a one
+// second resolution, the counter catches the writes it misses).
+// Returns false if the dataset did not change.
+bool Catalog::summarize(const fs::path &dataset, time_t knownMtime, long long knownChanges, DatasetSummary &summary){
+    readVersion(dataset, summary.mtime, summary.changes);
+    if (summary.changes >= 0 && summary.mtime == knownMtime && summary.changes == knownChanges) return false;
+
+    // Changed (or never summarized). Other people's datasets are only read:
+    // an index with an older schema is summarized as it is (without a change
+    // counter, so it's summarized again on the next harvest)
+    Database ds;
+    ds.open((dataset / DDB_FOLDER / "dbase.sqlite").string(), true);
+
+    const auto stats = ds.getStats();
+    summary.entries = stats.entries;
+    summary.size = stats.size;
+    for (const auto &t : stats.countByType){
+        if (t.first == EntryType::Image || t.first == EntryType::GeoImage) summary.images += t.second;
+    }
+
+    summary.hasExtent = stats.hasExtent();
+    if (summary.hasExtent){
+        summary.minLon = stats.minX;
+        summary.minLat = stats.minY;
+        summary.maxLon = stats.maxX;
+        summary.maxLat = stats.maxY;
+    }
+
+    // Separate subqueries, so that both use the capture_time index (if any)
+    const std::string captureTime = ds.metaColumn("capture_time");
+    auto q = ds.query("SELECT (SELECT MIN(" + captureTime + ") FROM entries), (SELECT MAX(" + captureTime + ") FROM entries)");
+    if (q->fetch() && !q->isNull(0)){
+        summary.minCaptureTime = q->getDouble(0);
+        summary.maxCaptureTime = q->getDouble(1);
+    }
+
+    return true;
+}
+
+size_t Catalog::harvest(const std::vector<std::string> &paths, const HarvestCallback &callback){
+    // Find the datasets, including the ones nested in other datasets
+    std::set<std::string> datasets;
+    auto isDataset = [](const fs::path &p){
+        return fs::exists(p / DDB_FOLDER / "dbase.sqlite");
+    };
+
+    for (const auto &path : paths){
+        const fs::path p = fs::weakly_canonical(fs::absolute(path));
+        if (!fs::is_directory(p)) throw FSException(path + " is not a directory");
+
+        if (isDataset(p)) datasets.insert(p.generic_string());
+
+        for (auto i = fs::recursive_directory_iterator(p, fs::directory_options::skip_permission_denied);
+             i != fs::recursive_directory_iterator(); ++i){
+            if (!i->is_directory()) continue;
+            if (i->path().filename() == DDB_FOLDER){
+                i.disable_recursion_pending();
+                continue;
+            }
+            if (isDataset(i->path())) datasets.insert(i->path().generic_string());
+        }
+    }
+
+    LOGD << "Found " << datasets.size() << " datasets";
+
+    auto selectQ = db.query("SELECT id, mtime, changes FROM datasets WHERE path = ?");
+    auto insertQ = db.query("INSERT INTO datasets (path, mtime, entries, images, size, min_capture_time, max_capture_time, "
+                            "min_lon, min_lat, max_lon, max_lat, changes) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    auto updateQ = db.query("UPDATE datasets SET path = ?, mtime = ?, entries = ?, images = ?, size = ?, "
+                            "min_capture_time = ?, max_capture_time = ?, min_lon = ?, min_lat = ?, max_lon = ?, max_lat = ?, "
+                            "changes = ? WHERE id = ?");
+    auto deleteExtentQ = db.query("DELETE FROM datasets_extent WHERE id = ?");
+    auto insertExtentQ = db.query("INSERT INTO datasets_extent (id, min_lon, max_lon, min_lat, max_lat) VALUES (?, ?, ?, ?, ?)");
+
+    auto bindSummary = [](Statement *q, const DatasetSummary &s){
+        q->bind(1, s.path);
+        q->bind(2, static_cast<long long>(s.mtime));
+        q->bind(3, static_cast<long long>(s.entries));
+        q->bind(4, static_cast<long long>(s.images));
+        q->bind(5, static_cast<long long>(s.size));
+        if (std::isnan(s.minCaptureTime)){
+            q->bindNull(6);
+            q->bindNull(7);
+        }else{
+            q->bind(6, s.minCaptureTime);
+            q->bind(7, s.maxCaptureTime);
+        }
+        if (s.hasExtent){
+            q->bind(8, s.minLon);
+            q->bind(9, s.minLat);
+            q->bind(10, s.maxLon);
+            q->bind(11, s.maxLat);
+        }else{
+            for (int i = 8; i <= 11; i++) q->bindNull(i);
+        }
+        q->bind(12, s.changes);
+    };
+
+    size_t changed = 0;
+
+    db.exec("BEGIN EXCLUSIVE TRANSACTION");
+
+    try{
+        for (const auto &path : datasets){
+            selectQ->bind(1, path);
+            const bool exists = selectQ->fetch();
+            const long long id = exists ? selectQ->getInt64(0) : 0;
+            const time_t knownMtime = exists ? static_cast<time_t>(selectQ->getInt64(1)) : -1;
+            const long long knownChanges = exists && !selectQ->isNull(2) ? selectQ->getInt64(2) : -1;
+            selectQ->reset();
+
+            DatasetSummary summary;
+            summary.path = path;
+
+            try{
+                if (!summarize(path, knownMtime, knownChanges, summary)) continue;
+            }catch(const AppException &e){
+                LOGD << "Cannot summarize " << path << ", skipping: " << e.what();
+                continue;
+            }
+
+            long long rowId = id;
+            if (exists){
+                bindSummary(updateQ.get(), summary);
+                updateQ->bind(13, id);
+                updateQ->execute();
+            }else{
+                bindSummary(insertQ.get(), summary);
+                insertQ->execute();
+                auto q = db.query("SELECT last_insert_rowid()");
+                q->fetch();
+                rowId = q->getInt64(0);
+            }
+
+            deleteExtentQ->bind(1, rowId);
+            deleteExtentQ->execute();
+            if (summary.hasExtent){
+                insertExtentQ->bind(1, rowId);
+                insertExtentQ->bind(2, summary.minLon);
+                insertExtentQ->bind(3, summary.maxLon);
+                insertExtentQ->bind(4, summary.minLat);
+                insertExtentQ->bind(5, summary.maxLat);
+                insertExtentQ->execute();
+            }
+
+            changed++;
+            if (callback != nullptr) callback(summary, exists, false);
+        }
+
+        // Datasets that have been deleted
+        std::vector<std::pair<long long, std::string>> removed;
+        auto q = db.query("SELECT id, path FROM datasets");
+        while (q->fetch()){
+            const std::string path = q->getText(1);
+            if (!isDataset(path)) removed.emplace_back(q->getInt64(0), path);
+        }
+
+        auto deleteQ = db.query("DELETE FROM datasets WHERE id = ?");
+        for (const auto &r : removed){
+            deleteQ->bind(1, r.first);
+            deleteQ->execute();
+            deleteExtentQ->bind(1, r.first);
+            deleteExtentQ->execute();
+
+            changed++;
+            if (callback != nullptr){
+                DatasetSummary summary;
+                summary.path = r.second;
+                callback(summary, false, true);
+            }
+        }
+    }catch(...){
+        db.exec("ROLLBACK");
+        throw;
+    }
+
+    db.exec("COMMIT");
+
+    return changed;
+}
+
+std::vector<DatasetSummary> Catalog::search(const CatalogFilter &filter){
+    std::string sql = "SELECT path, mtime, entries, images, size, min_capture_time, max_capture_time, "
+                      "min_lon, min_lat, max_lon, max_lat FROM datasets WHERE 1";
+
+    if (filter.hasBounds){
+        sql += " AND id IN (SELECT id FROM datasets_extent WHERE min_lon <= ? AND max_lon >= ? AND min_lat <= ? AND max_lat >= ?)"
+               " AND min_lon <= ? AND max_lon >= ? AND min_lat <= ? AND max_lat >= ?";
+    }
+    if (filter.capturedAfter > 0.0) sql += " AND max_capture_time >= ?";
+    if (filter.capturedBefore > 0.0) sql += " AND min_capture_time <= ?";
+    sql += " ORDER BY path";
+
+    auto q = db.query(sql);
+
+    int p = 1;
+    if (filter.hasBounds){
+        for (int i = 0; i < 2; i++){
+            q->bind(p++, filter.maxLon);
+            q->bind(p++, filter.minLon);
+            q->bind(p++, filter.maxLat);
+            q->bind(p++, filter.minLat);
+        }
+    }
+    if (filter.capturedAfter > 0.0) q->bind(p++, filter.capturedAfter);
+    if (filter.capturedBefore > 0.0) q->bind(p++, filter.capturedBefore);
+
+    std::vector<DatasetSummary> result;
+    while (q->fetch()){
+        DatasetSummary s;
+        s.path = q->getText(0);
+        s.mtime = static_cast<time_t>(q->getInt64(1));
+        s.entries = static_cast<size_t>(q->getInt64(2));
+        s.images = static_cast<size_t>(q->getInt64(3));
+        s.size = static_cast<std::uintmax_t>(q->getInt64(4));
+        if (!q->isNull(5)){
+            s.minCaptureTime = q->getDouble(5);
+            s.maxCaptureTime = q->getDouble(6);
+        }
+        s.hasExtent = !q->isNull(7);
+        if (s.hasExtent){
+            s.minLon = q->getDouble(7);
+            s.minLat = q->getDouble(8);
+            s.maxLon = q->getDouble(9);
+            s.maxLat = q->getDouble(10);
+        }
+        result.push_back(s);
+    }
+
+    return result;
+}
+
+static std::string formatDate(double ms){
+    const time_t t = static_cast<time_t>(ms / 1000.0);
+    std::ostringstream os;
+    os << std::put_time(std::gmtime(&t), "%Y-%m-%d");
+    return os.str();
+}
+
+void listCatalog(Catalog &catalog, std::ostream &output, const std::string &format, const CatalogFilter &filter){
+    if (format != "text" && format != "json")
+        throw InvalidArgsException("Invalid format " + format);
+
+    const auto datasets = catalog.search(filter);
+
+    if (format == "json"){
+        json j = json::array();
+        for (const auto &d : datasets) j.push_back(d.toJSON());
+        output << j.dump();
+    }else{
+        for (const auto &d : datasets){
+            output << d.path << ": " << d.entries << " entries, " << d.images << " images, "
+                   << io::bytesToHuman(d.size);
+            if (!std::isnan(d.minCaptureTime)){
+                output << ", captured " << formatDate(d.minCaptureTime) << " - " << formatDate(d.maxCaptureTime);
+            }
+            if (d.hasExtent){
+                output << ", extent [" << std::setprecision(13) << d.minLon << ", " << d.minLat << ", "
+                       << d.maxLon << ", " << d.maxLat << "]";
+            }
+            output << std::endl;
+        }
+    }
+}
+
+}
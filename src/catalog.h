@@ -0,0 +1,76 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <cmath>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "sqlite_database.h"
+#include "json.h"
+#include "ddb_export.h"
+
+namespace ddb {
+
+// Summary of a DroneDB dataset, as stored in the catalog
+struct DatasetSummary {
+    std::string path; // Root directory of the dataset
+    time_t mtime = 0; // mtime attribute of the dataset when it was harvested
+    long long changes = 0; // Change counter of the dataset when it was harvested
+    size_t entries = 0;
+    size_t images = 0;
+    std::uintmax_t size = 0;
+
+    // Milliseconds since epoch, NaN if no entry has a capture time
+    double minCaptureTime = NAN;
+    double maxCaptureTime = NAN;
+
+    // Extent of point and polygon geometries (EPSG:4326)
+    bool hasExtent = false;
+    double minLon = 0.0, minLat = 0.0, maxLon = 0.0, maxLat = 0.0;
+
+    DDB_DLL json toJSON() const;
+};
+
+struct CatalogFilter {
+    // Datasets whose extent intersects these bounds (EPSG:4326)
+    bool hasBounds = false;
+    double minLon = 0.0, minLat = 0.0, maxLon = 0.0, maxLat = 0.0;
+
+    // Datasets with captures in this time range (milliseconds since epoch, 0 = unbounded)
+    double capturedAfter = 0.0;
+    double capturedBefore = 0.0;
+};
+
+// Called for each dataset that is added, refreshed (updated = true) or removed
+typedef std::function<void(const DatasetSummary &summary, bool updated, bool removed)> HarvestCallback;
+
+// Index of the summaries of many datasets, so that they can be searched
+// by area and capture time without opening each of them
+class Catalog {
+    SqliteDatabase db;
+
+    bool summarize(const fs::path &dataset, time_t knownMtime, long long knownChanges, DatasetSummary &summary);
+  public:
+    // Opens (or creates) a catalog. An empty file means the catalog in the user profile.
+    DDB_DLL Catalog(const std::string &file = "");
+
+    // Finds the datasets in paths (dataset roots or folders containing datasets)
+    // and stores their summaries. Datasets whose mtime attribute and change
+    // counter did not change since the last harvest are not summarized (nor
+    // opened for writing) again. Datasets that no longer exist are removed.
+    // Returns the number of datasets added, refreshed or removed.
+    DDB_DLL size_t harvest(const std::vector<std::string> &paths, const HarvestCallback &callback = nullptr);
+
+    DDB_DLL std::vector<DatasetSummary> search(const CatalogFilter &filter = CatalogFilter());
+};
+
+DDB_DLL void listCatalog(Catalog &catalog, std::ostream &output, const std::string &format = "text", const CatalogFilter &filter = CatalogFilter());
+
+}
+
+#endif // CATALOG_H
@@ -20,7 +20,10 @@ void Build::setOptions(cxxopts::Options &opts) {
         ("o,output", "Output folder", cxxopts::value<std::string>()->default_value((fs::path(DDB_FOLDER) / DDB_BUILD_PATH).generic_string()))
         ("p,path", "File to process", cxxopts::value<std::string>())
     	("w,working-dir", "Working directory", cxxopts::value<std::string>()->default_value("."))
-    	("f,force", "Force rebuild", cxxopts::value<bool>()->default_value("false"));
+    	("f,force", "Force rebuild", cxxopts::value<bool>()->default_value("false"))
+#ifdef DDB_COPC
+    	("copc", "Also build point clouds to a single COPC file", cxxopts::value<bool>()->default_value("false"))
+#endif
 ;
     // clang-format on
     opts.parse_positional({"path"});
@@ -37,6 +40,11 @@ void Build::run(cxxopts::ParseResult &opts) {
         const auto output = opts["output"].as<std::string>();
         const auto ddbPath = opts["working-dir"].as<std::string>();
         const auto force = opts["force"].as<bool>();
+#ifdef DDB_COPC
+        const auto copc = opts["copc"].as<bool>();
+#else
+        const bool copc = false;
+#endif
 
         if (output.length() == 0)
             printHelp();
@@ -44,10 +52,10 @@ void Build::run(cxxopts::ParseResult &opts) {
         const auto db = ddb::open(ddbPath, true);
         
         if (!opts.count("path")) {
-            build_all(db.get(), output, std::cout, force);
+            build_all(db.get(), output, std::cout, force, copc);
         } else {
             const auto path = opts["path"].as<std::string>();
-            build(db.get(), path, output, std::cout, force);
+            build(db.get(), path, output, std::cout, force, copc);
         }
 
     } catch (ddb::InvalidArgsException) {
@@ -0,0 +1,66 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <iostream>
+#include "catalog.h"
+#include "list.h"
+#include "../catalog.h"
+#include "exceptions.h"
+
+namespace cmd {
+
+void Catalog::setOptions(cxxopts::Options &opts) {
+    // clang-format off
+    opts
+    .positional_help("[args] [PATHS]")
+    .custom_help("catalog /data/datasets --bbox 11.0,46.0,11.5,46.5")
+    .add_options()
+    ("p,paths", "Datasets, or folders containing datasets, to add to (or refresh in) the catalog", cxxopts::value<std::vector<std::string>>())
+    ("c,catalog", "Catalog file (defaults to the one in the user profile)", cxxopts::value<std::string>()->default_value(""))
+    ("f,format", "Output format (text|json)", cxxopts::value<std::string>()->default_value("text"))
+    ("bbox", "Only list datasets intersecting these bounds (minLon,minLat,maxLon,maxLat)", cxxopts::value<std::vector<double>>())
+    ("captured-after", "Only list datasets with captures at or after this UTC date (YYYY-MM-DD[THH:MM:SS] or milliseconds since epoch)", cxxopts::value<std::string>())
+    ("captured-before", "Only list datasets with captures at or before this UTC date (YYYY-MM-DD[THH:MM:SS] or milliseconds since epoch)", cxxopts::value<std::string>());
+    // clang-format on
+    opts.parse_positional({"paths"});
+}
+
+std::string Catalog::description() {
+    return "Summarize many datasets into a catalog and search them by area and capture time";
+}
+
+void Catalog::run(cxxopts::ParseResult &opts) {
+    try {
+        const auto format = opts["format"].as<std::string>();
+
+        ddb::CatalogFilter filter;
+        if (opts.count("bbox")) {
+            const auto bbox = opts["bbox"].as<std::vector<double>>();
+            if (bbox.size() != 4) throw ddb::InvalidArgsException("Invalid bounds");
+            filter.hasBounds = true;
+            filter.minLon = bbox[0];
+            filter.minLat = bbox[1];
+            filter.maxLon = bbox[2];
+            filter.maxLat = bbox[3];
+        }
+        if (opts.count("captured-after")) filter.capturedAfter = parseCaptureDate(opts["captured-after"].as<std::string>());
+        if (opts.count("captured-before")) filter.capturedBefore = parseCaptureDate(opts["captured-before"].as<std::string>());
+
+        ddb::Catalog catalog(opts["catalog"].as<std::string>());
+
+        if (opts.count("paths")) {
+            catalog.harvest(opts["paths"].as<std::vector<std::string>>(),
+                            [&format](const ddb::DatasetSummary &s, bool updated, bool removed) {
+                                if (format == "text") std::cerr << (removed ? "D\t" : updated ? "U\t" : "A\t") << s.path << std::endl;
+                            });
+        }
+
+        ddb::listCatalog(catalog, std::cout, format, filter);
+        if (format != "text") std::cout << std::endl;
+    } catch (ddb::InvalidArgsException) {
+        printHelp();
+    }
+}
+
+}
@@ -25,8 +25,17 @@
 #include "clone.h"
 #include "tag.h"
 #include "ept.h"
+#ifdef DDB_COPC
+#include "copc.h"
+#endif
 #include "push.h"
 #include "pull.h"
+#include "stats.h"
+#include "search.h"
+#include "optimize.h"
+#include "export.h"
+#include "flights.h"
+#include "catalog.h"
 
 namespace cmd {
 
@@ -53,8 +62,17 @@ namespace cmd {
       {"clone", new Clone()},
       {"tag", new Tag()},
       {"ept", new Ept()},
+#ifdef DDB_COPC
+      {"copc", new Copc()},
+#endif
       {"push", new Push()},
-      {"pull", new Pull()}
+      {"pull", new Pull()},
+      {"stats", new Stats()},
+      {"search", new Search()},
+      {"optimize", new Optimize()},
+      {"export", new Export()},
+      {"flights", new Flights()},
+      {"catalog", new Catalog()}
   };
 
   std::map<std::string, std::string> aliases = {
@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <iostream>
+#include "export.h"
+#include "../export.h"
+#include "dbops.h"
+#include "exceptions.h"
+
+namespace cmd {
+
+void Export::setOptions(cxxopts::Options &opts) {
+    // clang-format off
+    opts
+    .positional_help("[args]")
+    .custom_help("export entries.fgb")
+    .add_options()
+    ("o,output", "Output file", cxxopts::value<std::string>())
+    ("f,format", "Output format (auto|fgb|parquet)", cxxopts::value<std::string>()->default_value("auto"))
+    ("geometry", "Geometry to output (auto|point|polygon)", cxxopts::value<std::string>()->default_value("auto"))
+    ("w,working-dir", "Working directory", cxxopts::value<std::string>()->default_value("."));
+    // clang-format on
+    opts.parse_positional({"output"});
+}
+
+std::string Export::description() {
+    return "Export the geometries and metadata of indexed files to FlatGeobuf or GeoParquet";
+}
+
+void Export::run(cxxopts::ParseResult &opts) {
+    if (!opts.count("output")) {
+        printHelp();
+    }
+
+    try{
+        const auto output = opts["output"].as<std::string>();
+        const auto format = opts["format"].as<std::string>();
+        const auto geometry = opts["geometry"].as<std::string>();
+        const auto ddbPath = opts["working-dir"].as<std::string>();
+
+        const auto db = ddb::open(ddbPath, true);
+        const auto count = ddb::exportEntries(db.get(), output, format, geometry);
+        std::cout << "Exported " << count << " entries to " << output << std::endl;
+    }catch(ddb::InvalidArgsException){
+        printHelp();
+    }
+}
+
+}
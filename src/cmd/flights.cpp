@@ -0,0 +1,52 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <iostream>
+#include "flights.h"
+#include "../flights.h"
+#include "dbops.h"
+#include "exceptions.h"
+
+namespace cmd {
+
+void Flights::setOptions(cxxopts::Options &opts) {
+    // clang-format off
+    opts
+    .positional_help("[args]")
+    .custom_help("flights [directory]")
+    .add_options()
+    ("w,working-dir", "Working directory", cxxopts::value<std::string>()->default_value("."))
+    ("f,format", "Output format (text|json|geojson)", cxxopts::value<std::string>()->default_value("text"))
+    ("max-gap", "Start a new flight when images are taken more than this many seconds apart", cxxopts::value<double>()->default_value("120"))
+    ("max-distance", "Start a new flight when images are taken more than this many meters apart", cxxopts::value<double>()->default_value("300"))
+    ("max-turn", "Start a new strip when the heading changes by more than this many degrees", cxxopts::value<double>()->default_value("45"))
+    ("no-update", "Do not cluster the images, list the flights as currently stored in the index");
+    // clang-format on
+    opts.parse_positional({"working-dir"});
+}
+
+std::string Flights::description() {
+    return "Group images into flights and strips by capture time and location";
+}
+
+void Flights::run(cxxopts::ParseResult &opts) {
+    try {
+        const auto workingDir = opts["working-dir"].as<std::string>();
+        const auto format = opts["format"].as<std::string>();
+
+        ddb::FlightOptions options;
+        options.maxTimeGap = opts["max-gap"].as<double>();
+        options.maxDistance = opts["max-distance"].as<double>();
+        options.maxTurn = opts["max-turn"].as<double>();
+
+        const auto db = ddb::open(workingDir, true);
+
+        ddb::listFlights(db.get(), std::cout, format, !opts.count("no-update"), options);
+        if (format != "text") std::cout << std::endl;
+    } catch (ddb::InvalidArgsException) {
+        printHelp();
+    }
+}
+
+}
@@ -19,10 +19,10 @@ void Info::setOptions(cxxopts::Options &opts) {
     .add_options()
     ("i,input", "File(s) to examine", cxxopts::value<std::vector<std::string>>())
     ("o,output", "Output file to write results to", cxxopts::value<std::string>()->default_value("stdout"))
-    ("f,format", "Output format (text|json|geojson)", cxxopts::value<std::string>()->default_value("text"))
+    ("f,format", "Output format (text|json|geojson|fgb)", cxxopts::value<std::string>()->default_value("text"))
     ("r,recursive", "Recursively search in subdirectories", cxxopts::value<bool>())
     ("d,depth", "Max recursion depth", cxxopts::value<int>()->default_value("0"))
-    ("geometry", "Geometry to output (for geojson format only) (auto|point|polygon)", cxxopts::value<std::string>()->default_value("auto"))
+    ("geometry", "Geometry to output (for geojson and fgb formats only) (auto|point|polygon)", cxxopts::value<std::string>()->default_value("auto"))
     ("with-hash", "Compute SHA256 hashes", cxxopts::value<bool>());
     // clang-format on
     opts.parse_positional({"input"});
@@ -14,6 +14,7 @@
 
 #include "exceptions.h"
 #include "basicgeometry.h"
+#include "timezone.h"
 
 namespace cmd {
 
@@ -28,11 +29,49 @@ namespace cmd {
 			("w,working-dir", "Working directory", cxxopts::value<std::string>()->default_value("."))
 			("r,recursive", "Recursively search in subdirectories", cxxopts::value<bool>())
 			("d,depth", "Max recursion depth", cxxopts::value<int>()->default_value("0"))
-			("f,format", "Output format (text|json)", cxxopts::value<std::string>()->default_value("text"));
+			("f,format", "Output format (text|json)", cxxopts::value<std::string>()->default_value("text"))
+			("captured-after", "Only list files captured at or after this UTC date (YYYY-MM-DD[THH:MM:SS] or milliseconds since epoch)", cxxopts::value<std::string>())
+			("captured-before", "Only list files captured at or before this UTC date (YYYY-MM-DD[THH:MM:SS] or milliseconds since epoch)", cxxopts::value<std::string>())
+			("camera", "Only list files taken with this camera (make, model or \"make model\")", cxxopts::value<std::string>())
+			("flight", "Only list images of this flight (see the flights command)", cxxopts::value<int>());
         // clang-format on
 		opts.parse_positional({ "input" });
 	}
 
+	// Parses a UTC date (YYYY-MM-DD[THH:MM:SS]) or a number
+	// of milliseconds since epoch
+	double parseCaptureDate(const std::string& str) {
+		int year, month, day, hour = 0, minute = 0, second = 0;
+		int dateLen = 0, timeLen = 0;
+		const char* s = str.c_str();
+
+		// The whole string must match, with '-' between the date fields
+		// and 'T' or ' ' before the (optional) time
+		if (sscanf(s, "%4d-%2d-%2d%n", &year, &month, &day, &dateLen) == 3 && dateLen > 0) {
+			const char sep = s[dateLen];
+			const bool valid = sep == '\0' ||
+				((sep == 'T' || sep == ' ') &&
+				 sscanf(s + dateLen + 1, "%2d:%2d:%2d%n", &hour, &minute, &second, &timeLen) == 3 &&
+				 timeLen > 0 && s[dateLen + 1 + timeLen] == '\0');
+
+			if (valid && month >= 1 && month <= 12 && day >= 1 && day <= 31 &&
+				hour >= 0 && hour < 24 && minute >= 0 && minute < 60 && second >= 0 && second < 60)
+				return Timezone::getUTCEpoch(year, month, day, hour, minute, second, 0, cctz::utc_time_zone());
+
+			throw ddb::InvalidArgsException("Invalid date: " + str);
+		}
+
+		try {
+			size_t pos;
+			const double ms = std::stod(str, &pos);
+			if (pos == str.length() && ms > 0) return ms;
+		}
+		catch (const std::logic_error&) {
+		}
+
+		throw ddb::InvalidArgsException("Invalid date: " + str);
+	}
+
 	std::string List::description() {
 		return "List indexed files and directories";
 	}
@@ -50,6 +89,12 @@ namespace cmd {
 			// Take into consideration maxRecursionDepth only if the recursive flag is set and the option exists
 			const auto maxRecursionDepth = recursive ? ( depthOpt.count() > 0 ? depthOpt.as<int>() : 0) : 0;
 			
+			ddb::MetaFilter filter;
+			if (opts.count("captured-after")) filter.capturedAfter = parseCaptureDate(opts["captured-after"].as<std::string>());
+			if (opts.count("captured-before")) filter.capturedBefore = parseCaptureDate(opts["captured-before"].as<std::string>());
+			if (opts.count("camera")) filter.camera = opts["camera"].as<std::string>();
+			if (opts.count("flight")) filter.flight = opts["flight"].as<int>();
+
 			const auto db = ddb::open(std::string(ddbPath), true);
 
 			if (opts.count("output")) {
@@ -57,12 +102,12 @@ namespace cmd {
 				std::ofstream file(filename, std::ios::out | std::ios::trunc | std::ios::binary);
 				if (!file.is_open()) throw ddb::FSException("Cannot open " + filename);
 
-				listIndex(db.get(), paths, file, format, recursive, maxRecursionDepth);
+				listIndex(db.get(), paths, file, format, recursive, maxRecursionDepth, filter);
 
 				file.close();
 			}
 			else {
-				listIndex(db.get(), paths, std::cout, format, recursive, maxRecursionDepth);
+				listIndex(db.get(), paths, std::cout, format, recursive, maxRecursionDepth, filter);
 			}
 
 		}
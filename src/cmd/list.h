@@ -18,6 +18,10 @@ class List : public Command {
     virtual std::string description() override;
 };
 
+// Parses a UTC date (YYYY-MM-DD[THH:MM:SS]) or a number
+// of milliseconds since epoch
+double parseCaptureDate(const std::string &str);
+
 }
 
 #endif // LIST_CMD_H
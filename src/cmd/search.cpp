@@ -0,0 +1,56 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <iostream>
+#include "search.h"
+#include "../search.h"
+#include "dbops.h"
+#include "exceptions.h"
+
+namespace cmd {
+
+void Search::setOptions(cxxopts::Options &opts) {
+    // clang-format off
+    opts
+    .positional_help("[args]")
+    .custom_help("search DJI_00")
+    .add_options()
+    ("q,query", "Text to search for in paths and camera names", cxxopts::value<std::vector<std::string>>())
+    ("w,working-dir", "Working directory", cxxopts::value<std::string>()->default_value("."))
+    ("l,limit", "Maximum number of results (0 for all)", cxxopts::value<int>()->default_value("100"))
+    ("offset", "Number of results to skip", cxxopts::value<int>()->default_value("0"))
+    ("f,format", "Output format (text|json)", cxxopts::value<std::string>()->default_value("text"));
+    // clang-format on
+    opts.parse_positional({"query"});
+}
+
+std::string Search::description() {
+    return "Search indexed files by path or camera name";
+}
+
+void Search::run(cxxopts::ParseResult &opts) {
+    if (!opts.count("query")) {
+        printHelp();
+    }
+
+    try {
+        const auto terms = opts["query"].as<std::vector<std::string>>();
+        const auto ddbPath = opts["working-dir"].as<std::string>();
+        const auto format = opts["format"].as<std::string>();
+        const auto limit = opts["limit"].as<int>();
+        const auto offset = opts["offset"].as<int>();
+
+        std::string query;
+        for (const auto &t : terms) query += (query.empty() ? "" : " ") + t;
+
+        const auto db = ddb::open(ddbPath, true);
+
+        ddb::searchIndex(db.get(), query, std::cout, format, limit, offset);
+        if (format == "json") std::cout << std::endl;
+    } catch (ddb::InvalidArgsException) {
+        printHelp();
+    }
+}
+
+}
@@ -3,7 +3,9 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include <iostream>
+#include <map>
 #include "setexif.h"
+#include "dbops.h"
 #include "exifeditor.h"
 #include "exceptions.h"
 
@@ -47,6 +49,9 @@ void SetExif::run(cxxopts::ParseResult &opts) {
         exit(EXIT_FAILURE);
     }
 
+    // Each file is written once with all the changes
+    exifEditor.beginBatch();
+
     if (opts.count("gps-alt")){
         exifEditor.SetGPSAltitude(opts["gps-alt"].as<double>());
     }
@@ -63,6 +68,37 @@ void SetExif::run(cxxopts::ParseResult &opts) {
         auto gps = opts["gps"].as<std::vector<double>>();
         exifEditor.SetGPS(gps[0], gps[1], gps[2]);
     }
+
+    const auto modified = exifEditor.commit();
+
+    // Refresh the entries of modified files that are part of an index,
+    // with one transaction per index
+    std::map<std::string, std::unique_ptr<ddb::Database>> dbs;
+    std::map<std::string, std::string> roots; // Directory --> index root ("" if none)
+    std::map<std::string, std::vector<std::string>> indexed;
+    for (const auto &f : modified){
+        const auto dir = fs::absolute(f).parent_path().string();
+        if (roots.find(dir) == roots.end()){
+            try{
+                auto db = ddb::open(dir, true);
+                const auto root = ddb::rootDirectory(db.get()).string();
+                if (dbs.find(root) == dbs.end()) dbs[root] = std::move(db);
+                roots[dir] = root;
+            }catch(const ddb::FSException &){
+                roots[dir] = ""; // Not in an index
+            }
+        }
+
+        const auto &root = roots[dir];
+        if (!root.empty()) indexed[root].push_back(f.string());
+    }
+
+    for (auto &it : indexed){
+        ddb::updateIndex(dbs[it.first].get(), it.second, [](const ddb::Entry &e, bool){
+            std::cout << "U\t" << e.path << std::endl;
+            return true;
+        });
+    }
 }
 
 }
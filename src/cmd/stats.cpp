@@ -0,0 +1,43 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <iostream>
+#include "stats.h"
+#include "../snapshot.h"
+#include "dbops.h"
+#include "exceptions.h"
+
+namespace cmd {
+
+void Stats::setOptions(cxxopts::Options &opts) {
+    // clang-format off
+    opts
+    .positional_help("[args]")
+    .custom_help("stats [directory]")
+    .add_options()
+    ("w,working-dir", "Working directory", cxxopts::value<std::string>()->default_value("."))
+    ("f,format", "Output format (text|json)", cxxopts::value<std::string>()->default_value("text"));
+    // clang-format on
+    opts.parse_positional({"working-dir"});
+}
+
+std::string Stats::description() {
+    return "Show aggregate statistics (types, sizes, capture times, cameras, extent) of the index";
+}
+
+void Stats::run(cxxopts::ParseResult &opts) {
+    try {
+        const auto workingDir = opts["working-dir"].as<std::string>();
+        const auto format = opts["format"].as<std::string>();
+
+        const auto db = ddb::open(workingDir, true);
+
+        ddb::stats(db.get(), std::cout, format);
+        std::cout << std::endl;
+    } catch (ddb::InvalidArgsException) {
+        printHelp();
+    }
+}
+
+}
@@ -16,7 +16,15 @@ namespace ddb {
 void Database::Initialize() { spatialite_init(0); }
 
 void Database::afterOpen() {
-    this->setJournalMode("wal");
+    // Read only connections use the database as it is
+    if (sqlite3_db_readonly(db, "main") != 1) {
+        // Let free pages be reclaimed without a full VACUUM (see optimize).
+        // This only takes effect on a new database, before the journal
+        // mode is written and before the first table is created
+        if (pragmaValue("page_count") == 0) this->exec("PRAGMA auto_vacuum = INCREMENTAL;");
+
+        this->setJournalMode("wal");
+    }
 
     // If table is locked, sleep up to 30 seconds
     if (sqlite3_busy_timeout(db, 30000) != SQLITE_OK) {
@@ -41,6 +49,122 @@ const char *entriesTableDdl = R"<<<(
   SELECT AddGeometryColumn("entries", "polygon_geom", 4326, "POLYGONZ", "XYZ");
 )<<<";
 
+// Frequently queried meta fields, exposed as virtual generated columns
+// so that they can be indexed and filtered without parsing meta.
+// Generated columns need SQLite 3.31.
+#define SQLITE_GENERATED_COLUMNS_VERSION 3031000
+
+struct MetaColumn {
+    const char *name;
+    const char *type;
+    const char *key;
+};
+
+const MetaColumn metaColumns[] = {
+    {"capture_time", "REAL", "captureTime"},
+    {"make", "TEXT", "make"},
+    {"model", "TEXT", "model"},
+    {"width", "INTEGER", "width"},
+    {"height", "INTEGER", "height"},
+    {"point_count", "INTEGER", "pointCount"},
+
+    // Flight and strip of GeoImages, assigned by clusterFlights
+    {"flight", "INTEGER", "flight"},
+    {"strip", "INTEGER", "strip"}
+};
+
+const char *metaIndexesDdl = R"<<<(
+  CREATE INDEX IF NOT EXISTS ix_entries_capture_time ON entries (capture_time);
+  CREATE INDEX IF NOT EXISTS ix_entries_make ON entries (make);
+  CREATE INDEX IF NOT EXISTS ix_entries_model ON entries (model);
+  CREATE INDEX IF NOT EXISTS ix_entries_flight ON entries (flight);
+)<<<";
+
+static std::string metaExpression(const MetaColumn &c) {
+    return std::string("(CASE WHEN json_valid(meta) THEN json_extract(meta, '$.") + c.key + "') END)";
+}
+
+// Full text index over paths and camera strings.
+// It is kept in sync with entries by triggers and shares its rowids.
+// The trigram tokenizer matches any substring, but needs SQLite 3.34;
+// with older versions words are indexed and matched by prefix.
+#define SQLITE_TRIGRAM_VERSION 3034000
+const char *searchTableTrigramDdl = "CREATE VIRTUAL TABLE IF NOT EXISTS entries_fts USING fts5(path, camera, tokenize = 'trigram');";
+const char *searchTableWordsDdl = "CREATE VIRTUAL TABLE IF NOT EXISTS entries_fts USING fts5(path, camera, tokenize = 'unicode61');";
+const char *searchIndexDdl = R"<<<(
+  INSERT INTO entries_fts(rowid, path, camera) SELECT rowid, path, trim(coalesce(make, '') || ' ' || coalesce(model, '')) FROM entries;
+
+  CREATE TRIGGER IF NOT EXISTS entries_fts_insert AFTER INSERT ON entries BEGIN
+    INSERT INTO entries_fts(rowid, path, camera) VALUES (new.rowid, new.path, trim(coalesce(new.make, '') || ' ' || coalesce(new.model, '')));
+  END;
+  CREATE TRIGGER IF NOT EXISTS entries_fts_delete AFTER DELETE ON entries BEGIN
+    DELETE FROM entries_fts WHERE rowid = old.rowid;
+  END;
+  CREATE TRIGGER IF NOT EXISTS entries_fts_update AFTER UPDATE OF path, meta ON entries BEGIN
+    UPDATE entries_fts SET path = new.path, camera = trim(coalesce(new.make, '') || ' ' || coalesce(new.model, '')) WHERE rowid = old.rowid;
+  END;
+)<<<";
+
+// Running aggregates of entries, kept in the attributes table by triggers
+// so that they can be read without scanning entries (e.g. for nested
+// datasets). Sizes and counts are exact; the extent can only grow
+// incrementally, so removing or changing a geometry marks it as dirty
+// and it's recomputed the next time it's read.
+const char *statsTriggersDdl = R"<<<(
+  DROP TRIGGER IF EXISTS entries_stats_insert;
+  DROP TRIGGER IF EXISTS entries_stats_delete;
+  DROP TRIGGER IF EXISTS entries_stats_update;
+  DROP TRIGGER IF EXISTS entries_changes_update;
+  CREATE TRIGGER entries_stats_insert AFTER INSERT ON entries BEGIN
+    INSERT INTO attributes (name, ivalue) VALUES ('stats_size', COALESCE(new.size, 0)), ('stats_count_' || new.type, 1), ('stats_changes', 1)
+      ON CONFLICT(name) DO UPDATE SET ivalue = COALESCE(ivalue, 0) + excluded.ivalue;
+    INSERT INTO attributes (name, rvalue) SELECT 'stats_min_x', MbrMinX(COALESCE(new.polygon_geom, new.point_geom))
+      WHERE COALESCE(new.polygon_geom, new.point_geom) IS NOT NULL AND NOT EXISTS (SELECT 1 FROM attributes WHERE name = 'stats_extent_dirty')
+      ON CONFLICT(name) DO UPDATE SET rvalue = MIN(rvalue, excluded.rvalue);
+    INSERT INTO attributes (name, rvalue) SELECT 'stats_min_y', MbrMinY(COALESCE(new.polygon_geom, new.point_geom))
+      WHERE COALESCE(new.polygon_geom, new.point_geom) IS NOT NULL AND NOT EXISTS (SELECT 1 FROM attributes WHERE name = 'stats_extent_dirty')
+      ON CONFLICT(name) DO UPDATE SET rvalue = MIN(rvalue, excluded.rvalue);
+    INSERT INTO attributes (name, rvalue) SELECT 'stats_max_x', MbrMaxX(COALESCE(new.polygon_geom, new.point_geom))
+      WHERE COALESCE(new.polygon_geom, new.point_geom) IS NOT NULL AND NOT EXISTS (SELECT 1 FROM attributes WHERE name = 'stats_extent_dirty')
+      ON CONFLICT(name) DO UPDATE SET rvalue = MAX(rvalue, excluded.rvalue);
+    INSERT INTO attributes (name, rvalue) SELECT 'stats_max_y', MbrMaxY(COALESCE(new.polygon_geom, new.point_geom))
+      WHERE COALESCE(new.polygon_geom, new.point_geom) IS NOT NULL AND NOT EXISTS (SELECT 1 FROM attributes WHERE name = 'stats_extent_dirty')
+      ON CONFLICT(name) DO UPDATE SET rvalue = MAX(rvalue, excluded.rvalue);
+  END;
+  CREATE TRIGGER entries_stats_delete AFTER DELETE ON entries BEGIN
+    UPDATE attributes SET ivalue = ivalue - COALESCE(old.size, 0) WHERE name = 'stats_size';
+    INSERT INTO attributes (name, ivalue) VALUES ('stats_changes', 1)
+      ON CONFLICT(name) DO UPDATE SET ivalue = COALESCE(ivalue, 0) + 1;
+    UPDATE attributes SET ivalue = ivalue - 1 WHERE name = 'stats_count_' || old.type;
+    INSERT OR REPLACE INTO attributes (name, ivalue) SELECT 'stats_extent_dirty', 1
+      WHERE old.point_geom IS NOT NULL OR old.polygon_geom IS NOT NULL;
+  END;
+  CREATE TRIGGER entries_stats_update AFTER UPDATE OF size, type, point_geom, polygon_geom ON entries BEGIN
+    UPDATE attributes SET ivalue = ivalue - COALESCE(old.size, 0) + COALESCE(new.size, 0) WHERE name = 'stats_size';
+    UPDATE attributes SET ivalue = ivalue - 1 WHERE name = 'stats_count_' || old.type;
+    INSERT INTO attributes (name, ivalue) VALUES ('stats_count_' || new.type, 1)
+      ON CONFLICT(name) DO UPDATE SET ivalue = COALESCE(ivalue, 0) + 1;
+    INSERT OR REPLACE INTO attributes (name, ivalue) SELECT 'stats_extent_dirty', 1
+      WHERE old.point_geom IS NOT new.point_geom OR old.polygon_geom IS NOT new.polygon_geom;
+  END;
+  CREATE TRIGGER entries_changes_update AFTER UPDATE ON entries BEGIN
+    INSERT INTO attributes (name, ivalue) VALUES ('stats_changes', 1)
+      ON CONFLICT(name) DO UPDATE SET ivalue = COALESCE(ivalue, 0) + 1;
+  END;
+)<<<";
+
+// Computes the aggregates from scratch (the extent is computed when first read).
+// stats_changes only ever grows: it tells readers (see Catalog) that the
+// entries changed, even within the one second resolution of mtime
+const char *statsRebuildSql = R"<<<(
+  DELETE FROM attributes WHERE name LIKE 'stats\_%' ESCAPE '\' AND name <> 'stats_changes';
+  INSERT INTO attributes (name, ivalue) VALUES ('stats_changes', 1)
+    ON CONFLICT(name) DO UPDATE SET ivalue = COALESCE(ivalue, 0) + 1;
+  INSERT INTO attributes (name, ivalue) SELECT 'stats_size', COALESCE(SUM(size), 0) FROM entries;
+  INSERT INTO attributes (name, ivalue) SELECT 'stats_count_' || type, COUNT(*) FROM entries GROUP BY type;
+  INSERT INTO attributes (name, ivalue) VALUES ('stats_extent_dirty', 1);
+)<<<";
+
 const char *passwordsTableDdl = R"<<<(
   CREATE TABLE IF NOT EXISTS passwords (
       salt TEXT,
@@ -65,6 +189,13 @@ Database &Database::createTables() {
 
     LOGD << "About to create tables...";
     this->exec(sql);
+    this->addMetaColumns();
+
+    // The search index is built from the make/model columns
+    if (this->hasMetaColumns()) this->createSearchIndex();
+    this->exec(statsTriggersDdl);
+    this->exec(statsRebuildSql);
+    this->updateStatsExtent();
     LOGD << "Created tables";
 
     return *this;
@@ -80,6 +211,19 @@ DDB_DLL void Database::ensureSchemaConsistency() {
         LOGD << "Entries table created";
     }
 
+    if (!this->hasMetaColumns()) {
+        LOGD << "Meta columns do not exist, creating them";
+        this->addMetaColumns();
+    } else if (!this->hasMetaIndexes()) {
+        LOGD << "Meta indexes do not exist, creating them";
+        this->exec(metaIndexesDdl);
+    }
+
+    if (!this->hasSearchIndex() && this->hasMetaColumns()) {
+        LOGD << "Search index does not exist, creating it";
+        this->createSearchIndex();
+    }
+
     if (!this->tableExists("passwords")) {
         LOGD << "Passwords table does not exist, creating it";
         this->exec(passwordsTableDdl);
@@ -91,6 +235,301 @@ DDB_DLL void Database::ensureSchemaConsistency() {
         this->exec(attributesTableDdl);
         LOGD << "Attributes table created";
     }
+
+    if (!this->hasStatsTriggers()) {
+        LOGD << "Stats triggers do not exist, creating them";
+        this->exec(statsTriggersDdl);
+        this->exec(statsRebuildSql);
+        this->updateStatsExtent();
+        LOGD << "Stats triggers created";
+    }
+}
+
+bool Database::supportsGeneratedColumns() {
+    return sqlite3_libversion_number() >= SQLITE_GENERATED_COLUMNS_VERSION;
+}
+
+bool Database::hasMetaColumns() {
+    for (const auto &c : metaColumns) {
+        if (!this->columnExists("entries", c.name)) return false;
+    }
+    return true;
+}
+
+bool Database::hasMetaIndexes() {
+    auto q = query("SELECT count(*) FROM sqlite_master WHERE type='index' AND name IN "
+                   "('ix_entries_capture_time', 'ix_entries_make', 'ix_entries_model', 'ix_entries_flight')");
+    return q->fetch() && q->getInt(0) == 4;
+}
+
+bool Database::addMetaColumns() {
+    if (!supportsGeneratedColumns()) {
+        LOGD << "SQLite " << sqlite3_libversion() << " has no generated columns (3.31 or later is required), "
+                "meta filters will parse meta";
+        return false;
+    }
+
+    // All or nothing, a failure must not leave only some of the columns behind.
+    // A savepoint also works within the callers' transactions.
+    this->exec("SAVEPOINT meta_columns");
+    try {
+        for (const auto &c : metaColumns) {
+            if (this->columnExists("entries", c.name)) continue;
+
+            LOGD << "Adding " << c.name << " column";
+            this->exec(std::string("ALTER TABLE entries ADD COLUMN ") + c.name + " " + c.type +
+                       " GENERATED ALWAYS AS " + metaExpression(c) + " VIRTUAL");
+        }
+        this->exec(metaIndexesDdl);
+        this->exec("RELEASE meta_columns");
+    } catch (const SQLException &e) {
+        this->exec("ROLLBACK TO meta_columns; RELEASE meta_columns");
+        LOGW << "Cannot add meta columns, meta filters will parse meta: " << e.what();
+        return false;
+    }
+
+    return true;
+}
+
+std::string Database::metaColumn(const std::string &name) {
+    for (const auto &c : metaColumns) {
+        if (name != c.name) continue;
+        return this->columnExists("entries", c.name) ? name : metaExpression(c);
+    }
+
+    throw InvalidArgsException("Unknown meta column " + name);
+}
+
+bool Database::hasStatsTriggers() const {
+    auto q = query("SELECT count(*) FROM sqlite_master WHERE type='trigger' AND name IN "
+                   "('entries_stats_insert', 'entries_stats_delete', 'entries_stats_update', 'entries_changes_update')");
+    return q->fetch() && q->getInt(0) == 4;
+}
+
+IndexStats Database::getStats() const {
+    // Indexes that were not migrated yet (e.g. opened read only)
+    // have no aggregates to read
+    if (!this->hasStatsTriggers()) return computeStats();
+
+    IndexStats stats;
+    bool extentDirty = false;
+
+    // All aggregates are small rows in the attributes table
+    auto q = this->query("SELECT name, ivalue, rvalue FROM attributes WHERE name LIKE 'stats\\_%' ESCAPE '\\'");
+    while (q->fetch()) {
+        const std::string name = q->getText(0);
+        if (name == "stats_size") stats.size = static_cast<std::uintmax_t>(q->getInt64(1));
+        else if (name == "stats_extent_dirty") extentDirty = true;
+        else if (name == "stats_min_x") stats.minX = q->getDouble(2);
+        else if (name == "stats_min_y") stats.minY = q->getDouble(2);
+        else if (name == "stats_max_x") stats.maxX = q->getDouble(2);
+        else if (name == "stats_max_y") stats.maxY = q->getDouble(2);
+        else if (name.rfind("stats_count_", 0) == 0) {
+            const long long count = q->getInt64(1);
+            if (count <= 0) continue;
+            stats.countByType[std::atoi(name.c_str() + 12)] = static_cast<size_t>(count);
+            stats.entries += static_cast<size_t>(count);
+        }
+    }
+
+    // Read only: the recomputed extent is saved by updateStatsExtent
+    if (extentDirty) computeExtent(stats);
+
+    return stats;
+}
+
+IndexStats Database::computeStats() const {
+    LOGD << "Computing stats from entries";
+    IndexStats stats;
+
+    auto q = this->query("SELECT type, COUNT(*), COALESCE(SUM(size), 0) FROM entries GROUP BY type");
+    while (q->fetch()) {
+        const auto count = static_cast<size_t>(q->getInt64(1));
+        stats.countByType[q->getInt(0)] = count;
+        stats.entries += count;
+        stats.size += static_cast<std::uintmax_t>(q->getInt64(2));
+    }
+
+    computeExtent(stats);
+    return stats;
+}
+
+void Database::computeExtent(IndexStats &stats) const {
+    LOGD << "Recomputing extent";
+    stats.minX = stats.minY = stats.maxX = stats.maxY = NAN;
+
+    auto q = this->query("SELECT MIN(MbrMinX(g)), MIN(MbrMinY(g)), MAX(MbrMaxX(g)), MAX(MbrMaxY(g)) "
+                         "FROM (SELECT COALESCE(polygon_geom, point_geom) AS g FROM entries)");
+    if (q->fetch() && !q->isNull(0)) {
+        stats.minX = q->getDouble(0);
+        stats.minY = q->getDouble(1);
+        stats.maxX = q->getDouble(2);
+        stats.maxY = q->getDouble(3);
+    }
+}
+
+void Database::updateStatsExtent() {
+    if (!this->hasAttribute("stats_extent_dirty")) return;
+
+    IndexStats stats;
+    computeExtent(stats);
+
+    this->exec("DELETE FROM attributes WHERE name IN ('stats_extent_dirty', 'stats_min_x', 'stats_min_y', 'stats_max_x', 'stats_max_y')");
+    if (stats.hasExtent()) {
+        const auto insertQ = this->query("INSERT INTO attributes (name, rvalue) VALUES ('stats_min_x', ?), ('stats_min_y', ?), ('stats_max_x', ?), ('stats_max_y', ?)");
+        insertQ->bind(1, stats.minX);
+        insertQ->bind(2, stats.minY);
+        insertQ->bind(3, stats.maxX);
+        insertQ->bind(4, stats.maxY);
+        insertQ->execute();
+    }
+}
+
+bool Database::supportsTrigramSearch() {
+    return sqlite3_libversion_number() >= SQLITE_TRIGRAM_VERSION;
+}
+
+bool Database::createSearchIndex(bool substrings) {
+    if (!substrings) {
+        LOGW << "SQLite " << sqlite3_libversion() << " has no trigram tokenizer (3.34 or later is required), "
+                "search will match the beginning of words only";
+    }
+
+    // FTS5 might not be compiled in, in which case
+    // search falls back to scanning entries
+    try {
+        this->exec(std::string(substrings ? searchTableTrigramDdl : searchTableWordsDdl) + searchIndexDdl);
+        return true;
+    } catch (const SQLException &e) {
+        LOGW << "Cannot create search index, search will scan all entries: " << e.what();
+        return false;
+    }
+}
+
+bool Database::hasSearchIndex() {
+    return this->tableExists("entries_fts");
+}
+
+bool Database::hasTrigramSearchIndex() {
+    auto q = query("SELECT count(*) FROM sqlite_master WHERE type='table' AND name='entries_fts' AND sql LIKE '%trigram%'");
+    return q->fetch() && q->getInt(0) == 1;
+}
+
+void Database::rebuildSearchIndex() {
+    if (!this->hasSearchIndex()) throw DBException("Search index is not available");
+
+    // Rowids can change after a full VACUUM (entries has no INTEGER PRIMARY KEY)
+    this->exec("DELETE FROM entries_fts; "
+               "INSERT INTO entries_fts(rowid, path, camera) SELECT rowid, path, trim(coalesce(make, '') || ' ' || coalesce(model, '')) FROM entries;");
+}
+
+void Database::compactCopy(const fs::path &dest) {
+    LOGD << "Writing compact copy of " << openFile << " to " << dest;
+
+    // VACUUM INTO writes a defragmented, self-contained copy
+    // (WAL contents included, no WAL file) but fails if dest exists
+    if (fs::exists(dest)) fs::remove(dest);
+
+    auto q = this->query("VACUUM INTO ?");
+    q->bind(1, dest.string());
+    q->execute();
+
+    // The search index and the meta indexes are derived from entries
+    // (the search index is usually the largest structure in the file).
+    // They are rebuilt by ensureSchemaConsistency when the copy is opened.
+    SqliteDatabase copy;
+    copy.open(dest.string());
+    copy.exec("DROP TRIGGER IF EXISTS entries_fts_insert;"
+              "DROP TRIGGER IF EXISTS entries_fts_delete;"
+              "DROP TRIGGER IF EXISTS entries_fts_update;"
+              "DROP TABLE IF EXISTS entries_fts;"
+              "DROP INDEX IF EXISTS ix_entries_capture_time;"
+              "DROP INDEX IF EXISTS ix_entries_make;"
+              "DROP INDEX IF EXISTS ix_entries_model;"
+              "DROP INDEX IF EXISTS ix_entries_flight;"
+              "VACUUM;");
+    copy.close();
+}
+
+long long Database::pragmaValue(const std::string &name) {
+    auto q = this->query("PRAGMA " + name);
+    return q->fetch() ? q->getInt64(0) : 0;
+}
+
+StorageInfo Database::getStorageInfo() {
+    StorageInfo info;
+
+    info.pageSize = pragmaValue("page_size");
+    info.pageCount = pragmaValue("page_count");
+    info.freePages = pragmaValue("freelist_count");
+
+    std::error_code ec;
+    info.fileSize = fs::file_size(openFile, ec);
+    if (ec) info.fileSize = 0;
+    info.walSize = fs::file_size(openFile + "-wal", ec);
+    if (ec) info.walSize = 0;
+
+    return info;
+}
+
+void Database::optimize() {
+    LOGD << "Optimizing " << openFile;
+
+    if (pragmaValue("auto_vacuum") != 2) {
+        // Databases created before incremental vacuum was enabled
+        // need a full VACUUM for the setting to take effect
+        LOGD << "Enabling incremental vacuum";
+        this->exec("PRAGMA auto_vacuum = INCREMENTAL; VACUUM;");
+
+        // Rowids can change after a full VACUUM
+        if (this->hasSearchIndex()) this->rebuildSearchIndex();
+    } else {
+        this->exec("PRAGMA incremental_vacuum;");
+    }
+
+    this->updateStatsExtent();
+    this->exec("ANALYZE; PRAGMA optimize;");
+    this->exec("PRAGMA wal_checkpoint(TRUNCATE);");
+    this->setLongAttribute("optimize_changes", this->getLongAttribute("stats_changes"));
+
+    LOGD << "Optimized";
+}
+
+// Changed entries (see stats_changes) since the last optimization
+// before mutating operations look at the database again
+#define AUTO_OPTIMIZE_MIN_CHANGES 1000
+
+// Free pages (as a fraction of all pages) that trigger an automatic
+// incremental vacuum, for databases with at least AUTO_OPTIMIZE_MIN_PAGES pages
+#define AUTO_OPTIMIZE_FREE_RATIO 0.25
+#define AUTO_OPTIMIZE_MIN_PAGES 1024
+
+bool Database::autoOptimize() {
+    // Called after every mutating operation, so most calls
+    // should cost no more than reading two attributes
+    const auto changes = this->getLongAttribute("stats_changes");
+    if (changes - this->getLongAttribute("optimize_changes") < AUTO_OPTIMIZE_MIN_CHANGES) return false;
+    this->setLongAttribute("optimize_changes", changes);
+
+    // Only analyzes tables whose statistics are missing or stale
+    this->exec("PRAGMA optimize;");
+
+    const auto pageCount = pragmaValue("page_count");
+    const auto freePages = pragmaValue("freelist_count");
+
+    if (pageCount < AUTO_OPTIMIZE_MIN_PAGES ||
+        freePages < pageCount * AUTO_OPTIMIZE_FREE_RATIO) return false;
+
+    if (pragmaValue("auto_vacuum") != 2) {
+        // A full VACUUM is too expensive to run implicitly
+        LOGD << freePages << " of " << pageCount << " pages are free, run optimize to reclaim them";
+        return false;
+    }
+
+    LOGD << "Reclaiming " << freePages << " free pages";
+    this->exec("PRAGMA incremental_vacuum; PRAGMA wal_checkpoint(TRUNCATE);");
+
+    return true;
 }
 
 void Database::setPublic(bool isPublic) {
@@ -154,9 +593,9 @@ json Database::getAttributes() const {
         }
     }
 
-    // Count entries
+    // Count entries (kept up to date by the stats triggers)
     {
-        const std::string sql = "SELECT COUNT(1) FROM entries";
+        const std::string sql = "SELECT COALESCE(SUM(ivalue), 0) FROM attributes WHERE name LIKE 'stats\\_count\\_%' ESCAPE '\\'";
         const auto q = this->query(sql);
         while (q->fetch()) {
             j["entries"] = q->getInt(0);
@@ -4,6 +4,8 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <cmath>
+#include <map>
 #include "sqlite_database.h"
 #include "ddb_export.h"
 #include "json.h"
@@ -11,6 +13,26 @@
 
 namespace ddb{
 
+struct StorageInfo {
+    std::uintmax_t fileSize = 0;
+    std::uintmax_t walSize = 0;
+    long long pageSize = 0;
+    long long pageCount = 0;
+    long long freePages = 0;
+};
+
+// Aggregates of the entries table (see Database::getStats)
+struct IndexStats {
+    std::uintmax_t size = 0;
+    size_t entries = 0;
+    std::map<int, size_t> countByType; // EntryType --> count
+
+    // Extent of point and polygon geometries (EPSG:4326), NaN if there are none
+    double minX = NAN, minY = NAN, maxX = NAN, maxY = NAN;
+
+    bool hasExtent() const { return !std::isnan(minX); }
+};
+
 class Database : public SqliteDatabase {
   protected:
     void setIntAttribute(const std::string &name, long value);
@@ -25,12 +47,52 @@ class Database : public SqliteDatabase {
     bool hasAttribute(const std::string &name) const;
     void clearAttribute(const std::string &name);
 
+    long long pragmaValue(const std::string &name);
+    bool hasStatsTriggers() const;
+    bool addMetaColumns();
+    bool hasMetaIndexes();
+    IndexStats computeStats() const;
+    void computeExtent(IndexStats &stats) const;
+
   public:
       DDB_DLL static void Initialize();
       DDB_DLL void afterOpen() override;
       DDB_DLL Database &createTables();
       DDB_DLL void ensureSchemaConsistency();
 
+      // Whether this SQLite has generated columns (for the meta columns)
+      DDB_DLL static bool supportsGeneratedColumns();
+      DDB_DLL bool hasMetaColumns();
+
+      // SQL for a meta column (e.g. capture_time, make, flight): the
+      // generated column, or the equivalent json_extract of meta if
+      // the index doesn't have it
+      DDB_DLL std::string metaColumn(const std::string &name);
+
+      // Whether this SQLite has the trigram tokenizer (substring search)
+      DDB_DLL static bool supportsTrigramSearch();
+
+      // A substrings index uses the trigram tokenizer, otherwise
+      // words are indexed (and matched by prefix)
+      DDB_DLL bool createSearchIndex(bool substrings = supportsTrigramSearch());
+      DDB_DLL bool hasSearchIndex();
+      DDB_DLL bool hasTrigramSearchIndex();
+      DDB_DLL void rebuildSearchIndex();
+
+      // Self-contained, defragmented copy for transfers (push). Structures
+      // that can be derived from entries (search and meta indexes) are left
+      // out and rebuilt by ensureSchemaConsistency. The entries schema is
+      // unchanged, so the copy is a regular index.
+      DDB_DLL void compactCopy(const fs::path &dest);
+
+      DDB_DLL StorageInfo getStorageInfo();
+      DDB_DLL void optimize();
+
+      // Light optimization after mutating operations, only once every
+      // AUTO_OPTIMIZE_MIN_CHANGES changed entries. Returns true if free
+      // pages were reclaimed.
+      DDB_DLL bool autoOptimize();
+
       DDB_DLL void setPublic(bool isPublic);
       DDB_DLL bool isPublic() const;
 
@@ -40,6 +102,17 @@ class Database : public SqliteDatabase {
 
       DDB_DLL json getAttributes() const;
 
+      // Total size, counts by type and extent of the entries, kept up to
+      // date on every change of the index (no scan of entries is needed,
+      // except for the extent after geometries were removed or changed).
+      // Never writes, so it works on read-only connections (indexes
+      // without the stats triggers are scanned).
+      DDB_DLL IndexStats getStats() const;
+
+      // Saves the extent if removed or changed geometries made it stale
+      // (write paths call this so that readers don't recompute it)
+      DDB_DLL void updateStatsExtent();
+
 };
 
 }
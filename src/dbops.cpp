@@ -336,6 +336,9 @@ void addToIndex(Database *db, const std::vector<std::string> &paths,
 
     // Update last edit
     db->setLastUpdate();
+    db->updateStatsExtent();
+
+    db->autoOptimize();
 }
 
 void removeFromIndex(Database *db, const std::vector<std::string> &paths, RemoveCallback callback) {
@@ -377,6 +380,8 @@ void removeFromIndex(Database *db, const std::vector<std::string> &paths, Remove
 
     // Update last edit
     db->setLastUpdate();
+
+    db->autoOptimize();
 }
 
 std::string sanitize_query_param(const std::string &str) {
@@ -453,8 +458,50 @@ int deleteFromIndex(Database *db, const std::string &query, bool isFolder, Remov
     return count;
 }
 
+bool MetaFilter::matches(const Entry &e) const {
+    if (empty()) return true;
+    if (!e.meta.is_object()) return false;
+
+    const auto number = [&e](const char *key, double &value) {
+        const auto it = e.meta.find(key);
+        if (it == e.meta.end() || !it->is_number()) return false;
+        value = it->get<double>();
+        return true;
+    };
+    const auto text = [&e](const char *key) {
+        const auto it = e.meta.find(key);
+        return it != e.meta.end() && it->is_string() ? it->get<std::string>() : std::string();
+    };
+
+    if (capturedAfter > 0.0 || capturedBefore > 0.0) {
+        double captureTime;
+        if (!number("captureTime", captureTime)) return false;
+        if (capturedAfter > 0.0 && captureTime < capturedAfter) return false;
+        if (capturedBefore > 0.0 && captureTime > capturedBefore) return false;
+    }
+
+    if (!camera.empty()) {
+        const std::string make = text("make");
+        const std::string model = text("model");
+        if (make != camera && model != camera) {
+            const auto space = camera.find(' ');
+            if (space == std::string::npos ||
+                make != camera.substr(0, space) ||
+                model != camera.substr(space + 1)) return false;
+        }
+    }
+
+    if (flight > 0) {
+        double value;
+        if (!number("flight", value) || static_cast<int>(value) != flight) return false;
+    }
+
+    return true;
+}
+
 std::vector<Entry> getMatchingEntries(Database *db, const fs::path &path,
-                                      int maxRecursionDepth, bool isFolder) {
+                                      int maxRecursionDepth, bool isFolder,
+                                      const MetaFilter &filter) {
     // 0 is ALL_DEPTHS
     if (maxRecursionDepth < 0)
         throw FSException("Max recursion depth cannot be negative");
@@ -483,22 +530,91 @@ std::vector<Entry> getMatchingEntries(Database *db, const fs::path &path,
     if (maxRecursionDepth > 0)
         sql += " AND depth <= " + std::to_string(maxRecursionDepth - 1);
 
+    // Meta filters are matched against the indexed generated columns
+    // (or parse meta, with indexes that don't have them)
+    std::string cameraMake, cameraModel;
+    if (filter.capturedAfter > 0.0) sql += " AND " + db->metaColumn("capture_time") + " >= ?";
+    if (filter.capturedBefore > 0.0) sql += " AND " + db->metaColumn("capture_time") + " <= ?";
+    if (!filter.camera.empty()) {
+        const std::string make = db->metaColumn("make");
+        const std::string model = db->metaColumn("model");
+        sql += " AND (" + make + " = ? OR " + model + " = ? OR (" + make + " = ? AND " + model + " = ?))";
+
+        const auto space = filter.camera.find(' ');
+        cameraMake = filter.camera.substr(0, space);
+        if (space != std::string::npos) cameraModel = filter.camera.substr(space + 1);
+    }
+    if (filter.flight > 0) sql += " AND " + db->metaColumn("flight") + " = ?";
+
     auto q = db->query(sql);
 
     std::vector<Entry> entries;
 
-    q->bind(1, sanitized);
-
-    while (q->fetch()) {
-        Entry e(*q);
-        entries.push_back(e);
+    int p = 1;
+    q->bind(p++, sanitized);
+    if (filter.capturedAfter > 0.0) q->bind(p++, filter.capturedAfter);
+    if (filter.capturedBefore > 0.0) q->bind(p++, filter.capturedBefore);
+    if (!filter.camera.empty()) {
+        q->bind(p++, filter.camera);
+        q->bind(p++, filter.camera);
+        q->bind(p++, cameraMake);
+        q->bind(p++, cameraModel);
     }
+    if (filter.flight > 0) q->bind(p++, filter.flight);
+
+    // Built in place, each row is parsed once and never copied
+    while (q->fetch()) entries.emplace_back(*q);
 
     q->reset();
 
     return entries;
 }
 
+// Refreshes the entries (hash, mtime, meta and geometries) of files
+// that changed on disk, in a single transaction. Paths that are
+// not in the index are ignored.
+void updateIndex(Database *db, const std::vector<std::string> &paths,
+                 AddCallback callback) {
+    if (paths.empty()) return;  // Nothing to do
+    const fs::path directory = rootDirectory(db);
+
+    auto q = db->query("SELECT mtime,hash FROM entries WHERE path=?");
+    const auto updateQ = db->query(UPDATE_QUERY);
+    db->exec("BEGIN EXCLUSIVE TRANSACTION");
+
+    bool changed = false;
+
+    for (const auto &path : paths) {
+        const fs::path p = path;
+        io::Path relPath = io::Path(p).relativeTo(directory);
+
+        q->bind(1, relPath.generic());
+
+        if (q->fetch()) {
+            Entry e;
+            if (checkUpdate(e, p, q->getInt64(0), q->getText(1)) == Modified) {
+                parseEntry(p, directory, e, true);
+                doUpdate(updateQ.get(), e);
+                changed = true;
+
+                if (callback != nullptr && !callback(e, true)) {
+                    q->reset();
+                    break;  // cancel
+                }
+            }
+        }
+
+        q->reset();
+    }
+
+    db->exec("COMMIT");
+
+    if (changed) {
+        db->setLastUpdate();
+        db->autoOptimize();
+    }
+}
+
 void syncIndex(Database *db) {
     const fs::path directory = rootDirectory(db);
 
@@ -547,7 +663,10 @@ void syncIndex(Database *db) {
     db->exec("COMMIT");
 
     // Update last edit only if something is changed
-    if (changed) db->setLastUpdate();
+    if (changed) {
+        db->setLastUpdate();
+        db->autoOptimize();
+    }
 }
 
 // Sets the modified times of files in the filesystem
@@ -828,6 +947,40 @@ void moveEntry(Database* db, const std::string& source, const std::string& dest)
 
     // Update last edit
     db->setLastUpdate();
+
+    db->autoOptimize();
+}
+
+void to_json(json &j, const StorageInfo &info) {
+    j = json{{"fileSize", info.fileSize},
+             {"walSize", info.walSize},
+             {"pageSize", info.pageSize},
+             {"pageCount", info.pageCount},
+             {"freePages", info.freePages}};
+}
+
+void optimizeIndex(Database *db, std::ostream &output, const std::string &format) {
+    if (format != "json" && format != "text")
+        throw InvalidArgsException("Invalid format " + format);
+
+    const auto before = db->getStorageInfo();
+    db->optimize();
+    const auto after = db->getStorageInfo();
+
+    if (format == "json") {
+        json j = {{"before", before}, {"after", after}};
+        output << j.dump();
+    } else {
+        const auto print = [&output](const std::string &label, const StorageInfo &info) {
+            output << label << io::bytesToHuman(info.fileSize + info.walSize)
+                   << " (" << info.pageCount << " pages, " << info.freePages << " free";
+            if (info.walSize > 0) output << ", WAL " << io::bytesToHuman(info.walSize);
+            output << ")" << std::endl;
+        };
+
+        print("Before: ", before);
+        print("After: ", after);
+    }
 }
 
 }  // namespace ddb
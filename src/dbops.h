@@ -13,6 +13,24 @@
 
 namespace ddb {
 
+// Filters on the indexed meta columns (capture_time, make, model)
+struct MetaFilter {
+    // Milliseconds since epoch (like meta.captureTime), 0 to ignore
+    double capturedAfter = 0.0;
+    double capturedBefore = 0.0;
+
+    // Matches make, model or "make model"
+    std::string camera;
+
+    // Flight assigned by clusterFlights, 0 to ignore
+    int flight = 0;
+
+    bool empty() const { return capturedAfter <= 0.0 && capturedBefore <= 0.0 && camera.empty() && flight <= 0; }
+
+    // Same checks as the SQL filter, on an entry that was already loaded
+    DDB_DLL bool matches(const Entry &e) const;
+};
+
 typedef std::function<bool(const Entry &e, bool updated)> AddCallback;
 typedef std::function<void(const std::string& path)> RemoveCallback;
 
@@ -21,16 +39,18 @@ DDB_DLL fs::path rootDirectory(Database *db);
 DDB_DLL std::vector<fs::path> getIndexPathList(const fs::path& rootDirectory, const std::vector<std::string> &paths, bool includeDirs);
 DDB_DLL std::vector<fs::path> getPathList(const std::vector<std::string> &paths, bool includeDirs, int maxDepth);
 DDB_DLL std::vector<std::string> expandPathList(const std::vector<std::string> &paths, bool recursive, int maxRecursionDepth);
-DDB_DLL std::vector<Entry> getMatchingEntries(Database* db, const fs::path& path, int maxRecursionDepth = 0, bool isFolder = false);
+DDB_DLL std::vector<Entry> getMatchingEntries(Database* db, const fs::path& path, int maxRecursionDepth = 0, bool isFolder = false, const MetaFilter &filter = MetaFilter());
 DDB_DLL void checkDeleteBuild(Database *db, std::string hash);
 DDB_DLL int deleteFromIndex(Database* db, const std::string &query, bool isFolder = false, RemoveCallback callback = nullptr);
 
 DDB_DLL void doUpdate(Statement *updateQ, const Entry &e);
 
-DDB_DLL void listIndex(Database* db, const std::vector<std::string> &paths, std::ostream& out, const std::string& format, bool recursive = false, int maxRecursionDepth = 0);
+DDB_DLL void listIndex(Database* db, const std::vector<std::string> &paths, std::ostream& out, const std::string& format, bool recursive = false, int maxRecursionDepth = 0, const MetaFilter &filter = MetaFilter());
 DDB_DLL void addToIndex(Database *db, const std::vector<std::string> &paths, AddCallback callback = nullptr);
+DDB_DLL void updateIndex(Database *db, const std::vector<std::string> &paths, AddCallback callback = nullptr);
 DDB_DLL void removeFromIndex(Database *db, const std::vector<std::string> &paths, RemoveCallback callback = nullptr);
 DDB_DLL void syncIndex(Database *db);
+DDB_DLL void optimizeIndex(Database *db, std::ostream &output, const std::string &format = "text");
 DDB_DLL void syncLocalMTimes(Database *db, const std::vector<std::string> &files = {});
 DDB_DLL void delta(Database* sourceDb, Database* targetDb, std::ostream& out, const std::string& format);
 DDB_DLL void moveEntry(Database* db, const std::string& source, const std::string& dest);
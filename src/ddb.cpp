@@ -11,12 +11,17 @@
 #include "dbops.h"
 #include "entry.h"
 #include "exceptions.h"
+#include "flights.h"
 #include "info.h"
 #include "build.h"
+#include "catalog.h"
 #include "json.h"
 #include "logger.h"
 #include "mio.h"
 #include "net.h"
+#include "octree.h"
+#include "search.h"
+#include "snapshot.h"
 #include "status.h"
 #include "syncmanager.h"
 #include "tagmanager.h"
@@ -411,3 +416,194 @@ DDB_DLL DDBErr DDBMoveEntry(const char *ddbPath, const char *source, const char
     DDB_C_END
 
 }
+
+DDB_DLL DDBErr DDBStats(const char *ddbPath, char **output, const char *format) {
+    DDB_C_BEGIN
+
+    if (ddbPath == nullptr) throw InvalidArgsException("No ddb path provided");
+
+    if (format == nullptr || strlen(format) == 0)
+        throw InvalidArgsException("No format provided");
+
+    if (output == nullptr) throw InvalidArgsException("No output provided");
+
+    const auto db = ddb::open(std::string(ddbPath), true);
+
+    std::ostringstream ss;
+    ddb::stats(db.get(), ss, format);
+
+    utils::copyToPtr(ss.str(), output);
+
+    DDB_C_END
+}
+
+DDB_DLL DDBErr DDBFlights(const char *ddbPath, bool update, char **output, const char *format) {
+    DDB_C_BEGIN
+
+    if (ddbPath == nullptr) throw InvalidArgsException("No ddb path provided");
+
+    if (format == nullptr || strlen(format) == 0)
+        throw InvalidArgsException("No format provided");
+
+    if (output == nullptr) throw InvalidArgsException("No output provided");
+
+    const auto db = ddb::open(std::string(ddbPath), true);
+
+    std::ostringstream ss;
+    ddb::listFlights(db.get(), ss, format, update);
+
+    utils::copyToPtr(ss.str(), output);
+
+    DDB_C_END
+}
+
+DDB_DLL DDBErr DDBSearch(const char *ddbPath, const char *query, char **output, const char *format, int limit, int offset) {
+    DDB_C_BEGIN
+
+    if (ddbPath == nullptr) throw InvalidArgsException("No ddb path provided");
+
+    if (query == nullptr || strlen(query) == 0)
+        throw InvalidArgsException("No query provided");
+
+    if (format == nullptr || strlen(format) == 0)
+        throw InvalidArgsException("No format provided");
+
+    if (output == nullptr) throw InvalidArgsException("No output provided");
+
+    const auto db = ddb::open(std::string(ddbPath), true);
+
+    std::ostringstream ss;
+    ddb::searchIndex(db.get(), query, ss, format, limit, offset);
+
+    utils::copyToPtr(ss.str(), output);
+
+    DDB_C_END
+}
+
+DDB_DLL DDBErr DDBCatalog(const char *catalogPath, const char **paths, int numPaths, const char *filter, char **output, const char *format) {
+    DDB_C_BEGIN
+
+    if (format == nullptr || strlen(format) == 0)
+        throw InvalidArgsException("No format provided");
+
+    if (output == nullptr) throw InvalidArgsException("No output provided");
+
+    CatalogFilter catalogFilter;
+    if (filter != nullptr && strlen(filter) > 0) {
+        const json j = json::parse(filter, nullptr, false);
+        if (!j.is_object()) throw InvalidArgsException("Invalid filter");
+
+        if (j.contains("bbox")) {
+            if (!j["bbox"].is_array() || j["bbox"].size() != 4) throw InvalidArgsException("Invalid bbox");
+            catalogFilter.hasBounds = true;
+            catalogFilter.minLon = j["bbox"][0].get<double>();
+            catalogFilter.minLat = j["bbox"][1].get<double>();
+            catalogFilter.maxLon = j["bbox"][2].get<double>();
+            catalogFilter.maxLat = j["bbox"][3].get<double>();
+        }
+        if (j.contains("capturedAfter")) catalogFilter.capturedAfter = j["capturedAfter"].get<double>();
+        if (j.contains("capturedBefore")) catalogFilter.capturedBefore = j["capturedBefore"].get<double>();
+    }
+
+    Catalog catalog(catalogPath != nullptr ? catalogPath : "");
+
+    if (paths != nullptr && numPaths > 0) {
+        catalog.harvest(std::vector<std::string>(paths, paths + numPaths));
+    }
+
+    std::ostringstream ss;
+    listCatalog(catalog, ss, format, catalogFilter);
+
+    utils::copyToPtr(ss.str(), output);
+
+    DDB_C_END
+}
+
+DDB_DLL DDBErr DDBPointCloudInfo(const char *ddbPath, const char *path, char **output) {
+    DDB_C_BEGIN
+
+    if (ddbPath == nullptr) throw InvalidArgsException("No ddb path provided");
+
+    if (path == nullptr) throw InvalidArgsException("No path provided");
+
+    if (output == nullptr) throw InvalidArgsException("No output provided");
+
+    const auto db = ddb::open(std::string(ddbPath), true);
+    const auto octree = ddb::openEntryOctree(db.get(), path);
+
+    utils::copyToPtr(octree->info().dump(), output);
+
+    DDB_C_END
+}
+
+DDB_DLL DDBErr DDBPointCloudHierarchy(const char *ddbPath, const char *path, const char *key, char **output) {
+    DDB_C_BEGIN
+
+    if (ddbPath == nullptr) throw InvalidArgsException("No ddb path provided");
+
+    if (path == nullptr) throw InvalidArgsException("No path provided");
+
+    if (key == nullptr) throw InvalidArgsException("No key provided");
+
+    if (output == nullptr) throw InvalidArgsException("No output provided");
+
+    const auto db = ddb::open(std::string(ddbPath), true);
+    const auto octree = ddb::openEntryOctree(db.get(), path);
+
+    utils::copyToPtr(octree->hierarchy(NodeKey::parse(key)).dump(), output);
+
+    DDB_C_END
+}
+
+DDB_DLL DDBErr DDBPointCloudQuery(const char *ddbPath, const char *path, double minX, double minY, double maxX, double maxY, int maxDepth, char **output) {
+    DDB_C_BEGIN
+
+    if (ddbPath == nullptr) throw InvalidArgsException("No ddb path provided");
+
+    if (path == nullptr) throw InvalidArgsException("No path provided");
+
+    if (output == nullptr) throw InvalidArgsException("No output provided");
+
+    const auto db = ddb::open(std::string(ddbPath), true);
+    const auto octree = ddb::openEntryOctree(db.get(), path);
+
+    const double inf = std::numeric_limits<double>::infinity();
+    const double bounds[6] = { minX, minY, -inf, maxX, maxY, inf };
+
+    json j = json::array();
+    double b[6];
+    for (const auto &n : octree->query(bounds, maxDepth)) {
+        octree->nodeBounds(n.key, b);
+        j.push_back({{"key", n.key.toString()},
+                     {"points", n.pointCount},
+                     {"bounds", {b[0], b[1], b[2], b[3], b[4], b[5]}}});
+    }
+
+    utils::copyToPtr(j.dump(), output);
+
+    DDB_C_END
+}
+
+DDB_DLL DDBErr DDBPointCloudNode(const char *ddbPath, const char *path, const char *key, uint8_t **data, size_t *size) {
+    DDB_C_BEGIN
+
+    if (ddbPath == nullptr) throw InvalidArgsException("No ddb path provided");
+
+    if (path == nullptr) throw InvalidArgsException("No path provided");
+
+    if (data == nullptr || size == nullptr) throw InvalidArgsException("No output provided");
+
+    const auto db = ddb::open(std::string(ddbPath), true);
+    const auto octree = ddb::openEntryOctree(db.get(), path);
+
+    const auto bytes = key == nullptr || strlen(key) == 0 ?
+                octree->readHeader() :
+                octree->readNode(NodeKey::parse(key));
+
+    *size = bytes.size();
+    *data = static_cast<uint8_t *>(malloc(bytes.size() > 0 ? bytes.size() : 1));
+    if (!bytes.empty()) memcpy(*data, bytes.data(), bytes.size());
+
+    DDB_C_END
+}
+
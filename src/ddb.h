@@ -4,6 +4,8 @@
 #ifndef DDB_H
 #define DDB_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "ddb_export.h"
 
 #ifdef __cplusplus
@@ -12,6 +14,7 @@ extern "C" {
 
 #define DDB_LOG_ENV "DDB_LOG"
 #define DDB_DEBUG_ENV "DDB_DEBUG"
+#define DDB_CACHE_KEY_ENV "DDB_CACHE_KEY"
 
 #define DDB_FOLDER ".ddb"
 
@@ -178,6 +181,80 @@ DDB_DLL DDBErr DDBSetLastSync(const char *ddbPath, const char *registry, const l
  * @return DDBERR_NONE on success, an error otherwise */
 DDB_DLL DDBErr DDBMoveEntry(const char *ddbPath, const char *source, const char *dest);
 
+/** Compute aggregate statistics over the index
+ * (counts and sizes by type, capture time range/histogram, cameras, extent)
+ * @param ddbPath path to the source DroneDB database (parent of ".ddb")
+ * @param output pointer to C-string where to store result
+ * @param format output format. One of: ["text", "json"]
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBStats(const char *ddbPath, char **output, const char *format);
+
+/** Group the images of the index into flights and strips
+ * @param ddbPath path to the source DroneDB database (parent of ".ddb")
+ * @param update whether to cluster the images before listing the flights
+ * @param output pointer to C-string where to store result
+ * @param format output format. One of: ["text", "json", "geojson"]
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBFlights(const char *ddbPath, bool update, char **output, const char *format);
+
+/** Search entries by path or camera name, ranked by relevance
+ * @param ddbPath path to the source DroneDB database (parent of ".ddb")
+ * @param query whitespace separated terms that must all match
+ * @param output pointer to C-string where to store result
+ * @param format output format. One of: ["text", "json"]
+ * @param limit maximum number of results (0 for all)
+ * @param offset number of results to skip
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBSearch(const char *ddbPath, const char *query, char **output, const char *format, int limit = 100, int offset = 0);
+
+/** Harvest dataset summaries into a catalog and search them
+ * @param catalogPath path to the catalog file (empty for the catalog in the user profile)
+ * @param paths datasets or folders containing datasets to add or refresh (can be empty)
+ * @param numPaths number of paths
+ * @param filter JSON object with optional "bbox" ([minLon, minLat, maxLon, maxLat]),
+ *        "capturedAfter" and "capturedBefore" (milliseconds since epoch) fields
+ * @param output pointer to C-string where to store result
+ * @param format output format. One of: ["text", "json"]
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBCatalog(const char *catalogPath, const char **paths, int numPaths, const char *filter, char **output, const char *format);
+
+/** Get information about the octree (EPT or COPC) built for a point cloud entry
+ * @param ddbPath path to the source DroneDB database (parent of ".ddb")
+ * @param path point cloud entry path
+ * @param output pointer to C-string where to store result (JSON)
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBPointCloudInfo(const char *ddbPath, const char *path, char **output);
+
+/** Get a hierarchy page of the octree built for a point cloud entry
+ * @param ddbPath path to the source DroneDB database (parent of ".ddb")
+ * @param path point cloud entry path
+ * @param key key of the root node of the page ("d-x-y-z")
+ * @param output pointer to C-string where to store result (JSON, in the EPT hierarchy format)
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBPointCloudHierarchy(const char *ddbPath, const char *path, const char *key, char **output);
+
+/** List the octree nodes of a point cloud entry that intersect a bounding box
+ * @param ddbPath path to the source DroneDB database (parent of ".ddb")
+ * @param path point cloud entry path
+ * @param minX minimum X (in the coordinates of the point cloud)
+ * @param minY minimum Y
+ * @param maxX maximum X
+ * @param maxY maximum Y
+ * @param maxDepth maximum octree depth (level of detail), -1 for no limit
+ * @param output pointer to C-string where to store result (JSON)
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBPointCloudQuery(const char *ddbPath, const char *path, double minX, double minY, double maxX, double maxY, int maxDepth, char **output);
+
+/** Read the compressed point data of an octree node of a point cloud entry
+ * @param ddbPath path to the source DroneDB database (parent of ".ddb")
+ * @param path point cloud entry path
+ * @param key node key ("d-x-y-z"). If empty, the octree header is returned instead
+ *        (ept.json for EPT, the LAS header and VLRs for COPC)
+ * @param data pointer where to store the address of the data (to be released with free)
+ * @param size pointer where to store the size of the data
+ * @return DDBERR_NONE on success, an error otherwise */
+DDB_DLL DDBErr DDBPointCloudNode(const char *ddbPath, const char *path, const char *key, uint8_t **data, size_t *size);
+
 
 #ifdef __cplusplus
 }
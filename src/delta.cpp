@@ -69,9 +69,26 @@ void delta(Database* sourceDb, Database* targetDb, std::ostream& output,
 
     if (format == "json") {
 
-        json j = delta;
-        
-        output << j.dump();
+        // Same output as json(delta).dump(), keys in sorted order
+        JsonWriter w(output);
+        w.startObject();
+
+        w.key("adds").startArray();
+        for (const AddAction& add : delta.adds)
+            w.startObject().key("path").value(add.path).key("type").value(add.type).endObject();
+        w.endArray();
+
+        w.key("copies").startArray();
+        for (const CopyAction& cpy : delta.copies)
+            w.startArray().value(cpy.source).value(cpy.destination).endArray();
+        w.endArray();
+
+        w.key("removes").startArray();
+        for (const RemoveAction& rem : delta.removes)
+            w.startObject().key("path").value(rem.path).key("type").value(rem.type).endObject();
+        w.endArray();
+
+        w.endObject();
 
     } else if (format == "text") {
         for (const CopyAction& cpy : delta.copies)
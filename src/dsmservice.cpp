@@ -98,8 +98,9 @@ std::string DSMService::loadFromNetwork(double latitude, double longitude){
     UTMZone z = getUTMZone(latitude, longitude);
     Projected2D p = toUTM(latitude, longitude, z);
 
-    Geographic2D max = fromUTM(Projected2D(p.x + radius, p.y + radius), z);
-    Geographic2D min = fromUTM(Projected2D(p.x - radius, p.y - radius), z);
+    const auto bounds = fromUTM({ Projected2D(p.x + radius, p.y + radius), Projected2D(p.x - radius, p.y - radius) }, z);
+    const Geographic2D &max = bounds[0];
+    const Geographic2D &min = bounds[1];
 
     std::string url = std::regex_replace(format, std::regex("\\{west\\}"), std::to_string(min.longitude));
     url = std::regex_replace(url, std::regex("\\{east\\}"), std::to_string(max.longitude));
@@ -9,6 +9,8 @@
 
 #include "mio.h"
 #include "pointcloud.h"
+#include "projection.h"
+#include "video.h"
 #include "ogr_srs_api.h"
 
 namespace ddb {
@@ -118,6 +120,32 @@ void parseEntry(const fs::path &path, const fs::path &rootDirectory, Entry &entr
             }catch(Exiv2::AnyError&){
                 LOGD << "Cannot read EXIF data: " << path.string();
             }
+
+            if (video){
+                VideoInfo vi;
+                if (getVideoInfo(path.string(), vi)){
+                    entry.meta["duration"] = vi.duration;
+                    if (!entry.meta.contains("width") || entry.meta["width"] == 0){
+                        entry.meta["width"] = vi.width;
+                        entry.meta["height"] = vi.height;
+                    }
+
+                    if (!vi.track.empty()){
+                        // There's no linestring geometry column, the track goes in meta as GeoJSON
+                        json coords = json::array();
+                        for (const auto &p : vi.track) coords.push_back({ p.longitude, p.latitude, p.altitude });
+                        entry.meta["track"] = { {"type", "LineString"}, {"coordinates", coords} };
+
+                        if (entry.point_geom.empty()){
+                            const auto &first = vi.track.front();
+                            entry.point_geom.addPoint(first.longitude, first.latitude, first.altitude);
+                        }
+                        entry.type = EntryType::GeoVideo;
+                    }
+                }else{
+                    LOGD << "Cannot read video info: " << path.string();
+                }
+            }
         }else if (entry.type == EntryType::GeoRaster){
             GDALDatasetH  hDataset;
             hDataset = GDALOpen( path.string().c_str(), GA_ReadOnly );
@@ -146,13 +174,34 @@ void parseEntry(const fs::path &path, const fs::path &rootDirectory, Entry &entr
                         if (OSRImportFromWkt(hSrs, &wktp) != OGRERR_NONE){
                             throw GDALException("Cannot read spatial reference system for " + path.string() + ". Is PROJ available?");
                         }
-                        OSRImportFromEPSG(hWgs84, 4326);
-                        OGRCoordinateTransformationH hTransform = OCTNewCoordinateTransformation(hSrs, hWgs84);
 
-                        auto ul = getRasterCoordinate(hTransform, geotransform, 0.0, 0.0);
-                        auto ur = getRasterCoordinate(hTransform, geotransform, width, 0);
-                        auto lr = getRasterCoordinate(hTransform, geotransform, width, height);
-                        auto ll = getRasterCoordinate(hTransform, geotransform, 0.0, height);
+                        // Web Mercator and WGS84 UTM rasters are converted in closed form
+                        const char *authName = OSRGetAuthorityName(hSrs, nullptr);
+                        const char *authCode = OSRGetAuthorityCode(hSrs, nullptr);
+                        const int epsg = authName != nullptr && authCode != nullptr && std::string(authName) == "EPSG" ? std::atoi(authCode) : 0;
+                        const bool utm = (epsg > 32600 && epsg <= 32660) || (epsg > 32700 && epsg <= 32760);
+
+                        OGRCoordinateTransformationH hTransform = nullptr;
+                        if (epsg != 3857 && !utm){
+                            OSRImportFromEPSG(hWgs84, 4326);
+                            hTransform = OCTNewCoordinateTransformation(hSrs, hWgs84);
+                        }
+
+                        auto toGeographic = [&](double x, double y){
+                            if (hTransform != nullptr) return getRasterCoordinate(hTransform, geotransform, x, y);
+
+                            Geographic2D g;
+                            const double geoX = geotransform[0] + geotransform[1] * x + geotransform[2] * y;
+                            const double geoY = geotransform[3] + geotransform[4] * x + geotransform[5] * y;
+                            if (utm) utmToGeographic(geoX, geoY, epsg % 100, epsg < 32700, g.latitude, g.longitude);
+                            else webMercatorToGeographic(geoX, geoY, g.latitude, g.longitude);
+                            return g;
+                        };
+
+                        auto ul = toGeographic(0.0, 0.0);
+                        auto ur = toGeographic(width, 0);
+                        auto lr = toGeographic(width, height);
+                        auto ll = toGeographic(0.0, height);
 
                         entry.polygon_geom.addPoint(ul.longitude, ul.latitude, 0.0);
                         entry.polygon_geom.addPoint(ur.longitude, ur.latitude, 0.0);
@@ -160,10 +209,10 @@ void parseEntry(const fs::path &path, const fs::path &rootDirectory, Entry &entr
                         entry.polygon_geom.addPoint(ll.longitude, ll.latitude, 0.0);
                         entry.polygon_geom.addPoint(ul.longitude, ul.latitude, 0.0);
 
-                        auto center = getRasterCoordinate(hTransform, geotransform, width / 2.0, height / 2.0);
+                        auto center = toGeographic(width / 2.0, height / 2.0);
                         entry.point_geom.addPoint(center.longitude, center.latitude, 0.0);
 
-                        OCTDestroyCoordinateTransformation(hTransform);
+                        if (hTransform != nullptr) OCTDestroyCoordinateTransformation(hTransform);
                         OSRDestroySpatialReference(hWgs84);
                         OSRDestroySpatialReference(hSrs);
                     }else{
@@ -255,10 +304,11 @@ void calculateFootprint(const SensorSize &sensorSize, const GeoLocation &geo, co
 //    LOGD << "LR: " << lowerRight;
 
     // Convert to geographic
-    auto ul = fromUTM(upperLeft, utmZone);
-    auto ur = fromUTM(upperRight, utmZone);
-    auto ll = fromUTM(lowerLeft, utmZone);
-    auto lr = fromUTM(lowerRight, utmZone);
+    const auto corners = fromUTM({ upperLeft, upperRight, lowerLeft, lowerRight }, utmZone);
+    const auto &ul = corners[0];
+    const auto &ur = corners[1];
+    const auto &ll = corners[2];
+    const auto &lr = corners[3];
 
     geom.addPoint(ul.longitude, ul.latitude, groundHeight);
     geom.addPoint(ll.longitude, ll.latitude, groundHeight);
@@ -280,6 +330,21 @@ void Entry::toJSON(json &j) const{
     if (!this->polygon_geom.empty()) j["polygon_geom"] = this->polygon_geom.toGeoJSON();
 }
 
+void Entry::writeJSON(JsonWriter &w) const{
+    // Keys in the same (sorted) order as json objects
+    w.startObject();
+    w.key("depth").value(this->depth);
+    if (this->hash != "") w.key("hash").value(this->hash);
+    if (!this->meta.empty()) w.key("meta").value(this->meta);
+    w.key("mtime").value(this->mtime);
+    w.key("path").value(this->path);
+    if (!this->point_geom.empty()) this->point_geom.writeGeoJSON(w.key("point_geom").rawValue());
+    if (!this->polygon_geom.empty()) this->polygon_geom.writeGeoJSON(w.key("polygon_geom").rawValue());
+    w.key("size").value(this->size);
+    w.key("type").value(this->type);
+    w.endObject();
+}
+
 bool Entry::toGeoJSON(json &j, BasicGeometryType type){
     // Only export entries that have valid geometries
     std::vector<BasicGeometry *> geoms;
@@ -316,6 +381,62 @@ bool Entry::toGeoJSON(json &j, BasicGeometryType type){
     return true;
 }
 
+// Writes a scalar the way json::dump() would
+template <typename T>
+static inline void writeJsonValue(std::ostream &out, const T &value){
+    out << json(value).dump();
+}
+
+bool Entry::writeGeoJSON(std::ostream &out, BasicGeometryType type) const{
+    const BasicGeometry *geom = nullptr;
+    if (!point_geom.empty() && (type == BasicGeometryType::BGAuto || type == BasicGeometryType::BGPoint)){
+        geom = &point_geom;
+    }else if (!polygon_geom.empty() && (type == BasicGeometryType::BGAuto || type == BasicGeometryType::BGPolygon)){
+        geom = &polygon_geom;
+    }
+    if (geom == nullptr) return false;
+
+    // Keys are written in the same (sorted) order as json objects
+    std::string geometry;
+    geom->writeGeoJSONGeometry(geometry);
+    out << R"({"crs":{"properties":{"name":"EPSG:4326"},"type":"name"},"geometry":)" << geometry << R"(,"properties":{)";
+
+    // Merge the entry fields with the meta keys (meta keys win)
+    std::vector<std::pair<const char *, std::string>> fields;
+    if (!hash.empty()) fields.emplace_back("hash", json(hash).dump());
+    fields.emplace_back("mtime", json(mtime).dump());
+    fields.emplace_back("path", json(path).dump());
+    fields.emplace_back("size", json(size).dump());
+    fields.emplace_back("type", json(this->type).dump());
+
+    bool first = true;
+    auto writeKey = [&](const std::string &key){
+        if (!first) out << ",";
+        first = false;
+        writeJsonValue(out, key);
+        out << ":";
+    };
+
+    auto f = fields.begin();
+    const bool hasMeta = meta.is_object();
+    auto m = meta.cbegin();
+    while (f != fields.end() || (hasMeta && m != meta.cend())){
+        if (hasMeta && m != meta.cend() && (f == fields.end() || m.key() <= f->first)){
+            if (f != fields.end() && m.key() == f->first) ++f;
+            writeKey(m.key());
+            out << m.value().dump();
+            ++m;
+        }else{
+            writeKey(f->first);
+            out << f->second;
+            ++f;
+        }
+    }
+
+    out << R"(},"type":"Feature"})";
+    return true;
+}
+
 std::string Entry::toString(){
     std::ostringstream s;
     s << "Path: " << this->path << "\n";
@@ -350,7 +471,7 @@ std::string Entry::toString(){
     return s.str();
 }
 
-void parsePoint(BasicGeometry* point_geom, nlohmann::basic_json<>::value_type coordinates)
+void parsePoint(BasicGeometry* point_geom, const json &coordinates)
 {
 	if (coordinates.empty())
 		throw DBException("Empty 'coordinates' field");
@@ -380,9 +501,7 @@ void loadPointGeom(BasicPointGeometry *point_geom, const std::string& text){
     if (j["type"].get<std::string>() != "Point") throw DBException(utils::stringFormat("Cannot parse point_geom field: expected Point type but got: %s", j["type"].dump()));
     if (!j.contains("coordinates")) throw DBException("Missing 'coordinates' field");
 
-	auto coordinates = j["coordinates"];
-
-	parsePoint(point_geom, coordinates);
+	parsePoint(point_geom, j["coordinates"]);
 
 }
 
@@ -396,12 +515,12 @@ void loadPolygonGeom(BasicPolygonGeometry *polygon_geom, const std::string& text
     if (j["type"].get<std::string>() != "Polygon") throw DBException(utils::stringFormat("Cannot parse polygon_geom field: expected Polygon type but got: %s", j["type"].dump()));
     if (!j.contains("coordinates")) throw DBException("Missing 'coordinates' field");
 
-    auto coordinates = j["coordinates"];
+    const auto &rings = j["coordinates"];
 
-    if (coordinates.empty()) throw DBException("Empty 'coordinates' field");
-    if (coordinates.size() != 1) throw DBException(utils::stringFormat("Expected 1 coordinates but got ", coordinates.size()));
+    if (rings.empty()) throw DBException("Empty 'coordinates' field");
+    if (rings.size() != 1) throw DBException(utils::stringFormat("Expected 1 coordinates but got ", rings.size()));
 
-    coordinates = coordinates[0];
+    const auto &coordinates = rings[0];
 
     if (coordinates.size() == 0) throw DBException("Expected coordinates but got 0");
 
@@ -415,10 +534,7 @@ void parseDroneDBEntry(const fs::path &ddbPath, Entry &entry){
         const auto db = ddb::open(ddbPath.string(), false);
 
         // The size of the database is the sum of all entries' sizes
-        auto q = db->query("SELECT SUM(size) FROM entries");
-        if (q->fetch()){
-            entry.size = q->getInt64(0);
-        }
+        entry.size = db->getStats().size;
 
         entry.meta = db->getAttributes();
         entry.type = EntryType::DroneDB;
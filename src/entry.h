@@ -16,6 +16,7 @@
 #include "basicgeometry.h"
 #include "geo.h"
 #include "json.h"
+#include "jsonwriter.h"
 #include "fs.h"
 #include "ddb_export.h"
 
@@ -38,7 +39,14 @@ struct Entry {
     BasicPolygonGeometry polygon_geom;
 
     DDB_DLL void toJSON(json &j) const;
+
+    // Same output as toJSON(j) followed by dump()
+    DDB_DLL void writeJSON(JsonWriter &w) const;
     DDB_DLL bool toGeoJSON(json &j, BasicGeometryType type = BasicGeometryType::BGAuto);
+
+    // Same output as toGeoJSON(j).dump(), written directly to the stream
+    // without building an intermediate json tree
+    DDB_DLL bool writeGeoJSON(std::ostream &out, BasicGeometryType type = BasicGeometryType::BGAuto) const;
     DDB_DLL std::string toString();
 
     Entry() { }
@@ -5,7 +5,12 @@
 #include "logger.h"
 #include "exceptions.h"
 #include <exiv2/exiv2.hpp>
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <thread>
 
 namespace ddb{
 
@@ -43,7 +48,7 @@ bool ExifEditor::canEdit(){
 }
 
 void ExifEditor::SetGPSAltitude(double altitude){
-    eachFile([=](const fs::path &f, Exiv2::ExifData &exifData){
+    queue([=](const fs::path &f, Exiv2::ExifData &exifData){
         exifData["Exif.GPSInfo.GPSAltitude"] = doubleToFraction(altitude, 4);
         exifData["Exif.GPSInfo.GPSAltitudeRef"] = altitude < 0.0 ? "1" : "0";
         LOGD << "Setting altitude to " << exifData["Exif.GPSInfo.GPSAltitude"].toString() << " (" << exifData["Exif.GPSInfo.GPSAltitudeRef"].toString() << ") for " << f.string();
@@ -54,7 +59,7 @@ void ExifEditor::SetGPSAltitude(double altitude){
 }
 
 void ExifEditor::SetGPSLatitude(double latitude){
-    eachFile([=](const fs::path &f, Exiv2::ExifData &exifData){
+    queue([=](const fs::path &f, Exiv2::ExifData &exifData){
         exifData["Exif.GPSInfo.GPSLatitude"] = doubleToDMS(latitude);
         exifData["Exif.GPSInfo.GPSLatitudeRef"] = latitude >= 0.0 ? "N" : "S";
 
@@ -66,7 +71,7 @@ void ExifEditor::SetGPSLatitude(double latitude){
 }
 
 void ExifEditor::SetGPSLongitude(double longitude){
-    eachFile([=](const fs::path &f, Exiv2::ExifData &exifData){
+    queue([=](const fs::path &f, Exiv2::ExifData &exifData){
         exifData["Exif.GPSInfo.GPSLongitude"] = doubleToDMS(longitude);
         exifData["Exif.GPSInfo.GPSLongitudeRef"] = longitude >= 0.0 ? "E" : "W";
         LOGD << "Setting longitude to " <<
@@ -77,7 +82,7 @@ void ExifEditor::SetGPSLongitude(double longitude){
 }
 
 void ExifEditor::SetGPS(double latitude, double longitude, double altitude){
-    eachFile([=](const fs::path &f, Exiv2::ExifData &exifData){
+    queue([=](const fs::path &f, Exiv2::ExifData &exifData){
         exifData["Exif.GPSInfo.GPSAltitude"] = doubleToFraction(altitude, 3);
         exifData["Exif.GPSInfo.GPSAltitudeRef"] = altitude < 0.0 ? "1" : "0";
         exifData["Exif.GPSInfo.GPSLatitude"] = doubleToDMS(latitude);
@@ -123,22 +128,254 @@ const std::string ExifEditor::doubleToFraction(double d, int precision){
     return res;
 }
 
-template<typename Func>
-void ExifEditor::eachFile(Func f){
-    for (auto &file : files){
-        auto image = Exiv2::ImageFactory::open(file.string(), false);
-        if (!image.get()) throw FSException("Cannot open " + file.string());
-        image->readMetadata();
+void ExifEditor::beginBatch(){
+    batching = true;
+}
 
-        f(file, image->exifData());
+void ExifEditor::queue(const ExifEdit &edit){
+    edits.push_back(edit);
+    if (!batching) commit();
+}
 
-        image->setExifData(image->exifData());
-        try{
-            image->writeMetadata();
-            //std::cout << "U\t" << file.string() << std::endl;
-        }catch(const Exiv2::AnyError &){
-            std::cerr << "Cannot write metadata to " + file.string();
+std::vector<fs::path> ExifEditor::commit(){
+    batching = false;
+    if (edits.empty() || files.empty()) return {};
+
+    const size_t numThreads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), files.size()));
+    std::vector<char> modified(files.size(), 0);
+    std::vector<std::exception_ptr> errors(numThreads);
+    std::atomic<size_t> next(0);
+
+    // The XMP toolkit must be initialized before it's used by multiple threads
+    Exiv2::XmpParser::initialize();
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; t++){
+        threads.emplace_back([&, t](){
+            try{
+                size_t i;
+                while ((i = next++) < files.size()){
+                    modified[i] = editFile(files[i]) ? 1 : 0;
+                }
+            }catch(...){
+                errors[t] = std::current_exception();
+                next = files.size(); // Stop the other threads
+            }
+        });
+    }
+
+    for (auto &t : threads) t.join();
+    edits.clear();
+
+    for (auto &e : errors){
+        if (e) std::rethrow_exception(e);
+    }
+
+    std::vector<fs::path> result;
+    for (size_t i = 0; i < files.size(); i++){
+        if (modified[i]) result.push_back(files[i]);
+    }
+    return result;
+}
+
+// Location of a tag value within a TIFF structure (a TIFF file or the
+// Exif segment of a JPEG)
+struct TiffTag{
+    uint16_t type;
+    uint32_t count;
+    std::streamoff offset;
+};
+
+class TiffReader{
+    std::fstream &f;
+    std::streamoff fileSize;
+    std::streamoff start = 0; // TIFF header
+    bool littleEndian = true;
+
+    static uint64_t typeSize(uint16_t type){
+        switch (type){
+            case 1: case 2: case 6: case 7: return 1; // BYTE, ASCII, SBYTE, UNDEFINED
+            case 3: case 8: return 2;                 // SHORT, SSHORT
+            case 4: case 9: case 11: case 13: return 4; // LONG, SLONG, FLOAT, IFD
+            case 5: case 10: case 12: return 8;       // RATIONAL, SRATIONAL, DOUBLE
+            default: return 0;
+        }
+    }
+
+    bool read(std::streamoff pos, void *buf, std::streamoff n){
+        if (pos < 0 || pos + n > fileSize) return false;
+        f.seekg(pos);
+        f.read(reinterpret_cast<char *>(buf), n);
+        return static_cast<bool>(f);
+    }
+
+    bool readU16(std::streamoff pos, uint16_t &v){
+        uint8_t b[2];
+        if (!read(pos, b, 2)) return false;
+        v = littleEndian ? static_cast<uint16_t>(b[0] | (b[1] << 8)) : static_cast<uint16_t>((b[0] << 8) | b[1]);
+        return true;
+    }
+
+    bool readU32(std::streamoff pos, uint32_t &v){
+        uint8_t b[4];
+        if (!read(pos, b, 4)) return false;
+        v = littleEndian ? (uint32_t(b[0]) | uint32_t(b[1]) << 8 | uint32_t(b[2]) << 16 | uint32_t(b[3]) << 24)
+                         : (uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | uint32_t(b[3]));
+        return true;
+    }
+
+    // Finds the TIFF header, either at the start of the file
+    // or in the Exif APP1 segment of a JPEG
+    bool findHeader(){
+        uint8_t b[4];
+        if (!read(0, b, 4)) return false;
+        if (std::memcmp(b, "II*\0", 4) == 0 || std::memcmp(b, "MM\0*", 4) == 0){
+            start = 0;
+            return true;
+        }
+        if (b[0] != 0xFF || b[1] != 0xD8) return false;
+
+        std::streamoff pos = 2;
+        while (true){
+            uint8_t m[4];
+            if (!read(pos, m, 4) || m[0] != 0xFF) return false;
+            if (m[1] == 0xDA || m[1] == 0xD9) return false; // Reached the image data, no Exif
+
+            const std::streamoff len = (m[2] << 8) | m[3];
+            if (m[1] == 0xE1 && len >= 8){
+                char id[6];
+                if (!read(pos + 4, id, 6)) return false;
+                if (std::memcmp(id, "Exif\0\0", 6) == 0){
+                    start = pos + 10;
+                    return true;
+                }
+            }
+            pos += 2 + len;
+        }
+    }
+
+    bool readIfd(uint32_t ifdOffset, std::map<uint16_t, TiffTag> &tags){
+        const std::streamoff pos = start + ifdOffset;
+        uint16_t n;
+        if (!readU16(pos, n)) return false;
+
+        for (uint16_t i = 0; i < n; i++){
+            const std::streamoff e = pos + 2 + i * 12;
+            uint16_t tag, type;
+            uint32_t count, value;
+            if (!readU16(e, tag) || !readU16(e + 2, type) || !readU32(e + 4, count) || !readU32(e + 8, value)) return false;
+
+            const uint64_t size = typeSize(type) * count;
+            if (size == 0) continue; // Unknown type, we'll never write it
+
+            const std::streamoff offset = size <= 4 ? e + 8 : start + value;
+            if (offset + static_cast<std::streamoff>(size) > fileSize) return false;
+            tags[tag] = {type, count, offset};
         }
+
+        return true;
+    }
+public:
+    TiffReader(std::fstream &f, std::streamoff fileSize) : f(f), fileSize(fileSize) {}
+
+    bool isLittleEndian() const { return littleEndian; }
+
+    // Reads the location of all tags in the GPS IFD
+    bool readGPSTags(std::map<uint16_t, TiffTag> &tags){
+        if (!findHeader()) return false;
+
+        uint8_t bo[2];
+        if (!read(start, bo, 2)) return false;
+        if (bo[0] == 'I' && bo[1] == 'I') littleEndian = true;
+        else if (bo[0] == 'M' && bo[1] == 'M') littleEndian = false;
+        else return false;
+
+        uint16_t magic;
+        uint32_t ifd0;
+        if (!readU16(start + 2, magic) || magic != 42 || !readU32(start + 4, ifd0)) return false;
+
+        std::map<uint16_t, TiffTag> ifd0Tags;
+        if (!readIfd(ifd0, ifd0Tags)) return false;
+
+        const auto gps = ifd0Tags.find(0x8825);
+        if (gps == ifd0Tags.end() || gps->second.count != 1) return false;
+        uint32_t gpsIfd;
+        if (!readU32(gps->second.offset, gpsIfd)) return false;
+
+        return readIfd(gpsIfd, tags);
+    }
+};
+
+// Overwrites the GPS tags of a file with those in exifData, without
+// rewriting the file. This is only possible if every tag already exists
+// in the file with the same type and number of components.
+// Returns false (and leaves the file untouched) otherwise.
+static bool patchGPSTags(const fs::path &file, const Exiv2::ExifData &exifData, bool &modified){
+    modified = false;
+
+    std::fstream f(file.string(), std::ios::in | std::ios::out | std::ios::binary);
+    if (!f.is_open()) return false;
+    f.seekg(0, std::ios::end);
+    const std::streamoff fileSize = f.tellg();
+
+    TiffReader reader(f, fileSize);
+    std::map<uint16_t, TiffTag> tags;
+    if (!reader.readGPSTags(tags)) return false;
+
+    const Exiv2::ByteOrder byteOrder = reader.isLittleEndian() ? Exiv2::littleEndian : Exiv2::bigEndian;
+
+    // Check everything before writing anything
+    std::vector<std::pair<std::streamoff, std::vector<Exiv2::byte>>> writes;
+    for (const auto &d : exifData){
+        if (d.groupName() != "GPSInfo") continue;
+
+        const auto t = tags.find(d.tag());
+        if (t == tags.end() || t->second.type != static_cast<uint16_t>(d.typeId()) ||
+            t->second.count != static_cast<uint32_t>(d.count())) return false;
+
+        std::vector<Exiv2::byte> value(d.size());
+        if (value.empty() || static_cast<size_t>(d.copy(value.data(), byteOrder)) != value.size()) return false;
+
+        std::vector<Exiv2::byte> current(value.size());
+        f.seekg(t->second.offset);
+        f.read(reinterpret_cast<char *>(current.data()), static_cast<std::streamsize>(current.size()));
+        if (!f) return false;
+
+        if (current != value) writes.emplace_back(t->second.offset, std::move(value));
+    }
+
+    for (const auto &w : writes){
+        f.seekp(w.first);
+        f.write(reinterpret_cast<const char *>(w.second.data()), static_cast<std::streamsize>(w.second.size()));
+    }
+    f.flush();
+    if (!f) throw FSException("Cannot write metadata to " + file.string());
+
+    modified = !writes.empty();
+    return true;
+}
+
+bool ExifEditor::editFile(const fs::path &file){
+    auto image = Exiv2::ImageFactory::open(file.string(), false);
+    if (!image.get()) throw FSException("Cannot open " + file.string());
+    image->readMetadata();
+
+    Exiv2::ExifData &exifData = image->exifData();
+    for (auto &edit : edits) edit(file, exifData);
+
+    bool modified;
+    if (patchGPSTags(file, exifData, modified)){
+        LOGD << "Updated tags in place for " << file.string();
+        return modified;
+    }
+
+    image->setExifData(exifData);
+    try{
+        image->writeMetadata();
+        return true;
+    }catch(const Exiv2::AnyError &){
+        std::cerr << "Cannot write metadata to " + file.string() << std::endl;
+        return false;
     }
 }
 
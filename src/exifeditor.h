@@ -4,14 +4,23 @@
 #ifndef EXIFEDITOR_H
 #define EXIFEDITOR_H
 
+#include <functional>
 #include <vector>
 #include "fs.h"
 #include "ddb_export.h"
 
+namespace Exiv2{
+class ExifData;
+}
+
 namespace ddb{
 
+typedef std::function<void(const fs::path &, Exiv2::ExifData &)> ExifEdit;
+
 class ExifEditor {
   std::vector<fs::path> files;
+  std::vector<ExifEdit> edits;
+  bool batching = false;
 
   public:
     DDB_DLL ExifEditor(const std::string &file);
@@ -23,9 +32,18 @@ class ExifEditor {
     DDB_DLL void SetGPSLatitude(double latitude);
     DDB_DLL void SetGPSLongitude(double longitude);
     DDB_DLL void SetGPS(double latitude, double longitude, double altitude);
+
+    // Queue the next Set* calls instead of applying them right away,
+    // so that commit() opens and writes each file only once
+    DDB_DLL void beginBatch();
+
+    // Apply the queued edits to all files, in parallel. Tags that keep
+    // their type and size are overwritten in place, otherwise the file
+    // is rewritten. Returns the files that were modified.
+    DDB_DLL std::vector<fs::path> commit();
   protected:
-    template<typename Func>
-    void eachFile(Func f);
+    void queue(const ExifEdit &edit);
+    bool editFile(const fs::path &file);
 
     const std::string doubleToDMS(double d);
     const std::string doubleToFraction(double d, int precision);
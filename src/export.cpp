@@ -0,0 +1,236 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <cstring>
+#include <map>
+#include <set>
+#include <gdal_priv.h>
+#include <ogr_srs_api.h>
+
+#include "export.h"
+#include "basicgeometry.h"
+#include "entry_types.h"
+#include "exceptions.h"
+#include "json.h"
+#include "logger.h"
+#include "mio.h"
+
+namespace ddb {
+
+enum MetaKind { MKNone, MKBool, MKInteger, MKReal, MKString, MKJson };
+
+// Kind of a column that has held values of both kinds
+static MetaKind mergeKinds(MetaKind a, MetaKind b){
+    if (a == MKNone || a == b) return b;
+    if (b == MKNone) return a;
+    if ((a == MKInteger && b == MKReal) || (a == MKReal && b == MKInteger)) return MKReal;
+    return MKString;
+}
+
+static MetaKind kindOf(const json &v){
+    switch (v.type()){
+        case json::value_t::boolean: return MKBool;
+        case json::value_t::number_integer:
+        case json::value_t::number_unsigned: return MKInteger;
+        case json::value_t::number_float: return MKReal;
+        case json::value_t::string: return MKString;
+        case json::value_t::object:
+        case json::value_t::array: return MKJson;
+        default: return MKNone;
+    }
+}
+
+struct MetaColumn{
+    MetaKind kind = MKNone;
+    int field = -1;
+};
+
+static void setMetaField(OGRFeatureH hFeat, const MetaColumn &col, const json &v){
+    if (v.is_null()) return;
+
+    switch (col.kind){
+        case MKBool:
+            OGR_F_SetFieldInteger(hFeat, col.field, v.get<bool>() ? 1 : 0);
+            break;
+        case MKInteger:
+            OGR_F_SetFieldInteger64(hFeat, col.field, v.get<GIntBig>());
+            break;
+        case MKReal:
+            OGR_F_SetFieldDouble(hFeat, col.field, v.get<double>());
+            break;
+        default:
+            OGR_F_SetFieldString(hFeat, col.field, v.is_string() ? v.get<std::string>().c_str() : v.dump().c_str());
+            break;
+    }
+}
+
+size_t exportEntries(Database *db, const std::string &outputFile, const std::string &format, const std::string &geometry){
+    std::string fmt = format;
+    if (fmt == "auto"){
+        io::Path p = fs::path(outputFile);
+        if (p.checkExtension({"fgb"})) fmt = "fgb";
+        else if (p.checkExtension({"parquet"})) fmt = "parquet";
+        else throw InvalidArgsException("Cannot guess the export format of " + outputFile + ", please specify one");
+    }
+
+    // Neither driver is in every GDAL build
+    GDALDriverH drv;
+    char **layerOptions = nullptr;
+    if (fmt == "fgb"){
+        drv = GDALGetDriverByName("FlatGeobuf");
+        if (drv == nullptr) throw GDALException("Cannot create FlatGeobuf driver (GDAL 3.1 or later is required)");
+        layerOptions = CSLSetNameValue(layerOptions, "SPATIAL_INDEX", "YES");
+    }else if (fmt == "parquet"){
+        drv = GDALGetDriverByName("Parquet");
+        if (drv == nullptr) throw GDALException("Cannot create Parquet driver (GDAL 3.5 or later with Arrow/Parquet support is required)");
+        layerOptions = CSLSetNameValue(layerOptions, "GEOMETRY_ENCODING", "WKB");
+
+        // Sorted row groups need GDAL 3.9, older versions write them in index order
+        const char *options = GDALGetMetadataItem(drv, GDAL_DS_LAYER_CREATIONOPTIONLIST, nullptr);
+        if (options != nullptr && strstr(options, "SORT_BY_BBOX") != nullptr){
+            layerOptions = CSLSetNameValue(layerOptions, "SORT_BY_BBOX", "YES");
+        }else{
+            LOGD << "This GDAL cannot sort Parquet row groups by bounding box";
+        }
+    }else{
+        throw InvalidArgsException("Invalid format " + format);
+    }
+
+    const BasicGeometryType geomType = getBasicGeometryTypeFromName(geometry);
+    std::string where;
+    OGRwkbGeometryType layerType;
+    if (geomType == BasicGeometryType::BGPoint){
+        where = "point_geom IS NOT NULL";
+        layerType = wkbPoint25D;
+    }else if (geomType == BasicGeometryType::BGPolygon){
+        where = "polygon_geom IS NOT NULL";
+        layerType = wkbPolygon25D;
+    }else{
+        where = "point_geom IS NOT NULL OR polygon_geom IS NOT NULL";
+        layerType = wkbUnknown;
+    }
+
+    // First pass: the schema must be known before writing features,
+    // so we find the kind of every top level meta key
+    std::map<std::string, MetaColumn> columns;
+    auto q = db->query("SELECT meta FROM entries WHERE " + where);
+    while (q->fetch()){
+        const json meta = json::parse(q->getText(0), nullptr, false);
+        if (!meta.is_object()) continue;
+        for (auto it = meta.begin(); it != meta.end(); ++it){
+            auto &col = columns[it.key()];
+            col.kind = mergeKinds(col.kind, kindOf(it.value()));
+        }
+    }
+
+    io::assureIsRemoved(outputFile);
+    GDALDatasetH hDs = GDALCreate(drv, outputFile.c_str(), 0, 0, 0, GDT_Unknown, nullptr);
+    if (hDs == nullptr){
+        CSLDestroy(layerOptions);
+        throw GDALException("Cannot create " + outputFile + ": " + CPLGetLastErrorMsg());
+    }
+
+    size_t count = 0;
+    try{
+        OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
+        OSRImportFromEPSG(hSrs, 4326);
+        OGRLayerH hLayer = GDALDatasetCreateLayer(hDs, "entries", hSrs, layerType, layerOptions);
+        OSRDestroySpatialReference(hSrs);
+        CSLDestroy(layerOptions);
+        layerOptions = nullptr;
+        if (hLayer == nullptr) throw GDALException("Cannot create layer in " + outputFile + ": " + CPLGetLastErrorMsg());
+
+        const std::vector<std::pair<std::string, OGRFieldType>> baseFields = {
+            {"path", OFTString}, {"hash", OFTString}, {"type", OFTInteger},
+            {"mtime", OFTInteger64}, {"size", OFTInteger64}, {"depth", OFTInteger}
+        };
+        std::set<std::string> names;
+        int fieldCount = 0;
+        auto createField = [&](const std::string &name, OGRFieldType type, OGRFieldSubType subType){
+            OGRFieldDefnH hField = OGR_Fld_Create(name.c_str(), type);
+            OGR_Fld_SetSubType(hField, subType);
+            const OGRErr err = OGR_L_CreateField(hLayer, hField, TRUE);
+            OGR_Fld_Destroy(hField);
+            if (err != OGRERR_NONE) throw GDALException("Cannot create field " + name);
+            names.insert(name);
+            return fieldCount++;
+        };
+
+        for (const auto &f : baseFields) createField(f.first, f.second, OFSTNone);
+
+        for (auto &it : columns){
+            auto &col = it.second;
+            if (col.kind == MKNone) continue; // Always null
+
+            // Don't clash with the entry fields
+            std::string name = it.first;
+            while (names.find(name) != names.end()) name = "meta_" + name;
+
+            switch (col.kind){
+                case MKBool: col.field = createField(name, OFTInteger, OFSTBoolean); break;
+                case MKInteger: col.field = createField(name, OFTInteger64, OFSTNone); break;
+                case MKReal: col.field = createField(name, OFTReal, OFSTNone); break;
+                case MKJson: col.field = createField(name, OFTString, OFSTJSON); break;
+                default: col.field = createField(name, OFTString, OFSTNone); break;
+            }
+        }
+
+        OGRFeatureDefnH hDefn = OGR_L_GetLayerDefn(hLayer);
+
+        // Second pass: stream the entries, with geometries as WKB
+        q = db->query("SELECT path, hash, type, meta, mtime, size, depth, "
+                      "AsBinary(point_geom), AsBinary(polygon_geom) FROM entries WHERE " + where);
+        while (q->fetch()){
+            int geomCol = -1;
+            if (geomType != BasicGeometryType::BGPolygon && !q->isNull(7)) geomCol = 7;
+            else if (geomType != BasicGeometryType::BGPoint && !q->isNull(8)) geomCol = 8;
+            if (geomCol == -1) continue;
+
+            int wkbSize;
+            const void *wkb = q->getBlob(geomCol, wkbSize);
+            OGRGeometryH hGeom = nullptr;
+            if (OGR_G_CreateFromWkb(const_cast<void *>(wkb), nullptr, &hGeom, wkbSize) != OGRERR_NONE){
+                LOGD << "Cannot read geometry of " << q->getText(0) << ", skipping";
+                continue;
+            }
+
+            OGRFeatureH hFeat = OGR_F_Create(hDefn);
+            OGR_F_SetFieldString(hFeat, 0, q->getText(0).c_str());
+            const std::string hash = q->getText(1);
+            if (!hash.empty()) OGR_F_SetFieldString(hFeat, 1, hash.c_str());
+            OGR_F_SetFieldInteger(hFeat, 2, q->getInt(2));
+            OGR_F_SetFieldInteger64(hFeat, 3, q->getInt64(4));
+            OGR_F_SetFieldInteger64(hFeat, 4, q->getInt64(5));
+            OGR_F_SetFieldInteger(hFeat, 5, q->getInt(6));
+
+            const json meta = json::parse(q->getText(3), nullptr, false);
+            if (meta.is_object()){
+                for (auto it = meta.begin(); it != meta.end(); ++it){
+                    const auto col = columns.find(it.key());
+                    if (col != columns.end() && col->second.field >= 0) setMetaField(hFeat, col->second, it.value());
+                }
+            }
+
+            OGR_F_SetGeometryDirectly(hFeat, hGeom);
+            const OGRErr err = OGR_L_CreateFeature(hLayer, hFeat);
+            OGR_F_Destroy(hFeat);
+            if (err != OGRERR_NONE) throw GDALException("Cannot write " + q->getText(0) + ": " + CPLGetLastErrorMsg());
+
+            count++;
+        }
+
+        // Sorting and indexing happen when the dataset is closed
+        GDALClose(hDs);
+        hDs = nullptr;
+    }catch(...){
+        CSLDestroy(layerOptions);
+        if (hDs != nullptr) GDALClose(hDs);
+        io::assureIsRemoved(outputFile);
+        throw;
+    }
+
+    LOGD << "Exported " << count << " entries to " << outputFile;
+    return count;
+}
+
+}
@@ -0,0 +1,25 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <string>
+#include "database.h"
+#include "ddb_export.h"
+
+namespace ddb {
+
+// Exports the indexed entries that have a geometry to a FlatGeobuf ("fgb")
+// or GeoParquet ("parquet") file, reading them straight from the index.
+// Top level meta keys become typed columns. Features are spatially sorted
+// (packed Hilbert R-tree for FlatGeobuf, bounding box sorted row groups for GeoParquet
+// with GDAL 3.9 or later). FlatGeobuf needs GDAL 3.1, GeoParquet GDAL 3.5 built with Arrow.
+// format "auto" picks the format from the extension of outputFile.
+// Returns the number of exported entries.
+DDB_DLL size_t exportEntries(Database *db, const std::string &outputFile,
+                             const std::string &format = "auto", const std::string &geometry = "auto");
+
+}
+
+#endif // EXPORT_H
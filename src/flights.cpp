@@ -0,0 +1,241 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <algorithm>
+#include <cmath>
+
+#include "flights.h"
+#include "entry_types.h"
+#include "exceptions.h"
+#include "logger.h"
+
+namespace ddb {
+
+#define EARTH_RADIUS 6378137.0
+
+// Segments shorter than this (meters) are too noisy to compute a heading
+#define MIN_HEADING_SEGMENT 2.0
+
+struct FlightImage {
+    long long rowid;
+    double time;
+    double x, y; // longitude, latitude
+    int flight, strip;
+};
+
+// Equirectangular approximation, accurate enough over a few hundred meters
+static void toLocal(const FlightImage &a, const FlightImage &b, double &dx, double &dy){
+    const double rad = M_PI / 180.0;
+    dx = (b.x - a.x) * rad * std::cos((a.y + b.y) * 0.5 * rad) * EARTH_RADIUS;
+    dy = (b.y - a.y) * rad * EARTH_RADIUS;
+}
+
+static double angleDifference(double a, double b){
+    return std::abs(std::fmod(a - b + 540.0, 360.0) - 180.0);
+}
+
+std::vector<Flight> clusterFlights(Database *db, const FlightOptions &options){
+    std::vector<FlightImage> images;
+
+    const std::string captureTime = db->metaColumn("capture_time");
+    const std::string flightColumn = db->metaColumn("flight");
+
+    // Only read the columns we need
+    auto q = db->query("SELECT rowid, " + captureTime + ", X(point_geom), Y(point_geom), " + flightColumn + ", " +
+                       db->metaColumn("strip") + " FROM entries "
+                       "WHERE type = ? AND " + captureTime + " IS NOT NULL AND point_geom IS NOT NULL");
+    q->bind(1, EntryType::GeoImage);
+    while (q->fetch()){
+        images.push_back({q->getInt64(0), q->getDouble(1), q->getDouble(2), q->getDouble(3),
+                          q->isNull(4) ? 0 : q->getInt(4), q->isNull(5) ? 0 : q->getInt(5)});
+    }
+
+    std::sort(images.begin(), images.end(), [](const FlightImage &a, const FlightImage &b){
+        return a.time < b.time || (a.time == b.time && a.rowid < b.rowid);
+    });
+
+    db->exec("BEGIN EXCLUSIVE TRANSACTION");
+
+    int flight = 0;
+    size_t updated = 0;
+
+    try{
+        // Entries that can no longer be clustered (type changed, lost their location, ...)
+        auto clearQ = db->query("UPDATE entries SET meta = json_remove(meta, '$.flight', '$.strip') "
+                                "WHERE " + flightColumn + " IS NOT NULL AND NOT (type = ? AND " + captureTime + " IS NOT NULL AND point_geom IS NOT NULL)");
+        clearQ->bind(1, EntryType::GeoImage);
+        clearQ->execute();
+
+        auto updateQ = db->query("UPDATE entries SET meta = json_set(meta, '$.flight', ?, '$.strip', ?) WHERE rowid = ?");
+
+        int strip = 0;
+        double stripHeading = NAN;
+
+        for (size_t i = 0; i < images.size(); i++){
+            auto &img = images[i];
+            bool newFlight = i == 0;
+
+            if (!newFlight){
+                const auto &prev = images[i - 1];
+                double dx, dy;
+                toLocal(prev, img, dx, dy);
+                const double distance = std::sqrt(dx * dx + dy * dy);
+
+                if ((img.time - prev.time) / 1000.0 > options.maxTimeGap || distance > options.maxDistance){
+                    newFlight = true;
+                }else if (distance >= MIN_HEADING_SEGMENT){
+                    const double heading = std::atan2(dx, dy) * 180.0 / M_PI;
+                    if (std::isnan(stripHeading)){
+                        stripHeading = heading;
+                    }else if (angleDifference(heading, stripHeading) > options.maxTurn){
+                        strip++;
+                        stripHeading = heading;
+                    }
+                }
+            }
+
+            if (newFlight){
+                flight++;
+                strip = 1;
+                stripHeading = NAN;
+            }
+
+            if (img.flight != flight || img.strip != strip){
+                updateQ->bind(1, flight);
+                updateQ->bind(2, strip);
+                updateQ->bind(3, img.rowid);
+                updateQ->execute();
+                updated++;
+            }
+        }
+    }catch(...){
+        db->exec("ROLLBACK");
+        throw;
+    }
+
+    db->exec("COMMIT");
+
+    LOGD << "Clustered " << images.size() << " images into " << flight << " flights (" << updated << " updated)";
+
+    return getFlights(db);
+}
+
+// Andrew's monotone chain
+static std::vector<Point> convexHull(std::vector<Point> points){
+    std::sort(points.begin(), points.end(), [](const Point &a, const Point &b){
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    points.erase(std::unique(points.begin(), points.end(), [](const Point &a, const Point &b){
+        return a.x == b.x && a.y == b.y;
+    }), points.end());
+    if (points.size() < 3) return points;
+
+    auto cross = [](const Point &o, const Point &a, const Point &b){
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    };
+
+    std::vector<Point> hull(points.size() * 2);
+    size_t k = 0;
+    for (size_t i = 0; i < points.size(); i++){
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+        hull[k++] = points[i];
+    }
+    for (size_t i = points.size() - 1, t = k + 1; i > 0; i--){
+        while (k >= t && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0) k--;
+        hull[k++] = points[i - 1];
+    }
+    hull.resize(k); // Closed (last point == first point)
+    return hull;
+}
+
+std::vector<Flight> getFlights(Database *db){
+    std::vector<Flight> flights;
+
+    const std::string flight = db->metaColumn("flight");
+    const std::string captureTime = db->metaColumn("capture_time");
+    auto q = db->query("SELECT " + flight + ", " + db->metaColumn("strip") + ", " + captureTime + ", X(point_geom), Y(point_geom), path FROM entries "
+                       "WHERE " + flight + " IS NOT NULL ORDER BY " + flight + ", " + captureTime);
+
+    std::vector<Point> points;
+    std::vector<std::string> paths;
+
+    auto finish = [&](){
+        if (flights.empty()) return;
+        auto &f = flights.back();
+        f.thumbnail = paths[paths.size() / 2];
+
+        const auto hull = convexHull(points);
+        if (hull.size() >= 4){
+            for (const auto &p : hull) f.footprint.addPoint(p.x, p.y, 0.0);
+        }
+
+        points.clear();
+        paths.clear();
+    };
+
+    while (q->fetch()){
+        const int id = q->getInt(0);
+        if (flights.empty() || flights.back().id != id){
+            finish();
+            flights.emplace_back();
+            flights.back().id = id;
+            flights.back().startTime = q->getDouble(2);
+        }
+
+        auto &f = flights.back();
+        f.images++;
+        f.strips = std::max(f.strips, q->getInt(1));
+        f.endTime = q->getDouble(2);
+        points.emplace_back(q->getDouble(3), q->getDouble(4));
+        paths.push_back(q->getText(5));
+    }
+    finish();
+
+    return flights;
+}
+
+json Flight::toJSON() const{
+    json j = {
+        {"id", id},
+        {"images", images},
+        {"strips", strips},
+        {"startTime", startTime},
+        {"endTime", endTime},
+        {"thumbnail", thumbnail}
+    };
+    j["footprint"] = footprint.empty() ? json(nullptr) : footprint.toGeoJSON()["geometry"];
+    return j;
+}
+
+void listFlights(Database *db, std::ostream &output, const std::string &format, bool update, const FlightOptions &options){
+    if (format != "text" && format != "json" && format != "geojson")
+        throw InvalidArgsException("Invalid format " + format);
+
+    const auto flights = update ? clusterFlights(db, options) : getFlights(db);
+
+    if (format == "json"){
+        json j = json::array();
+        for (const auto &f : flights) j.push_back(f.toJSON());
+        output << j.dump();
+    }else if (format == "geojson"){
+        json j = {{"type", "FeatureCollection"}, {"features", json::array()}};
+        for (const auto &f : flights){
+            json props = f.toJSON();
+            props.erase("footprint");
+            j["features"].push_back({
+                {"type", "Feature"},
+                {"geometry", f.footprint.empty() ? json(nullptr) : f.footprint.toGeoJSON()["geometry"]},
+                {"properties", props}
+            });
+        }
+        output << j.dump();
+    }else{
+        for (const auto &f : flights){
+            output << "Flight " << f.id << ": " << f.images << " images, " << f.strips << " strips, "
+                   << static_cast<int>(std::round((f.endTime - f.startTime) / 60000.0)) << " minutes ("
+                   << f.thumbnail << ")" << std::endl;
+        }
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef FLIGHTS_H
+#define FLIGHTS_H
+
+#include <string>
+#include <vector>
+#include "basicgeometry.h"
+#include "database.h"
+#include "json.h"
+#include "ddb_export.h"
+
+namespace ddb {
+
+struct FlightOptions {
+    // A new flight starts when consecutive images are further apart than this,
+    // in time (seconds) or in space (meters)
+    double maxTimeGap = 120.0;
+    double maxDistance = 300.0;
+
+    // A new strip starts when the heading changes by more than this (degrees)
+    double maxTurn = 45.0;
+};
+
+struct Flight {
+    int id = 0;
+    int images = 0;
+    int strips = 0;
+
+    // Milliseconds since epoch, like meta.captureTime
+    double startTime = 0.0;
+    double endTime = 0.0;
+
+    // Image in the middle of the flight, for previews
+    std::string thumbnail;
+
+    // Convex hull of the image locations
+    BasicPolygonGeometry footprint;
+
+    DDB_DLL json toJSON() const;
+};
+
+// Groups the GeoImages of the index into flights and strips by capture time and location.
+// Images are sorted by capture time once (O(n log n)), then split wherever the time
+// gap, the distance or the heading change exceeds the thresholds.
+// Assignments are stored in meta (flight, strip), queryable through the
+// indexed flight and strip columns. Only entries whose assignment changed are written.
+DDB_DLL std::vector<Flight> clusterFlights(Database *db, const FlightOptions &options = FlightOptions());
+
+// Flights as currently stored in the index
+DDB_DLL std::vector<Flight> getFlights(Database *db);
+
+// Writes the flights of the index in the given format (text, json or geojson),
+// clustering the images first if update is true
+DDB_DLL void listFlights(Database *db, std::ostream &output, const std::string &format = "text",
+                         bool update = true, const FlightOptions &options = FlightOptions());
+
+}
+
+#endif // FLIGHTS_H
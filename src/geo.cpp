@@ -1,10 +1,9 @@
 /* This Source Code Form is subject to the terms of the Mozilla Public
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
-#include <gdal_priv.h>
-#include <ogr_srs_api.h>
 #include <sstream>
 #include "geo.h"
+#include "projection.h"
 
 namespace ddb {
 
@@ -70,28 +69,23 @@ std::string getProjForUTM(const UTMZone &zone){
 
 Projected2D toUTM(double latitude, double longitude, const UTMZone &zone) {
     Projected2D result;
+    geographicToUTM(latitude, longitude, zone.zone, zone.north, result.x, result.y);
+    return result;
+}
 
-    OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
-    OGRSpatialReferenceH hWgs84 = OSRNewSpatialReference(nullptr);
-
-    std::string proj = getProjForUTM(zone);
-    if (OSRImportFromProj4(hSrs, proj.c_str()) != OGRERR_NONE){
-        throw GDALException("Cannot import spatial reference system " + proj + ". Is PROJ available?");
-    }
-    OSRImportFromEPSG(hWgs84, 4326);
-    OGRCoordinateTransformationH hTransform = OCTNewCoordinateTransformation(hWgs84, hSrs);
-
-    double geoX = latitude;
-    double geoY = longitude;
-    if (OCTTransform(hTransform, 1, &geoX, &geoY, nullptr)){
-        OCTDestroyCoordinateTransformation(hTransform);
-        OSRDestroySpatialReference(hWgs84);
-        OSRDestroySpatialReference(hSrs);
-
-        return Projected2D(geoX, geoY);
-    }else{
-        throw GDALException("Cannot transform coordinates to UTM " + std::to_string(latitude) + "," + std::to_string(longitude));
+std::vector<Projected2D> toUTM(const std::vector<Geographic2D> &points, const UTMZone &zone){
+    std::vector<double> lat(points.size()), lon(points.size()), x(points.size()), y(points.size());
+    for (size_t i = 0; i < points.size(); i++){
+        lat[i] = points[i].latitude;
+        lon[i] = points[i].longitude;
     }
+
+    geographicToUTM(lat.data(), lon.data(), x.data(), y.data(), points.size(), zone.zone, zone.north);
+
+    std::vector<Projected2D> result;
+    result.reserve(points.size());
+    for (size_t i = 0; i < points.size(); i++) result.emplace_back(x[i], y[i]);
+    return result;
 }
 
 Geographic2D fromUTM(const Projected2D &p, const UTMZone &zone) {
@@ -99,28 +93,24 @@ Geographic2D fromUTM(const Projected2D &p, const UTMZone &zone) {
 }
 
 Geographic2D fromUTM(double x, double y, const UTMZone &zone) {
-    OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
-    OGRSpatialReferenceH hWgs84 = OSRNewSpatialReference(nullptr);
+    Geographic2D result;
+    utmToGeographic(x, y, zone.zone, zone.north, result.latitude, result.longitude);
+    return result;
+}
 
-    std::string proj = getProjForUTM(zone);
-    if (OSRImportFromProj4(hSrs, proj.c_str()) != OGRERR_NONE){
-        throw GDALException("Cannot import spatial reference system " + proj + ". Is PROJ available?");
-    }
-    OSRImportFromEPSG(hWgs84, 4326);
-    OGRCoordinateTransformationH hTransform = OCTNewCoordinateTransformation(hSrs, hWgs84);
-
-    double geoX = x;
-    double geoY = y;
-    if (OCTTransform(hTransform, 1, &geoX, &geoY, nullptr)){
-        OCTDestroyCoordinateTransformation(hTransform);
-        OSRDestroySpatialReference(hWgs84);
-        OSRDestroySpatialReference(hSrs);
-
-        return Geographic2D(geoY, geoX);
-    }else{
-        throw GDALException("Cannot transform coordinates to UTM " + std::to_string(x) + "," + std::to_string(y));
+std::vector<Geographic2D> fromUTM(const std::vector<Projected2D> &points, const UTMZone &zone){
+    std::vector<double> x(points.size()), y(points.size()), lat(points.size()), lon(points.size());
+    for (size_t i = 0; i < points.size(); i++){
+        x[i] = points[i].x;
+        y[i] = points[i].y;
     }
-}
 
+    utmToGeographic(x.data(), y.data(), lat.data(), lon.data(), points.size(), zone.zone, zone.north);
+
+    std::vector<Geographic2D> result;
+    result.reserve(points.size());
+    for (size_t i = 0; i < points.size(); i++) result.emplace_back(lon[i], lat[i]);
+    return result;
 }
 
+}
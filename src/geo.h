@@ -5,6 +5,7 @@
 #define GEO_H
 
 #include <iostream>
+#include <vector>
 #include "utils.h"
 #include "ddb_export.h"
 
@@ -98,9 +99,11 @@ DDB_DLL int standardUTMZone(double latitude, double longitude);
 DDB_DLL UTMZone getUTMZone(double latitude, double longitude);
 DDB_DLL std::string getProjForUTM(const UTMZone &zone);
 DDB_DLL Projected2D toUTM(double latitude, double longitude, const UTMZone &zone);
+DDB_DLL std::vector<Projected2D> toUTM(const std::vector<Geographic2D> &points, const UTMZone &zone);
 
 DDB_DLL Geographic2D fromUTM(const Projected2D &p, const UTMZone &zone);
 DDB_DLL Geographic2D fromUTM(double x, double y, const UTMZone &zone);
+DDB_DLL std::vector<Geographic2D> fromUTM(const std::vector<Projected2D> &points, const UTMZone &zone);
 
 }
 
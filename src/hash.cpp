@@ -1,12 +1,171 @@
 /* This Source Code Form is subject to the terms of the Mozilla Public
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
-#include <sstream>
+#include <cstdlib>
+#include <cstring>
 #include "hash.h"
+#include "ddb.h"
 #include "exceptions.h"
 
 using namespace ddb;
 
+static const uint64_t crc64_table[256] = {
+    uint64_t(0x0000000000000000), uint64_t(0x7ad870c830358979),
+    uint64_t(0xf5b0e190606b12f2), uint64_t(0x8f689158505e9b8b),
+    uint64_t(0xc038e5739841b68f), uint64_t(0xbae095bba8743ff6),
+    uint64_t(0x358804e3f82aa47d), uint64_t(0x4f50742bc81f2d04),
+    uint64_t(0xab28ecb46814fe75), uint64_t(0xd1f09c7c5821770c),
+    uint64_t(0x5e980d24087fec87), uint64_t(0x24407dec384a65fe),
+    uint64_t(0x6b1009c7f05548fa), uint64_t(0x11c8790fc060c183),
+    uint64_t(0x9ea0e857903e5a08), uint64_t(0xe478989fa00bd371),
+    uint64_t(0x7d08ff3b88be6f81), uint64_t(0x07d08ff3b88be6f8),
+    uint64_t(0x88b81eabe8d57d73), uint64_t(0xf2606e63d8e0f40a),
+    uint64_t(0xbd301a4810ffd90e), uint64_t(0xc7e86a8020ca5077),
+    uint64_t(0x4880fbd87094cbfc), uint64_t(0x32588b1040a14285),
+    uint64_t(0xd620138fe0aa91f4), uint64_t(0xacf86347d09f188d),
+    uint64_t(0x2390f21f80c18306), uint64_t(0x594882d7b0f40a7f),
+    uint64_t(0x1618f6fc78eb277b), uint64_t(0x6cc0863448deae02),
+    uint64_t(0xe3a8176c18803589), uint64_t(0x997067a428b5bcf0),
+    uint64_t(0xfa11fe77117cdf02), uint64_t(0x80c98ebf2149567b),
+    uint64_t(0x0fa11fe77117cdf0), uint64_t(0x75796f2f41224489),
+    uint64_t(0x3a291b04893d698d), uint64_t(0x40f16bccb908e0f4),
+    uint64_t(0xcf99fa94e9567b7f), uint64_t(0xb5418a5cd963f206),
+    uint64_t(0x513912c379682177), uint64_t(0x2be1620b495da80e),
+    uint64_t(0xa489f35319033385), uint64_t(0xde51839b2936bafc),
+    uint64_t(0x9101f7b0e12997f8), uint64_t(0xebd98778d11c1e81),
+    uint64_t(0x64b116208142850a), uint64_t(0x1e6966e8b1770c73),
+    uint64_t(0x8719014c99c2b083), uint64_t(0xfdc17184a9f739fa),
+    uint64_t(0x72a9e0dcf9a9a271), uint64_t(0x08719014c99c2b08),
+    uint64_t(0x4721e43f0183060c), uint64_t(0x3df994f731b68f75),
+    uint64_t(0xb29105af61e814fe), uint64_t(0xc849756751dd9d87),
+    uint64_t(0x2c31edf8f1d64ef6), uint64_t(0x56e99d30c1e3c78f),
+    uint64_t(0xd9810c6891bd5c04), uint64_t(0xa3597ca0a188d57d),
+    uint64_t(0xec09088b6997f879), uint64_t(0x96d1784359a27100),
+    uint64_t(0x19b9e91b09fcea8b), uint64_t(0x636199d339c963f2),
+    uint64_t(0xdf7adabd7a6e2d6f), uint64_t(0xa5a2aa754a5ba416),
+    uint64_t(0x2aca3b2d1a053f9d), uint64_t(0x50124be52a30b6e4),
+    uint64_t(0x1f423fcee22f9be0), uint64_t(0x659a4f06d21a1299),
+    uint64_t(0xeaf2de5e82448912), uint64_t(0x902aae96b271006b),
+    uint64_t(0x74523609127ad31a), uint64_t(0x0e8a46c1224f5a63),
+    uint64_t(0x81e2d7997211c1e8), uint64_t(0xfb3aa75142244891),
+    uint64_t(0xb46ad37a8a3b6595), uint64_t(0xceb2a3b2ba0eecec),
+    uint64_t(0x41da32eaea507767), uint64_t(0x3b024222da65fe1e),
+    uint64_t(0xa2722586f2d042ee), uint64_t(0xd8aa554ec2e5cb97),
+    uint64_t(0x57c2c41692bb501c), uint64_t(0x2d1ab4dea28ed965),
+    uint64_t(0x624ac0f56a91f461), uint64_t(0x1892b03d5aa47d18),
+    uint64_t(0x97fa21650afae693), uint64_t(0xed2251ad3acf6fea),
+    uint64_t(0x095ac9329ac4bc9b), uint64_t(0x7382b9faaaf135e2),
+    uint64_t(0xfcea28a2faafae69), uint64_t(0x8632586aca9a2710),
+    uint64_t(0xc9622c4102850a14), uint64_t(0xb3ba5c8932b0836d),
+    uint64_t(0x3cd2cdd162ee18e6), uint64_t(0x460abd1952db919f),
+    uint64_t(0x256b24ca6b12f26d), uint64_t(0x5fb354025b277b14),
+    uint64_t(0xd0dbc55a0b79e09f), uint64_t(0xaa03b5923b4c69e6),
+    uint64_t(0xe553c1b9f35344e2), uint64_t(0x9f8bb171c366cd9b),
+    uint64_t(0x10e3202993385610), uint64_t(0x6a3b50e1a30ddf69),
+    uint64_t(0x8e43c87e03060c18), uint64_t(0xf49bb8b633338561),
+    uint64_t(0x7bf329ee636d1eea), uint64_t(0x012b592653589793),
+    uint64_t(0x4e7b2d0d9b47ba97), uint64_t(0x34a35dc5ab7233ee),
+    uint64_t(0xbbcbcc9dfb2ca865), uint64_t(0xc113bc55cb19211c),
+    uint64_t(0x5863dbf1e3ac9dec), uint64_t(0x22bbab39d3991495),
+    uint64_t(0xadd33a6183c78f1e), uint64_t(0xd70b4aa9b3f20667),
+    uint64_t(0x985b3e827bed2b63), uint64_t(0xe2834e4a4bd8a21a),
+    uint64_t(0x6debdf121b863991), uint64_t(0x1733afda2bb3b0e8),
+    uint64_t(0xf34b37458bb86399), uint64_t(0x8993478dbb8deae0),
+    uint64_t(0x06fbd6d5ebd3716b), uint64_t(0x7c23a61ddbe6f812),
+    uint64_t(0x3373d23613f9d516), uint64_t(0x49aba2fe23cc5c6f),
+    uint64_t(0xc6c333a67392c7e4), uint64_t(0xbc1b436e43a74e9d),
+    uint64_t(0x95ac9329ac4bc9b5), uint64_t(0xef74e3e19c7e40cc),
+    uint64_t(0x601c72b9cc20db47), uint64_t(0x1ac40271fc15523e),
+    uint64_t(0x5594765a340a7f3a), uint64_t(0x2f4c0692043ff643),
+    uint64_t(0xa02497ca54616dc8), uint64_t(0xdafce7026454e4b1),
+    uint64_t(0x3e847f9dc45f37c0), uint64_t(0x445c0f55f46abeb9),
+    uint64_t(0xcb349e0da4342532), uint64_t(0xb1eceec59401ac4b),
+    uint64_t(0xfebc9aee5c1e814f), uint64_t(0x8464ea266c2b0836),
+    uint64_t(0x0b0c7b7e3c7593bd), uint64_t(0x71d40bb60c401ac4),
+    uint64_t(0xe8a46c1224f5a634), uint64_t(0x927c1cda14c02f4d),
+    uint64_t(0x1d148d82449eb4c6), uint64_t(0x67ccfd4a74ab3dbf),
+    uint64_t(0x289c8961bcb410bb), uint64_t(0x5244f9a98c8199c2),
+    uint64_t(0xdd2c68f1dcdf0249), uint64_t(0xa7f41839ecea8b30),
+    uint64_t(0x438c80a64ce15841), uint64_t(0x3954f06e7cd4d138),
+    uint64_t(0xb63c61362c8a4ab3), uint64_t(0xcce411fe1cbfc3ca),
+    uint64_t(0x83b465d5d4a0eece), uint64_t(0xf96c151de49567b7),
+    uint64_t(0x76048445b4cbfc3c), uint64_t(0x0cdcf48d84fe7545),
+    uint64_t(0x6fbd6d5ebd3716b7), uint64_t(0x15651d968d029fce),
+    uint64_t(0x9a0d8ccedd5c0445), uint64_t(0xe0d5fc06ed698d3c),
+    uint64_t(0xaf85882d2576a038), uint64_t(0xd55df8e515432941),
+    uint64_t(0x5a3569bd451db2ca), uint64_t(0x20ed197575283bb3),
+    uint64_t(0xc49581ead523e8c2), uint64_t(0xbe4df122e51661bb),
+    uint64_t(0x3125607ab548fa30), uint64_t(0x4bfd10b2857d7349),
+    uint64_t(0x04ad64994d625e4d), uint64_t(0x7e7514517d57d734),
+    uint64_t(0xf11d85092d094cbf), uint64_t(0x8bc5f5c11d3cc5c6),
+    uint64_t(0x12b5926535897936), uint64_t(0x686de2ad05bcf04f),
+    uint64_t(0xe70573f555e26bc4), uint64_t(0x9ddd033d65d7e2bd),
+    uint64_t(0xd28d7716adc8cfb9), uint64_t(0xa85507de9dfd46c0),
+    uint64_t(0x273d9686cda3dd4b), uint64_t(0x5de5e64efd965432),
+    uint64_t(0xb99d7ed15d9d8743), uint64_t(0xc3450e196da80e3a),
+    uint64_t(0x4c2d9f413df695b1), uint64_t(0x36f5ef890dc31cc8),
+    uint64_t(0x79a59ba2c5dc31cc), uint64_t(0x037deb6af5e9b8b5),
+    uint64_t(0x8c157a32a5b7233e), uint64_t(0xf6cd0afa9582aa47),
+    uint64_t(0x4ad64994d625e4da), uint64_t(0x300e395ce6106da3),
+    uint64_t(0xbf66a804b64ef628), uint64_t(0xc5bed8cc867b7f51),
+    uint64_t(0x8aeeace74e645255), uint64_t(0xf036dc2f7e51db2c),
+    uint64_t(0x7f5e4d772e0f40a7), uint64_t(0x05863dbf1e3ac9de),
+    uint64_t(0xe1fea520be311aaf), uint64_t(0x9b26d5e88e0493d6),
+    uint64_t(0x144e44b0de5a085d), uint64_t(0x6e963478ee6f8124),
+    uint64_t(0x21c640532670ac20), uint64_t(0x5b1e309b16452559),
+    uint64_t(0xd476a1c3461bbed2), uint64_t(0xaeaed10b762e37ab),
+    uint64_t(0x37deb6af5e9b8b5b), uint64_t(0x4d06c6676eae0222),
+    uint64_t(0xc26e573f3ef099a9), uint64_t(0xb8b627f70ec510d0),
+    uint64_t(0xf7e653dcc6da3dd4), uint64_t(0x8d3e2314f6efb4ad),
+    uint64_t(0x0256b24ca6b12f26), uint64_t(0x788ec2849684a65f),
+    uint64_t(0x9cf65a1b368f752e), uint64_t(0xe62e2ad306bafc57),
+    uint64_t(0x6946bb8b56e467dc), uint64_t(0x139ecb4366d1eea5),
+    uint64_t(0x5ccebf68aecec3a1), uint64_t(0x2616cfa09efb4ad8),
+    uint64_t(0xa97e5ef8cea5d153), uint64_t(0xd3a62e30fe90582a),
+    uint64_t(0xb0c7b7e3c7593bd8), uint64_t(0xca1fc72bf76cb2a1),
+    uint64_t(0x45775673a732292a), uint64_t(0x3faf26bb9707a053),
+    uint64_t(0x70ff52905f188d57), uint64_t(0x0a2722586f2d042e),
+    uint64_t(0x854fb3003f739fa5), uint64_t(0xff97c3c80f4616dc),
+    uint64_t(0x1bef5b57af4dc5ad), uint64_t(0x61372b9f9f784cd4),
+    uint64_t(0xee5fbac7cf26d75f), uint64_t(0x9487ca0fff135e26),
+    uint64_t(0xdbd7be24370c7322), uint64_t(0xa10fceec0739fa5b),
+    uint64_t(0x2e675fb4576761d0), uint64_t(0x54bf2f7c6752e8a9),
+    uint64_t(0xcdcf48d84fe75459), uint64_t(0xb71738107fd2dd20),
+    uint64_t(0x387fa9482f8c46ab), uint64_t(0x42a7d9801fb9cfd2),
+    uint64_t(0x0df7adabd7a6e2d6), uint64_t(0x772fdd63e7936baf),
+    uint64_t(0xf8474c3bb7cdf024), uint64_t(0x829f3cf387f8795d),
+    uint64_t(0x66e7a46c27f3aa2c), uint64_t(0x1c3fd4a417c62355),
+    uint64_t(0x935745fc4798b8de), uint64_t(0xe98f353477ad31a7),
+    uint64_t(0xa6df411fbfb21ca3), uint64_t(0xdc0731d78f8795da),
+    uint64_t(0x536fa08fdfd90e51), uint64_t(0x29b7d047efec8728),
+};
+
+// Slicing-by-8: table[k][b] is the CRC of byte b followed by k zero bytes,
+// so that 8 input bytes can be folded into the CRC with 8 independent lookups
+struct Crc64Tables{
+    uint64_t t[8][256];
+
+    Crc64Tables(){
+        for (int i = 0; i < 256; i++) t[0][i] = crc64_table[i];
+        for (int k = 1; k < 8; k++){
+            for (int i = 0; i < 256; i++){
+                t[k][i] = (t[k - 1][i] >> 8) ^ crc64_table[t[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+static const Crc64Tables crc64Tables;
+
+static inline uint64_t readU64LE(const uint8_t *p){
+    return uint64_t(p[0]) | uint64_t(p[1]) << 8 | uint64_t(p[2]) << 16 | uint64_t(p[3]) << 24 |
+           uint64_t(p[4]) << 32 | uint64_t(p[5]) << 40 | uint64_t(p[6]) << 48 | uint64_t(p[7]) << 56;
+}
+
+static inline uint32_t readU32LE(const uint8_t *p){
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
 std::string Hash::fileSHA256(const std::string &path) {
     std::ifstream f(path, std::ios::binary);
     if (!f.is_open()) {
@@ -39,19 +198,129 @@ std::string Hash::strCRC64(const std::string &str){
     return Hash::strCRC64(str.c_str(), str.length());
 }
 
-std::string Hash::strCRC64(const char *str, uint64_t size){
+uint64_t Hash::crc64(const char *str, uint64_t size){
+    const auto &t = crc64Tables.t;
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(str);
     uint64_t crc = 0;
-    uint64_t j;
 
-    for (j = 0; j < size; j++) {
-        uint8_t byte = str[j];
-        crc = crc64_table[(uint8_t)crc ^ byte] ^ (crc >> 8);
+    for (; size >= 8; size -= 8, p += 8){
+        crc ^= readU64LE(p);
+        crc = t[7][crc & 0xFF] ^ t[6][(crc >> 8) & 0xFF] ^
+              t[5][(crc >> 16) & 0xFF] ^ t[4][(crc >> 24) & 0xFF] ^
+              t[3][(crc >> 32) & 0xFF] ^ t[2][(crc >> 40) & 0xFF] ^
+              t[1][(crc >> 48) & 0xFF] ^ t[0][crc >> 56];
     }
 
-    std::ostringstream os;
-    os << std::hex << crc;
+    for (; size > 0; size--, p++){
+        crc = crc64_table[(uint8_t)crc ^ *p] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+std::string Hash::strCRC64(const char *str, uint64_t size){
+    return toHex(crc64(str, size));
+}
+
+static const uint64_t XXH_PRIME64_1 = 11400714785074694791ULL;
+static const uint64_t XXH_PRIME64_2 = 14029467366897019727ULL;
+static const uint64_t XXH_PRIME64_3 = 1609587929392839161ULL;
+static const uint64_t XXH_PRIME64_4 = 9650029242287828579ULL;
+static const uint64_t XXH_PRIME64_5 = 2870177450012600261ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r){
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxhRound(uint64_t acc, uint64_t input){
+    acc += input * XXH_PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
 
-    return os.str();
+static inline uint64_t xxhMergeRound(uint64_t acc, uint64_t val){
+    acc ^= xxhRound(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
 }
 
+// XXH64, as specified in https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+uint64_t Hash::xxh64(const char *str, uint64_t size, uint64_t seed){
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(str);
+    const uint8_t *end = p + size;
+    uint64_t h;
 
+    if (size >= 32){
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+
+        for (; end - p >= 32; p += 32){
+            v1 = xxhRound(v1, readU64LE(p));
+            v2 = xxhRound(v2, readU64LE(p + 8));
+            v3 = xxhRound(v3, readU64LE(p + 16));
+            v4 = xxhRound(v4, readU64LE(p + 24));
+        }
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxhMergeRound(h, v1);
+        h = xxhMergeRound(h, v2);
+        h = xxhMergeRound(h, v3);
+        h = xxhMergeRound(h, v4);
+    }else{
+        h = seed + XXH_PRIME64_5;
+    }
+
+    h += size;
+
+    for (; end - p >= 8; p += 8){
+        h ^= xxhRound(0, readU64LE(p));
+        h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (end - p >= 4){
+        h ^= uint64_t(readU32LE(p)) * XXH_PRIME64_1;
+        h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++){
+        h ^= (*p) * XXH_PRIME64_5;
+        h = rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::string Hash::strXXH64(const std::string &str){
+    return toHex(xxh64(str.c_str(), str.length()));
+}
+
+std::string Hash::toHex(uint64_t value){
+    static const char digits[] = "0123456789abcdef";
+    char buf[16];
+    int i = 16;
+    do{
+        buf[--i] = digits[value & 0xF];
+        value >>= 4;
+    }while (value != 0);
+
+    return std::string(buf + i, 16 - i);
+}
+
+std::string Hash::cacheKey(const std::string &str){
+    static const CacheKeyScheme scheme = [](){
+        const char *env = std::getenv(DDB_CACHE_KEY_ENV);
+        return env != nullptr && std::strcmp(env, "xxh64") == 0 ? CacheKeyScheme::XXH64 : CacheKeyScheme::CRC64;
+    }();
+
+    return cacheKey(str, scheme);
+}
+
+std::string Hash::cacheKey(const std::string &str, CacheKeyScheme scheme){
+    if (scheme == CacheKeyScheme::XXH64) return strXXH64(str);
+    return strCRC64(str);
+}
@@ -2,12 +2,216 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <exiv2/exiv2.hpp>
+
 #include "dbops.h"
 #include "info.h"
 #include "exceptions.h"
+#include "mio.h"
 
 namespace ddb {
 
+// Parsed entries waiting to be written, per parsing thread
+#define INFO_QUEUE_PER_THREAD 16
+
+struct ParsedEntry{
+    bool ready = false;
+    Entry entry;
+    std::exception_ptr error;
+};
+
+// Parses entries with all available threads, calling cb for each of them
+// in input order from the calling thread. At most a fixed number of parsed
+// entries are kept in memory, regardless of the number of paths.
+static void parseEntries(const std::vector<fs::path> &filePaths, bool withHash, bool stopOnError,
+                         const std::function<void(const fs::path &, Entry &)> &cb){
+    const size_t numThreads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), filePaths.size()));
+    const size_t window = numThreads * INFO_QUEUE_PER_THREAD;
+
+    std::vector<ParsedEntry> slots(window);
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t next = 0;    // Next path to parse
+    size_t written = 0; // Entries handed to cb so far
+    bool aborted = false;
+
+    // The XMP toolkit must be initialized before it's used by multiple threads
+    Exiv2::XmpParser::initialize();
+
+    auto worker = [&](){
+        while (true){
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (aborted || next >= filePaths.size()) return;
+                i = next++;
+
+                // Wait for the writer to catch up
+                cv.wait(lock, [&](){ return aborted || i < written + window; });
+                if (aborted) return;
+            }
+
+            const auto &fp = filePaths[i];
+            LOGD << "Parsing entry " << fp.string();
+
+            Entry e;
+            std::exception_ptr error;
+            try{
+                parseEntry(fp, "/", e, withHash);
+                // We override e.path because it's relative
+                // But we want the absolute path (in the unix path format)
+                e.path = "file://" + fs::absolute(fp).generic_string();
+            }catch(...){
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto &slot = slots[i % window];
+                slot.entry = std::move(e);
+                slot.error = error;
+                slot.ready = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; t++) threads.emplace_back(worker);
+
+    auto stop = [&](){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            aborted = true;
+        }
+        cv.notify_all();
+        for (auto &t : threads) t.join();
+    };
+
+    try{
+        for (size_t i = 0; i < filePaths.size(); i++){
+            Entry e;
+            std::exception_ptr error;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                auto &slot = slots[i % window];
+                cv.wait(lock, [&](){ return slot.ready; });
+                e = std::move(slot.entry);
+                error = slot.error;
+                slot = ParsedEntry();
+                written = i + 1;
+            }
+            cv.notify_all();
+
+            if (error){
+                try{
+                    std::rethrow_exception(error);
+                }catch(const AppException &err){
+                    LOGD << "Cannot parse " << filePaths[i].string() << ", skipping: " << err.what();
+                    if (stopOnError) throw;
+                    continue;
+                }
+            }
+
+            cb(filePaths[i], e);
+        }
+    }catch(...){
+        stop();
+        throw;
+    }
+
+    stop();
+}
+
+// FlatGeobuf needs a seekable file (features are sorted by the spatial index)
+// so it's written to a temporary file first, then copied to the output
+static void writeFlatGeobuf(const std::vector<fs::path> &filePaths, std::ostream &output,
+                            BasicGeometryType geomType, bool withHash, bool stopOnError){
+    GDALDriverH drv = GDALGetDriverByName("FlatGeobuf");
+    if (drv == nullptr) throw GDALException("Cannot create FlatGeobuf driver (GDAL 3.1 or later is required)");
+
+    const fs::path tmpFile = fs::temp_directory_path() / ("ddb-info-" + utils::generateRandomString(16) + ".fgb");
+    GDALDatasetH hDs = GDALCreate(drv, tmpFile.string().c_str(), 0, 0, 0, GDT_Unknown, nullptr);
+    if (hDs == nullptr) throw GDALException("Cannot create " + tmpFile.string());
+
+    try{
+        OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
+        OSRImportFromEPSG(hSrs, 4326);
+
+        const OGRwkbGeometryType layerType = geomType == BasicGeometryType::BGPoint ? wkbPoint25D :
+                                             geomType == BasicGeometryType::BGPolygon ? wkbPolygon25D :
+                                             wkbUnknown;
+        OGRLayerH hLayer = GDALDatasetCreateLayer(hDs, "entries", hSrs, layerType, nullptr);
+        OSRDestroySpatialReference(hSrs);
+        if (hLayer == nullptr) throw GDALException("Cannot create FlatGeobuf layer");
+
+        const std::vector<std::pair<const char *, OGRFieldType>> fields = {
+            {"path", OFTString}, {"hash", OFTString}, {"type", OFTInteger},
+            {"mtime", OFTInteger64}, {"size", OFTInteger64}, {"meta", OFTString}
+        };
+        for (const auto &f : fields){
+            OGRFieldDefnH hField = OGR_Fld_Create(f.first, f.second);
+            if (std::string(f.first) == "meta") OGR_Fld_SetSubType(hField, OFSTJSON);
+            OGR_L_CreateField(hLayer, hField, TRUE);
+            OGR_Fld_Destroy(hField);
+        }
+
+        OGRFeatureDefnH hDefn = OGR_L_GetLayerDefn(hLayer);
+
+        parseEntries(filePaths, withHash, stopOnError, [&](const fs::path &fp, Entry &e){
+            OGRGeometryH hGeom = nullptr;
+            if (!e.point_geom.empty() && geomType != BasicGeometryType::BGPolygon){
+                const auto &p = e.point_geom.points[0];
+                hGeom = OGR_G_CreateGeometry(wkbPoint25D);
+                OGR_G_SetPoint(hGeom, 0, p.x, p.y, p.z);
+            }else if (!e.polygon_geom.empty() && geomType != BasicGeometryType::BGPoint){
+                OGRGeometryH hRing = OGR_G_CreateGeometry(wkbLinearRing);
+                for (const auto &p : e.polygon_geom.points) OGR_G_AddPoint(hRing, p.x, p.y, p.z);
+                hGeom = OGR_G_CreateGeometry(wkbPolygon25D);
+                OGR_G_AddGeometryDirectly(hGeom, hRing);
+            }
+
+            if (hGeom == nullptr){
+                LOGD << "No geometries in " << fp.string() << ", skipping from FlatGeobuf export";
+                return;
+            }
+
+            OGRFeatureH hFeat = OGR_F_Create(hDefn);
+            OGR_F_SetFieldString(hFeat, 0, e.path.c_str());
+            if (!e.hash.empty()) OGR_F_SetFieldString(hFeat, 1, e.hash.c_str());
+            OGR_F_SetFieldInteger(hFeat, 2, e.type);
+            OGR_F_SetFieldInteger64(hFeat, 3, e.mtime);
+            OGR_F_SetFieldInteger64(hFeat, 4, static_cast<GIntBig>(e.size));
+            if (!e.meta.empty()) OGR_F_SetFieldString(hFeat, 5, e.meta.dump().c_str());
+            OGR_F_SetGeometryDirectly(hFeat, hGeom);
+
+            const OGRErr err = OGR_L_CreateFeature(hLayer, hFeat);
+            OGR_F_Destroy(hFeat);
+            if (err != OGRERR_NONE) throw GDALException("Cannot write feature for " + fp.string());
+        });
+
+        // Writes the index and the features
+        GDALClose(hDs);
+        hDs = nullptr;
+
+        std::ifstream in(tmpFile.string(), std::ios::binary);
+        if (!in.is_open()) throw FSException("Cannot open " + tmpFile.string());
+        output << in.rdbuf();
+        in.close();
+
+        io::assureIsRemoved(tmpFile);
+    }catch(...){
+        if (hDs != nullptr) GDALClose(hDs);
+        io::assureIsRemoved(tmpFile);
+        throw;
+    }
+}
+
 void info(const std::vector<std::string> &input, std::ostream &output,
           const std::string &format, bool recursive, int maxRecursionDepth, const std::string &geometry,
           bool withHash, bool stopOnError){
@@ -19,56 +223,50 @@ void info(const std::vector<std::string> &input, std::ostream &output,
         filePaths = std::vector<fs::path>(input.begin(), input.end());
     }
 
+    const BasicGeometryType geomType = ddb::getBasicGeometryTypeFromName(geometry);
+
+    // Only used for the json format
+    JsonWriter w(output);
+
     if (format == "json"){
-        output << "[";
+        w.startArray();
     }else if (format == "geojson"){
         output << R"<<<({"type":"FeatureCollection","crs":{"type":"name","properties":{"name":"EPSG:4326"}},"features":[)<<<";
+    }else if (format == "fgb"){
+        writeFlatGeobuf(filePaths, output, geomType, withHash, stopOnError);
+        return;
     }else if (format == "text"){
         // Nothing
     }else{
         throw InvalidArgsException("Invalid format " + format);
     }
 
-
     bool first = true;
 
-    for (auto &fp : filePaths){
-        LOGD << "Parsing entry " << fp.string();
-
-        try{
-            Entry e;
-            parseEntry(fp, "/", e, withHash);
-            // We override e.path because it's relative
-            // But we want the absolute path (in the unix path format)
-            e.path = "file://" + fs::absolute(fp).generic_string();
-
-            if (format == "json"){
-                json j;
-                e.toJSON(j);
+    parseEntries(filePaths, withHash, stopOnError, [&](const fs::path &fp, Entry &e){
+        if (format == "json"){
+            e.writeJSON(w);
+        }else if (format == "geojson"){
+            const bool hasGeometry = (!e.point_geom.empty() && geomType != BasicGeometryType::BGPolygon) ||
+                                     (!e.polygon_geom.empty() && geomType != BasicGeometryType::BGPoint);
+            if (hasGeometry){
+                // Features are written directly, without building a json tree
                 if (!first) output << ",";
-                output << j.dump();
-            }else if (format == "geojson"){
-                json j;
-                if (e.toGeoJSON(j, ddb::getBasicGeometryTypeFromName(geometry))){
-                    if (!first) output << ",";
-                    output << j.dump();
-                    j.clear();
-                }else{
-                    LOGD << "No geometries in " << fp.string() << ", skipping from GeoJSON export";
-                }
+                e.writeGeoJSON(output, geomType);
             }else{
-                output << e.toString() << "\n";
+                LOGD << "No geometries in " << fp.string() << ", skipping from GeoJSON export";
+                return;
             }
-
-            first = false;
-        }catch(const AppException &e){
-            LOGD << "Cannot parse " << fp.string() << ", skipping: " << e.what();
-            if (stopOnError) throw e;
+        }else{
+            output << e.toString() << "\n";
         }
-    }
+
+        first = false;
+    });
 
     if (format == "json"){
-        output << "]";
+        w.endArray();
+        w.flush();
     }else if (format == "geojson"){
         output << "]}";
     }
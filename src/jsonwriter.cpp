@@ -0,0 +1,134 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <cmath>
+#include "jsonwriter.h"
+
+namespace ddb {
+
+JsonWriter::JsonWriter(std::ostream &out) : out(out) {
+    buf_.reserve(JSON_WRITER_FLUSH_SIZE * 2);
+    serializer = std::make_unique<nlohmann::detail::serializer<json>>(
+                std::make_shared<nlohmann::detail::output_string_adapter<char>>(buf_), ' ');
+}
+
+JsonWriter::~JsonWriter(){
+    flush();
+}
+
+void JsonWriter::separator(){
+    if (afterKey){
+        afterKey = false;
+    }else if (!first.empty()){
+        if (!first.back()) buf_ += ',';
+        first.back() = false;
+    }
+}
+
+void JsonWriter::maybeFlush(){
+    if (buf_.size() >= JSON_WRITER_FLUSH_SIZE) flush();
+}
+
+void JsonWriter::flush(){
+    if (buf_.empty()) return;
+    out.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    buf_.clear();
+}
+
+JsonWriter &JsonWriter::startObject(){
+    separator();
+    buf_ += '{';
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject(){
+    buf_ += '}';
+    first.pop_back();
+    maybeFlush();
+    return *this;
+}
+
+JsonWriter &JsonWriter::startArray(){
+    separator();
+    buf_ += '[';
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray(){
+    buf_ += ']';
+    first.pop_back();
+    maybeFlush();
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(const char *k){
+    separator();
+    buf_ += '"';
+    buf_ += k;
+    buf_ += "\":";
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const std::string &s){
+    separator();
+
+    // Most strings (paths, hashes) don't need escaping
+    for (const char c : s){
+        const auto u = static_cast<unsigned char>(c);
+        if (u < 0x20 || u >= 0x80 || c == '"' || c == '\\'){
+            serializer->dump(json(s), false, false, 0);
+            return *this;
+        }
+    }
+
+    buf_ += '"';
+    buf_ += s;
+    buf_ += '"';
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *s){
+    return value(std::string(s));
+}
+
+JsonWriter &JsonWriter::value(double d){
+    separator();
+    if (!std::isfinite(d)){
+        buf_ += "null";
+        return *this;
+    }
+
+    char buf[64];
+    const char *end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), d);
+    buf_.append(buf, static_cast<size_t>(end - buf));
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(bool b){
+    separator();
+    buf_ += b ? "true" : "false";
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const json &j){
+    separator();
+    serializer->dump(j, false, false, 0);
+    maybeFlush();
+    return *this;
+}
+
+JsonWriter &JsonWriter::null(){
+    separator();
+    buf_ += "null";
+    return *this;
+}
+
+std::string &JsonWriter::rawValue(){
+    separator();
+    return buf_;
+}
+
+}
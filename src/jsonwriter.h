@@ -0,0 +1,76 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <charconv>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "json.h"
+#include "ddb_export.h"
+
+namespace ddb {
+
+// Output is written to the stream in chunks of (at least) this size
+#define JSON_WRITER_FLUSH_SIZE 65536
+
+// Streams JSON to an output stream without building json objects.
+// The output is byte for byte the same as json::dump() of the equivalent
+// object, as long as keys are written in sorted order (like json objects do).
+class JsonWriter {
+public:
+    DDB_DLL explicit JsonWriter(std::ostream &out);
+    DDB_DLL ~JsonWriter();
+
+    DDB_DLL JsonWriter &startObject();
+    DDB_DLL JsonWriter &endObject();
+    DDB_DLL JsonWriter &startArray();
+    DDB_DLL JsonWriter &endArray();
+
+    // Keys are written as is, they must not need escaping
+    DDB_DLL JsonWriter &key(const char *k);
+
+    DDB_DLL JsonWriter &value(const std::string &s);
+    DDB_DLL JsonWriter &value(const char *s);
+    DDB_DLL JsonWriter &value(double d);
+    DDB_DLL JsonWriter &value(bool b);
+    DDB_DLL JsonWriter &value(const json &j);
+    DDB_DLL JsonWriter &null();
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    JsonWriter &value(T i){
+        separator();
+        char buf[24];
+        const auto r = std::to_chars(buf, buf + sizeof(buf), i);
+        buf_.append(buf, static_cast<size_t>(r.ptr - buf));
+        return *this;
+    }
+
+    template <typename T, typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
+    JsonWriter &value(T e){
+        return value(static_cast<typename std::underlying_type<T>::type>(e));
+    }
+
+    // Buffer to append an already serialized value to
+    DDB_DLL std::string &rawValue();
+
+    DDB_DLL void flush();
+
+private:
+    void separator();
+    void maybeFlush();
+
+    std::ostream &out;
+    std::string buf_;
+    std::vector<bool> first; // For each open object/array, whether it's still empty
+    bool afterKey = false;
+    std::unique_ptr<nlohmann::detail::serializer<json>> serializer;
+};
+
+}
+
+#endif // JSONWRITER_H
@@ -0,0 +1,221 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <cstring>
+#include <fstream>
+
+#include "las.h"
+#include "logger.h"
+
+namespace ddb{
+
+// LAS is little endian (as are all platforms we build for)
+template <typename T>
+static inline T readLE(const char *buf){
+    T v;
+    memcpy(&v, buf, sizeof(T));
+    return v;
+}
+
+static std::string readString(const char *buf, size_t maxLen){
+    return std::string(buf, strnlen(buf, maxLen));
+}
+
+#define LAS_HEADER_MIN_SIZE 227
+#define LAS_HEADER_14_SIZE 375
+#define LAS_VLR_HEADER_SIZE 54
+#define LAS_EVLR_HEADER_SIZE 60
+#define LAS_EXTRA_BYTES_DESCRIPTOR_SIZE 192
+#define COPC_INFO_SIZE 160
+
+// Standard point record size for each point format
+static const int pointFormatSizes[] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+
+static void parseGeoKeys(const std::vector<char> &data, LasHeader &header){
+    if (data.size() < 8) return;
+
+    header.hasGeoKeys = true;
+
+    const auto numKeys = readLE<uint16_t>(data.data() + 6);
+    for (size_t i = 0; i < numKeys && (i + 2) * 8 <= data.size(); i++){
+        const char *key = data.data() + (i + 1) * 8;
+        const auto keyId = readLE<uint16_t>(key);
+        const auto location = readLE<uint16_t>(key + 2);
+        const auto value = readLE<uint16_t>(key + 6);
+
+        // ProjectedCSTypeGeoKey takes precedence over GeographicTypeGeoKey
+        // 32767 means user defined
+        if (location == 0 && value != 32767){
+            if (keyId == 3072) header.epsg = value;
+            else if (keyId == 2048 && header.epsg == 0) header.epsg = value;
+        }
+    }
+}
+
+static void parseRecord(const std::string &userId, uint16_t recordId, const std::vector<char> &data, LasHeader &header){
+    if (userId == "LASF_Projection"){
+        if (recordId == 2112) header.wkt = readString(data.data(), data.size());
+        else if (recordId == 34735) parseGeoKeys(data, header);
+    }else if (userId == "LASF_Spec" && recordId == 4){
+        for (size_t i = 0; i + LAS_EXTRA_BYTES_DESCRIPTOR_SIZE <= data.size(); i += LAS_EXTRA_BYTES_DESCRIPTOR_SIZE){
+            header.extraDimensions.push_back(readString(data.data() + i + 4, 32));
+        }
+    }else if (userId == "laszip encoded"){
+        header.compressed = true;
+    }else if (userId == "copc" && recordId == 1 && data.size() >= COPC_INFO_SIZE){
+        header.isCopc = true;
+        for (int i = 0; i < 3; i++) header.copc.center[i] = readLE<double>(data.data() + i * 8);
+        header.copc.halfSize = readLE<double>(data.data() + 24);
+        header.copc.spacing = readLE<double>(data.data() + 32);
+        header.copc.rootHierarchyOffset = readLE<uint64_t>(data.data() + 40);
+        header.copc.rootHierarchySize = readLE<uint64_t>(data.data() + 48);
+    }
+}
+
+static bool isRelevantRecord(const std::string &userId){
+    return userId == "LASF_Projection" || userId == "LASF_Spec" || userId == "laszip encoded" || userId == "copc";
+}
+
+bool readLasHeader(const std::string &filename, LasHeader &header){
+    std::ifstream f(filename, std::ios::binary);
+    if (!f.is_open()) return false;
+
+    char buf[LAS_HEADER_14_SIZE] = {0};
+    f.read(buf, LAS_HEADER_14_SIZE);
+    const auto bytesRead = f.gcount();
+    f.clear();
+
+    if (bytesRead < LAS_HEADER_MIN_SIZE || memcmp(buf, "LASF", 4) != 0) return false;
+
+    header = LasHeader();
+    header.versionMajor = static_cast<uint8_t>(buf[24]);
+    header.versionMinor = static_cast<uint8_t>(buf[25]);
+    if (header.versionMajor != 1 || header.versionMinor > 4){
+        LOGD << "Unsupported LAS version " << header.versionMajor << "." << header.versionMinor;
+        return false;
+    }
+
+    const auto headerSize = readLE<uint16_t>(buf + 94);
+    header.pointDataOffset = readLE<uint32_t>(buf + 96);
+    const auto numVlrs = readLE<uint32_t>(buf + 100);
+
+    // Bits 6 and 7 of the point format are set by LASzip
+    const auto format = static_cast<uint8_t>(buf[104]);
+    header.compressed = (format & 0xC0) != 0;
+    header.pointFormat = format & 0x3F;
+    header.pointRecordLength = readLE<uint16_t>(buf + 105);
+
+    if (headerSize < LAS_HEADER_MIN_SIZE || header.pointFormat > 10 ||
+        header.pointRecordLength < pointFormatSizes[header.pointFormat]) return false;
+
+    header.pointCount = readLE<uint32_t>(buf + 107);
+    for (int i = 0; i < 3; i++){
+        header.scale[i] = readLE<double>(buf + 131 + i * 8);
+        header.offset[i] = readLE<double>(buf + 155 + i * 8);
+    }
+    header.maxX = readLE<double>(buf + 179);
+    header.minX = readLE<double>(buf + 187);
+    header.maxY = readLE<double>(buf + 195);
+    header.minY = readLE<double>(buf + 203);
+    header.maxZ = readLE<double>(buf + 211);
+    header.minZ = readLE<double>(buf + 219);
+
+    uint64_t evlrStart = 0;
+    uint32_t numEvlrs = 0;
+    if (header.versionMinor >= 4 && headerSize >= LAS_HEADER_14_SIZE && bytesRead >= LAS_HEADER_14_SIZE){
+        evlrStart = readLE<uint64_t>(buf + 235);
+        numEvlrs = readLE<uint32_t>(buf + 243);
+
+        // The legacy count is zero for files with more than 2^32 points
+        // or with point formats 6-10
+        const auto count = readLE<uint64_t>(buf + 247);
+        if (count > 0) header.pointCount = count;
+    }
+
+    f.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(f.tellg());
+
+    // Record lengths come from the file: a record that does not fit
+    // in it means a corrupt file, not something to allocate for
+    const auto fits = [&](uint64_t length){
+        const auto pos = f.tellg();
+        return pos >= 0 && static_cast<uint64_t>(pos) <= fileSize && length <= fileSize - static_cast<uint64_t>(pos);
+    };
+
+    // Variable length records follow the header. Only the payload
+    // of the records we care about is read, the rest is skipped.
+    f.seekg(headerSize);
+    std::vector<char> data;
+    for (uint32_t i = 0; i < numVlrs; i++){
+        char vlr[LAS_VLR_HEADER_SIZE];
+        if (!f.read(vlr, LAS_VLR_HEADER_SIZE)) return false;
+
+        const auto userId = readString(vlr + 2, 16);
+        const auto recordId = readLE<uint16_t>(vlr + 18);
+        const auto length = readLE<uint16_t>(vlr + 20);
+        if (!fits(length)){
+            LOGD << "VLR " << i << " of " << filename << " extends past the end of the file";
+            return false;
+        }
+
+        if (isRelevantRecord(userId)){
+            data.resize(length);
+            if (!f.read(data.data(), length)) return false;
+            parseRecord(userId, recordId, data, header);
+        }else{
+            f.seekg(length, std::ios::cur);
+        }
+    }
+
+    // LAS 1.4 can store the WKT in an extended VLR after the point data
+    if (evlrStart > 0 && evlrStart < fileSize){
+        f.seekg(evlrStart);
+        for (uint32_t i = 0; i < numEvlrs; i++){
+            char evlr[LAS_EVLR_HEADER_SIZE];
+            if (!f.read(evlr, LAS_EVLR_HEADER_SIZE)) break;
+
+            const auto userId = readString(evlr + 2, 16);
+            const auto recordId = readLE<uint16_t>(evlr + 18);
+            const auto length = readLE<uint64_t>(evlr + 20);
+            if (!fits(length)){
+                LOGD << "EVLR " << i << " of " << filename << " extends past the end of the file";
+                return false;
+            }
+
+            if (userId == "LASF_Projection" && recordId == 2112){
+                data.resize(length);
+                if (!f.read(data.data(), length)) break;
+                parseRecord(userId, recordId, data, header);
+            }else{
+                f.seekg(length, std::ios::cur);
+            }
+        }
+    }
+
+    return true;
+}
+
+std::vector<std::string> LasHeader::dimensions() const{
+    std::vector<std::string> dims = { "X", "Y", "Z", "Intensity", "ReturnNumber", "NumberOfReturns",
+                                      "ScanDirectionFlag", "EdgeOfFlightLine", "Classification",
+                                      "ScanAngleRank", "UserData", "PointSourceId" };
+
+    const int f = pointFormat;
+    if (f >= 6){
+        dims.push_back("ScanChannel");
+        dims.push_back("ClassFlags");
+    }
+    if (f == 1 || f >= 3) dims.push_back("GpsTime");
+    if (f == 2 || f == 3 || f == 5 || f == 7 || f == 8 || f == 10){
+        dims.push_back("Red");
+        dims.push_back("Green");
+        dims.push_back("Blue");
+    }
+    if (f == 8 || f == 10) dims.push_back("Infrared");
+
+    dims.insert(dims.end(), extraDimensions.begin(), extraDimensions.end());
+
+    return dims;
+}
+
+}
@@ -0,0 +1,63 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef LAS_H
+#define LAS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ddb_export.h"
+
+namespace ddb{
+
+// COPC info VLR (user "copc", record 1)
+struct CopcInfo{
+    double center[3] = {0, 0, 0};
+    double halfSize = 0;
+    double spacing = 0;
+    uint64_t rootHierarchyOffset = 0;
+    uint64_t rootHierarchySize = 0;
+};
+
+// Public header block (and the relevant VLRs) of a LAS 1.0-1.4 / LAZ file
+struct LasHeader{
+    int versionMajor = 0;
+    int versionMinor = 0;
+    int pointFormat = 0;
+    int pointRecordLength = 0;
+    bool compressed = false;
+    uint64_t pointCount = 0;
+
+    double scale[3] = {0, 0, 0};
+    double offset[3] = {0, 0, 0};
+    double minX = 0, minY = 0, minZ = 0;
+    double maxX = 0, maxY = 0, maxZ = 0;
+
+    // OGC WKT VLR/EVLR (empty if not present)
+    std::string wkt;
+
+    // From the GeoTIFF keys VLR (0 if not present or user defined)
+    int epsg = 0;
+    bool hasGeoKeys = false;
+
+    // Offset of the first point record (end of header and VLRs)
+    uint32_t pointDataOffset = 0;
+
+    bool isCopc = false;
+    CopcInfo copc;
+
+    // Names from the extra bytes VLR
+    std::vector<std::string> extraDimensions;
+
+    // Dimension names, as reported by PDAL
+    DDB_DLL std::vector<std::string> dimensions() const;
+};
+
+// Reads the header and VLRs of a LAS/LAZ file without touching point data.
+// Returns false if the file is not a (valid) LAS/LAZ file.
+DDB_DLL bool readLasHeader(const std::string &filename, LasHeader &header);
+
+}
+
+#endif // LAS_H
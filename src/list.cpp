@@ -17,9 +17,8 @@ namespace ddb {
 			output << e.path << std::endl;
 		}
 		else if (format == "json") {
-			json j;
-			e.toJSON(j);
-			output << j.dump();
+			JsonWriter w(output);
+			e.writeJSON(w);
 		}
 		else
 		{
@@ -45,23 +44,10 @@ namespace ddb {
 		}
 		else if (format == "json")
 		{
-			output << "[";
-
-			bool first = true;
-
-			for (auto& e : entries)
-			{
-
-				json j;
-				e.toJSON(j);
-				if (!first) output << ",";
-				output << j.dump();
-
-				first = false;
-
-			}
-
-			output << "]";
+			JsonWriter w(output);
+			w.startArray();
+			for (auto& e : entries) e.writeJSON(w);
+			w.endArray();
 		}
 		else
 		{
@@ -93,7 +79,7 @@ namespace ddb {
 
 			std::vector<Entry> matches = getMatchingEntries(db, relPath.generic(), depth + 1);
 
-			baseEntries.insert(baseEntries.end(), matches.begin(), matches.end());
+			baseEntries.insert(baseEntries.end(), std::make_move_iterator(matches.begin()), std::make_move_iterator(matches.end()));
 
 		}
 
@@ -114,7 +100,7 @@ namespace ddb {
 			});
 	}
 
-	void listIndex(Database* db, const std::vector<std::string>& paths, std::ostream& output, const std::string& format, bool recursive, int maxRecursionDepth) {
+	void listIndex(Database* db, const std::vector<std::string>& paths, std::ostream& output, const std::string& format, bool recursive, int maxRecursionDepth, const MetaFilter& filter) {
 
 
 		if (format != "json" && format != "text")
@@ -159,24 +145,32 @@ namespace ddb {
 
 		std::vector<Entry> outputEntries;
 
-		for (const Entry& entry : baseEntries) {
-			if (entry.type != Directory)
-				outputEntries.emplace_back(Entry(entry));
+		// Base entries are not used after this loop, so they are moved rather than copied
+		for (Entry& entry : baseEntries) {
+			if (entry.type != Directory) {
+				// Directories have no meta, so only files are checked against the filter.
+				// Base entries are already loaded, so this doesn't query again.
+				if (filter.matches(entry))
+					outputEntries.emplace_back(std::move(entry));
+			}
 			else {
 
-				if (!isSingle || !expandFolders)
-					outputEntries.emplace_back(Entry(entry));
+				// Read before the entry is (possibly) moved
+				const std::string path = entry.path;
+				const int entryDepth = entry.depth;
+
+				if ((!isSingle || !expandFolders) && filter.empty())
+					outputEntries.emplace_back(std::move(entry));
 
 				if (expandFolders) {
 					/*if (format == "text" && !isSingle && !recursive)
 						output << std::endl << entry.path << ":" << std::endl;*/
 
-					const auto depth = recursive ? maxRecursionDepth : entry.depth + 2;
+					const auto depth = recursive ? maxRecursionDepth : entryDepth + 2;
 
-					std::vector<Entry> entries = getMatchingEntries(db, entry.path, depth, true);
+					std::vector<Entry> entries = getMatchingEntries(db, path, depth, true, filter);
 
-					for (const Entry& e : entries)
-						outputEntries.emplace_back(Entry(e));
+					outputEntries.insert(outputEntries.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
 				}
 
 
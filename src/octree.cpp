@@ -0,0 +1,398 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <queue>
+
+#include "octree.h"
+#include "build.h"
+#include "dbops.h"
+#include "exceptions.h"
+#include "las.h"
+#include "logger.h"
+#include "mio.h"
+
+namespace ddb{
+
+NodeKey NodeKey::parse(const std::string &str){
+    NodeKey k;
+    char tail;
+    if (sscanf(str.c_str(), "%d-%d-%d-%d%c", &k.d, &k.x, &k.y, &k.z, &tail) != 4 ||
+        k.d < 0 || k.d > 30 || k.x < 0 || k.y < 0 || k.z < 0 ||
+        k.x >= (1 << k.d) || k.y >= (1 << k.d) || k.z >= (1 << k.d)){
+        throw InvalidArgsException("Invalid node key: " + str);
+    }
+    return k;
+}
+
+std::string NodeKey::toString() const{
+    return std::to_string(d) + "-" + std::to_string(x) + "-" + std::to_string(y) + "-" + std::to_string(z);
+}
+
+NodeKey NodeKey::child(int i) const{
+    return NodeKey(d + 1, x * 2 + (i & 1), y * 2 + ((i >> 1) & 1), z * 2 + ((i >> 2) & 1));
+}
+
+NodeKey NodeKey::parent() const{
+    if (d == 0) return *this;
+    return NodeKey(d - 1, x / 2, y / 2, z / 2);
+}
+
+static std::vector<uint8_t> readBytes(const fs::path &p, uint64_t offset = 0, uint64_t size = 0){
+    std::ifstream f(p.string(), std::ios::binary);
+    if (!f.is_open()) throw FSException("Cannot open " + p.string());
+
+    if (size == 0){
+        f.seekg(0, std::ios::end);
+        size = static_cast<uint64_t>(f.tellg()) - offset;
+    }
+
+    std::vector<uint8_t> data(size);
+    f.seekg(offset);
+    if (!f.read(reinterpret_cast<char *>(data.data()), size))
+        throw FSException("Cannot read " + std::to_string(size) + " bytes at " +
+                          std::to_string(offset) + " from " + p.string());
+    return data;
+}
+
+void PointCloudOctree::loadPage(const NodeKey &key){
+    const auto ref = pageRefs.find(key);
+    if (ref == pageRefs.end()) return;
+
+    LOGD << "Loading hierarchy page " << key.toString() << " of " << path;
+
+    auto entries = readPage(ref->second);
+    pageRefs.erase(ref);
+
+    for (const auto &e : entries){
+        if (e.pointCount < 0){
+            // The root of a page is listed both in the parent page
+            // (as a reference) and in the page itself
+            if (!(e.key == key)) pageRefs[e.key] = e;
+        }else{
+            nodes[e.key] = e;
+        }
+    }
+
+    pages[key] = std::move(entries);
+}
+
+// Makes sure that the page that would contain key is loaded,
+// must be called with the mutex held
+bool PointCloudOctree::locate(const NodeKey &key, OctreeNode *node){
+    while (true){
+        const auto it = nodes.find(key);
+        if (it != nodes.end()){
+            if (node != nullptr) *node = it->second;
+            return true;
+        }
+
+        // Walk up until we find either a page we haven't loaded
+        // (load it and try again) or a loaded node (then key does not exist,
+        // since pages contain every descendant down to the roots of other pages)
+        NodeKey k = key;
+        while (pageRefs.find(k) == pageRefs.end()){
+            if (!(k == key) && nodes.find(k) != nodes.end()) return false;
+            if (k.d == 0) return false;
+            k = k.parent();
+        }
+
+        loadPage(k);
+    }
+}
+
+json PointCloudOctree::info() const{
+    json j;
+    j["format"] = format();
+    j["dataType"] = dataType();
+    j["bounds"] = { cube[0], cube[1], cube[2], cube[3], cube[4], cube[5] };
+    j["spacing"] = spacing;
+    j["points"] = points;
+    j["srs"] = srs;
+    return j;
+}
+
+void PointCloudOctree::nodeBounds(const NodeKey &key, double bounds[6]) const{
+    const int cells = 1 << key.d;
+    const int coords[3] = { key.x, key.y, key.z };
+    for (int i = 0; i < 3; i++){
+        const double size = (cube[i + 3] - cube[i]) / cells;
+        bounds[i] = cube[i] + size * coords[i];
+        bounds[i + 3] = bounds[i] + size;
+    }
+}
+
+bool PointCloudOctree::findNode(const NodeKey &key, OctreeNode &node){
+    std::lock_guard<std::mutex> lock(mutex);
+    return locate(key, &node);
+}
+
+json PointCloudOctree::hierarchy(const NodeKey &key){
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (pages.find(key) == pages.end()){
+        // Load the parent pages, which tells us whether key is a page root
+        if (!(key == NodeKey())) locate(key.parent(), nullptr);
+        loadPage(key);
+    }
+
+    const auto page = pages.find(key);
+    if (page == pages.end())
+        throw InvalidArgsException(key.toString() + " is not the root of a hierarchy page");
+
+    json j = json::object();
+    for (const auto &e : page->second){
+        j[e.key.toString()] = e.pointCount;
+    }
+    return j;
+}
+
+static bool intersects(const double a[6], const double b[6]){
+    for (int i = 0; i < 3; i++){
+        if (a[i] > b[i + 3] || a[i + 3] < b[i]) return false;
+    }
+    return true;
+}
+
+std::vector<OctreeNode> PointCloudOctree::query(const double bounds[6], int maxDepth){
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<OctreeNode> result;
+    std::queue<OctreeNode> q;
+
+    OctreeNode root;
+    if (locate(NodeKey(), &root)) q.push(root);
+
+    double b[6];
+    while (!q.empty()){
+        const OctreeNode n = q.front();
+        q.pop();
+
+        nodeBounds(n.key, b);
+        if (!intersects(b, bounds)) continue;
+
+        result.push_back(n);
+
+        if (maxDepth >= 0 && n.key.d >= maxDepth) continue;
+
+        for (int i = 0; i < 8; i++){
+            OctreeNode c;
+            if (locate(n.key.child(i), &c)) q.push(c);
+        }
+    }
+
+    return result;
+}
+
+// Entwine Point Tile folder
+class EptOctree : public PointCloudOctree{
+    std::string type;
+
+    fs::path hierarchyFile(const NodeKey &key) const{
+        return fs::path(path) / "ept-hierarchy" / (key.toString() + ".json");
+    }
+
+    std::vector<OctreeNode> readPage(const OctreeNode &ref) override{
+        std::ifstream f(hierarchyFile(ref.key).string());
+        if (!f.is_open()) throw FSException("Cannot open " + hierarchyFile(ref.key).string());
+
+        json j;
+        try{
+            f >> j;
+        }catch(const json::exception &e){
+            throw JSONException(std::string("Invalid EPT hierarchy: ") + e.what());
+        }
+
+        std::vector<OctreeNode> entries;
+        entries.reserve(j.size());
+        for (auto it = j.begin(); it != j.end(); it++){
+            OctreeNode n;
+            n.key = NodeKey::parse(it.key());
+            n.pointCount = it.value().get<int64_t>();
+            entries.push_back(n);
+        }
+        return entries;
+    }
+  public:
+    EptOctree(const std::string &path) : PointCloudOctree(path){
+        const auto eptJson = fs::path(path) / "ept.json";
+        std::ifstream f(eptJson.string());
+        if (!f.is_open()) throw FSException("Cannot open " + eptJson.string());
+
+        try{
+            json j;
+            f >> j;
+
+            const auto bounds = j["bounds"].get<std::vector<double>>();
+            if (bounds.size() != 6) throw InvalidArgsException("Invalid bounds in " + eptJson.string());
+            for (int i = 0; i < 6; i++) cube[i] = bounds[i];
+
+            points = j["points"].get<uint64_t>();
+            spacing = (cube[3] - cube[0]) / j["span"].get<double>();
+            type = j["dataType"].get<std::string>();
+            if (j.contains("srs") && j["srs"].contains("wkt")) srs = j["srs"]["wkt"].get<std::string>();
+        }catch(const json::exception &e){
+            throw JSONException(std::string("Invalid ept.json: ") + e.what());
+        }
+
+        OctreeNode root;
+        root.pointCount = -1;
+        pageRefs[root.key] = root;
+    }
+
+    std::string format() const override{ return "ept"; }
+    std::string dataType() const override{ return type; }
+
+    std::vector<uint8_t> readNode(const NodeKey &key) override{
+        OctreeNode n;
+        if (!findNode(key, n)) throw InvalidArgsException("Node " + key.toString() + " does not exist");
+
+        const std::string ext = type == "laszip" ? ".laz" : type == "zstandard" ? ".zst" : ".bin";
+        return readBytes(fs::path(path) / "ept-data" / (key.toString() + ext));
+    }
+
+    std::vector<uint8_t> readHeader() override{
+        return readBytes(fs::path(path) / "ept.json");
+    }
+};
+
+#define COPC_ENTRY_SIZE 32
+
+// Cloud Optimized Point Cloud file
+class CopcOctree : public PointCloudOctree{
+    uint32_t headerSize = 0;
+
+    std::vector<OctreeNode> readPage(const OctreeNode &ref) override{
+        const auto data = readBytes(path, ref.offset, ref.byteSize);
+
+        std::vector<OctreeNode> entries;
+        entries.reserve(data.size() / COPC_ENTRY_SIZE);
+        for (size_t i = 0; i + COPC_ENTRY_SIZE <= data.size(); i += COPC_ENTRY_SIZE){
+            int32_t key[4];
+            uint64_t offset;
+            int32_t byteSize, pointCount;
+            memcpy(key, data.data() + i, 16);
+            memcpy(&offset, data.data() + i + 16, 8);
+            memcpy(&byteSize, data.data() + i + 24, 4);
+            memcpy(&pointCount, data.data() + i + 28, 4);
+
+            OctreeNode n;
+            n.key = NodeKey(key[0], key[1], key[2], key[3]);
+            n.offset = offset;
+            n.byteSize = static_cast<uint64_t>(byteSize < 0 ? 0 : byteSize);
+            n.pointCount = pointCount < 0 ? -1 : pointCount;
+            entries.push_back(n);
+        }
+        return entries;
+    }
+  public:
+    CopcOctree(const std::string &path) : PointCloudOctree(path){
+        LasHeader h;
+        if (!readLasHeader(path, h) || !h.isCopc) throw InvalidArgsException(path + " is not a COPC file");
+
+        for (int i = 0; i < 3; i++){
+            cube[i] = h.copc.center[i] - h.copc.halfSize;
+            cube[i + 3] = h.copc.center[i] + h.copc.halfSize;
+        }
+        spacing = h.copc.spacing;
+        points = h.pointCount;
+        srs = h.wkt;
+        headerSize = h.pointDataOffset;
+
+        OctreeNode root;
+        root.pointCount = -1;
+        root.offset = h.copc.rootHierarchyOffset;
+        root.byteSize = h.copc.rootHierarchySize;
+        pageRefs[root.key] = root;
+    }
+
+    std::string format() const override{ return "copc"; }
+    std::string dataType() const override{ return "laszip"; }
+
+    std::vector<uint8_t> readNode(const NodeKey &key) override{
+        OctreeNode n;
+        if (!findNode(key, n)) throw InvalidArgsException("Node " + key.toString() + " does not exist");
+        if (n.byteSize == 0) return std::vector<uint8_t>();
+
+        return readBytes(path, n.offset, n.byteSize);
+    }
+
+    std::vector<uint8_t> readHeader() override{
+        return readBytes(path, 0, headerSize);
+    }
+};
+
+struct OctreeCacheEntry{
+    std::string path;
+    fs::file_time_type mtime;
+    std::shared_ptr<PointCloudOctree> octree;
+};
+
+#define OCTREE_CACHE_SIZE 16
+
+// Most recently used first
+static std::list<OctreeCacheEntry> octreeCache;
+static std::mutex octreeCacheMutex;
+
+std::shared_ptr<PointCloudOctree> openOctree(const std::string &path){
+    fs::path p = path;
+    if (p.filename() == "ept.json") p = p.parent_path();
+
+    const bool isEpt = fs::is_directory(p);
+    const fs::path file = isEpt ? p / "ept.json" : p;
+    if (!fs::exists(file)) throw FSException(file.string() + " does not exist");
+
+    // A rebuild replaces ept.json or the COPC file
+    const auto mtime = fs::last_write_time(file);
+    const std::string key = fs::absolute(p).string();
+
+    std::lock_guard<std::mutex> lock(octreeCacheMutex);
+
+    for (auto it = octreeCache.begin(); it != octreeCache.end(); it++){
+        if (it->path == key){
+            if (it->mtime == mtime){
+                octreeCache.splice(octreeCache.begin(), octreeCache, it);
+                return it->octree;
+            }
+
+            octreeCache.erase(it);
+            break;
+        }
+    }
+
+    std::shared_ptr<PointCloudOctree> octree;
+    if (isEpt) octree = std::make_shared<EptOctree>(p.string());
+    else octree = std::make_shared<CopcOctree>(p.string());
+
+    octreeCache.push_front({key, mtime, octree});
+    if (octreeCache.size() > OCTREE_CACHE_SIZE) octreeCache.pop_back();
+
+    return octree;
+}
+
+std::shared_ptr<PointCloudOctree> openEntryOctree(Database *db, const std::string &entryPath){
+    Entry e;
+    if (getEntry(db, entryPath, &e) == nullptr)
+        throw InvalidArgsException(entryPath + " is not a valid path in the database.");
+    if (e.type != EntryType::PointCloud)
+        throw InvalidArgsException(entryPath + " is not a point cloud");
+
+    const auto buildFolder = fs::path(db->getOpenFile()).parent_path() / DDB_BUILD_PATH / e.hash;
+
+    const auto copc = buildFolder / "copc" / DDB_COPC_FILE;
+    if (fs::exists(copc)) return openOctree(copc.string());
+
+    const auto ept = buildFolder / "ept";
+    if (fs::exists(ept / "ept.json")) return openOctree(ept.string());
+
+    throw InvalidArgsException(entryPath + " has not been built yet");
+}
+
+void clearOctreeCache(){
+    std::lock_guard<std::mutex> lock(octreeCacheMutex);
+    octreeCache.clear();
+}
+
+}
@@ -0,0 +1,134 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef OCTREE_H
+#define OCTREE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "database.h"
+#include "json.h"
+#include "ddb_export.h"
+
+namespace ddb{
+
+// Key of an octree node (depth-x-y-z), as used by EPT and COPC
+struct NodeKey{
+    int d = 0, x = 0, y = 0, z = 0;
+
+    NodeKey(){}
+    NodeKey(int d, int x, int y, int z) : d(d), x(x), y(y), z(z) {}
+
+    // Parses "d-x-y-z", throws InvalidArgsException if the key is not valid
+    DDB_DLL static NodeKey parse(const std::string &str);
+    DDB_DLL std::string toString() const;
+
+    // Child number i (0-7), bit 0 selects x, bit 1 y and bit 2 z
+    DDB_DLL NodeKey child(int i) const;
+    DDB_DLL NodeKey parent() const;
+
+    bool operator<(const NodeKey &o) const{
+        if (d != o.d) return d < o.d;
+        if (x != o.x) return x < o.x;
+        if (y != o.y) return y < o.y;
+        return z < o.z;
+    }
+    bool operator==(const NodeKey &o) const{
+        return d == o.d && x == o.x && y == o.y && z == o.z;
+    }
+};
+
+struct OctreeNode{
+    NodeKey key;
+
+    // -1 marks the root of a hierarchy page
+    int64_t pointCount = 0;
+
+    // Location of the node data (or of the hierarchy page) within
+    // a COPC file, unused for EPT
+    uint64_t offset = 0;
+    uint64_t byteSize = 0;
+};
+
+// Read access to the octree of a built point cloud (an EPT folder or a COPC file),
+// meant to serve nodes to viewers. Hierarchy pages are read on demand and kept in memory,
+// so that repeated lookups do not touch the disk.
+class PointCloudOctree{
+  protected:
+    std::string path;
+
+    // Cube of the root node (minx, miny, minz, maxx, maxy, maxz)
+    double cube[6] = {0, 0, 0, 0, 0, 0};
+    double spacing = 0;
+    uint64_t points = 0;
+    std::string srs;
+
+    std::mutex mutex;
+
+    // Nodes of the hierarchy pages loaded so far
+    std::map<NodeKey, OctreeNode> nodes;
+
+    // Page root --> entries, for every page loaded so far
+    std::map<NodeKey, std::vector<OctreeNode>> pages;
+
+    // Pages that are referenced but not loaded yet
+    std::map<NodeKey, OctreeNode> pageRefs;
+
+    // Reads the entries of a hierarchy page
+    virtual std::vector<OctreeNode> readPage(const OctreeNode &ref) = 0;
+
+    void loadPage(const NodeKey &key);
+    bool locate(const NodeKey &key, OctreeNode *node);
+
+    PointCloudOctree(const std::string &path) : path(path) {}
+  public:
+    virtual ~PointCloudOctree(){}
+
+    // "ept" or "copc"
+    DDB_DLL virtual std::string format() const = 0;
+
+    // Encoding of the node data ("laszip", "binary" or "zstandard")
+    DDB_DLL virtual std::string dataType() const = 0;
+
+    DDB_DLL json info() const;
+
+    // Bounds (minx, miny, minz, maxx, maxy, maxz) of a node
+    DDB_DLL void nodeBounds(const NodeKey &key, double bounds[6]) const;
+
+    // Looks up a node, returns false if it does not exist
+    DDB_DLL bool findNode(const NodeKey &key, OctreeNode &node);
+
+    // Entries of the hierarchy page rooted at key, in the EPT format
+    // ({"d-x-y-z": pointCount}, -1 for the roots of other pages)
+    DDB_DLL json hierarchy(const NodeKey &key);
+
+    // Nodes that intersect bounds (minx, miny, minz, maxx, maxy, maxz, in the
+    // coordinates of the point cloud) up to maxDepth (-1 for no limit),
+    // in breadth first order
+    DDB_DLL std::vector<OctreeNode> query(const double bounds[6], int maxDepth = -1);
+
+    // Compressed point data of a node
+    DDB_DLL virtual std::vector<uint8_t> readNode(const NodeKey &key) = 0;
+
+    // What a reader needs before decoding nodes: ept.json for EPT,
+    // the LAS header and VLRs for COPC
+    DDB_DLL virtual std::vector<uint8_t> readHeader() = 0;
+};
+
+// Opens an EPT folder (or its ept.json) or a COPC file.
+// Opened octrees are cached until their files change.
+DDB_DLL std::shared_ptr<PointCloudOctree> openOctree(const std::string &path);
+
+// Opens the octree that "ddb build" generated for a point cloud entry,
+// preferring COPC over EPT
+DDB_DLL std::shared_ptr<PointCloudOctree> openEntryOctree(Database *db, const std::string &entryPath);
+
+DDB_DLL void clearOctreeCache();
+
+}
+
+#endif // OCTREE_H
@@ -0,0 +1,113 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <algorithm>
+#include <vector>
+#include <gdal_priv.h>
+
+#include "overviews.h"
+#include "build.h"
+#include "ddb.h"
+#include "dbops.h"
+#include "exceptions.h"
+#include "logger.h"
+#include "mio.h"
+#include "sqlite_database.h"
+
+namespace ddb{
+
+bool buildOverviews(const std::string &rasterPath, const std::string &outputVrt, int tileSize){
+    GDALDatasetH hSrc = GDALOpen(rasterPath.c_str(), GA_ReadOnly);
+    if (hSrc == nullptr) throw GDALException("Cannot open " + rasterPath);
+
+    const int width = GDALGetRasterXSize(hSrc);
+    const int height = GDALGetRasterYSize(hSrc);
+    const int bandCount = GDALGetRasterCount(hSrc);
+
+    if (bandCount == 0 || GDALGetOverviewCount(GDALGetRasterBand(hSrc, 1)) > 0){
+        LOGD << rasterPath << " has overviews already";
+        GDALClose(hSrc);
+        return false;
+    }
+
+    std::vector<int> levels;
+    for (int factor = 2; std::max(width, height) / (factor / 2) > tileSize; factor *= 2){
+        levels.push_back(factor);
+    }
+    if (levels.empty()){
+        GDALClose(hSrc);
+        return false;
+    }
+
+    io::assureFolderExists(fs::path(outputVrt).parent_path());
+    GDALDriverH vrtDrv = GDALGetDriverByName("VRT");
+    if (vrtDrv == nullptr){
+        GDALClose(hSrc);
+        throw GDALException("Cannot create VRT driver");
+    }
+
+    GDALDatasetH hVrt = GDALCreateCopy(vrtDrv, outputVrt.c_str(), hSrc, FALSE, nullptr, nullptr, nullptr);
+    GDALClose(hSrc);
+    if (hVrt == nullptr) throw GDALException("Cannot create " + outputVrt + ": " + CPLGetLastErrorMsg());
+    GDALClose(hVrt);
+
+    // Opening read-only makes GDAL write the overviews to an external .ovr file
+    hVrt = GDALOpen(outputVrt.c_str(), GA_ReadOnly);
+    if (hVrt == nullptr) throw GDALException("Cannot open " + outputVrt);
+
+    LOGD << "Building " << levels.size() << " overview levels for " << rasterPath;
+
+    CPLSetThreadLocalConfigOption("GDAL_NUM_THREADS", "ALL_CPUS");
+    CPLSetThreadLocalConfigOption("COMPRESS_OVERVIEW", "DEFLATE");
+    CPLSetThreadLocalConfigOption("BIGTIFF_OVERVIEW", "IF_SAFER");
+
+    const CPLErr err = GDALBuildOverviews(hVrt, "AVERAGE", static_cast<int>(levels.size()), levels.data(),
+                                          0, nullptr, GDALDummyProgress, nullptr);
+
+    CPLSetThreadLocalConfigOption("GDAL_NUM_THREADS", nullptr);
+    CPLSetThreadLocalConfigOption("COMPRESS_OVERVIEW", nullptr);
+    CPLSetThreadLocalConfigOption("BIGTIFF_OVERVIEW", nullptr);
+
+    GDALClose(hVrt);
+
+    if (err != CE_None) throw GDALException("Cannot build overviews for " + rasterPath + ": " + CPLGetLastErrorMsg());
+
+    return true;
+}
+
+fs::path findBuiltOverviews(const fs::path &rasterPath){
+    const fs::path absPath = fs::absolute(rasterPath);
+
+    // Find the dataset that contains the raster, if any
+    for (fs::path dir = absPath.parent_path(); ; dir = dir.parent_path()){
+        const fs::path ddbDir = dir / DDB_FOLDER;
+        if (fs::exists(ddbDir / "dbase.sqlite")){
+            // Nothing has been built
+            if (!fs::exists(ddbDir / DDB_BUILD_PATH)) return fs::path();
+
+            try{
+                // Read only and without migrating the schema: this runs
+                // on every tile cache miss
+                SqliteDatabase db;
+                db.open((ddbDir / "dbase.sqlite").string(), true);
+
+                auto q = db.query("SELECT hash FROM entries WHERE path = ?");
+                q->bind(1, io::Path(absPath).relativeTo(dir).generic());
+                if (!q->fetch() || q->isNull(0)) return fs::path();
+                const std::string hash = q->getText(0);
+                if (hash.empty()) return fs::path();
+
+                const fs::path vrt = ddbDir / DDB_BUILD_PATH / hash / "overviews" / DDB_OVERVIEWS_FILE;
+                if (fs::exists(vrt)) return vrt;
+            }catch(const AppException &err){
+                LOGD << "Cannot look for overviews of " << rasterPath.string() << ": " << err.what();
+            }
+
+            return fs::path();
+        }
+
+        if (dir.parent_path() == dir) return fs::path();
+    }
+}
+
+}
@@ -0,0 +1,28 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef OVERVIEWS_H
+#define OVERVIEWS_H
+
+#include <string>
+#include "fs.h"
+#include "ddb_export.h"
+
+namespace ddb{
+
+#define DDB_OVERVIEWS_FILE "raster.vrt"
+
+// Writes a VRT pointing to rasterPath along with external overviews
+// (outputVrt + ".ovr"), computed with all available threads.
+// Overviews halve the resolution until the raster fits in a tile of tileSize.
+// Returns false if no overviews are needed (small rasters, or rasters
+// that have overviews already).
+DDB_DLL bool buildOverviews(const std::string &rasterPath, const std::string &outputVrt, int tileSize = 256);
+
+// Looks for the overviews that "ddb build" generated for a georaster
+// that is part of a DroneDB dataset. Returns an empty path if there are none.
+DDB_DLL fs::path findBuiltOverviews(const fs::path &rasterPath);
+
+}
+
+#endif // OVERVIEWS_H
@@ -2,6 +2,7 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 #include <pdal/StageFactory.hpp>
+#include <pdal/filters/StreamCallbackFilter.hpp>
 #include <gdal_priv.h>
 #include <ogr_srs_api.h>
 #include <untwine/untwine/Common.hpp>
@@ -9,7 +10,16 @@
 #include <untwine/epf/Epf.hpp>
 #include <untwine/bu/BuPyramid.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 #include "pointcloud.h"
+#include "las.h"
 #include "entry.h"
 #include "exceptions.h"
 #include "mio.h"
@@ -26,7 +36,121 @@ void fatal(const std::string& err){
 
 namespace ddb{
 
+// Sets the WGS84 footprint and centroid of a point cloud from its bounds
+static void setGeoBounds(PointCloudInfo &info, OGRSpatialReferenceH hSrs, const std::string &srsName,
+                         double minx, double miny, double minz, double maxx, double maxy, double maxz){
+    OGRSpatialReferenceH hWgs84 = OSRNewSpatialReference(nullptr);
+    OSRImportFromEPSG(hWgs84, 4326);
+    OGRCoordinateTransformationH hTransform = OCTNewCoordinateTransformation(hSrs, hWgs84);
+
+    double geoMinX = minx;
+    double geoMinY = miny;
+    double geoMinZ = minz;
+    double geoMaxX = maxx;
+    double geoMaxY = maxy;
+    double geoMaxZ = maxz;
+
+    bool minSuccess = OCTTransform(hTransform, 1, &geoMinX, &geoMinY, &geoMinZ);
+    bool maxSuccess = OCTTransform(hTransform, 1, &geoMaxX, &geoMaxY, &geoMaxZ);
+
+    if (!minSuccess || !maxSuccess){
+        throw GDALException("Cannot transform coordinates " + std::to_string(minx) + ", " + std::to_string(miny) + ", " +
+                            std::to_string(maxx) + ", " + std::to_string(maxy) + " to " + srsName);
+    }
+
+    info.polyBounds.clear();
+    info.polyBounds.addPoint(geoMinY, geoMinX, geoMinZ);
+    info.polyBounds.addPoint(geoMinY, geoMaxX, geoMinZ);
+    info.polyBounds.addPoint(geoMaxY, geoMaxX, geoMinZ);
+    info.polyBounds.addPoint(geoMaxY, geoMinX, geoMinZ);
+    info.polyBounds.addPoint(geoMinY, geoMinX, geoMinZ);
+
+    double centroidX = (minx + maxx) / 2.0;
+    double centroidY = (miny + maxy) / 2.0;
+    double centroidZ = minz;
+
+    if (OCTTransform(hTransform, 1, &centroidX, &centroidY, &centroidZ)){
+        info.centroid.clear();
+        info.centroid.addPoint(centroidY, centroidX, centroidZ);
+    }else{
+        throw GDALException("Cannot transform coordinates " + std::to_string(centroidX) + ", " + std::to_string(centroidY) + " to " + srsName);
+    }
+
+    OCTDestroyCoordinateTransformation(hTransform);
+    OSRDestroySpatialReference(hWgs84);
+}
+
+// WKT of the SRS of a LAS/LAZ file (empty if it cannot be determined)
+static std::string getLasWkt(const LasHeader &header){
+    if (!header.wkt.empty() || header.epsg <= 0) return header.wkt;
+
+    std::string wkt;
+    OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
+    char *wktp = nullptr;
+    if (OSRImportFromEPSG(hSrs, header.epsg) == OGRERR_NONE &&
+        OSRExportToWkt(hSrs, &wktp) == OGRERR_NONE){
+        wkt = wktp;
+    }
+    CPLFree(wktp);
+    OSRDestroySpatialReference(hSrs);
+
+    return wkt;
+}
+
+// Spatial reference system of a LAS/LAZ file. LAS coordinates are always
+// easting (or longitude) first, regardless of the axis order of the CRS
+static OGRSpatialReferenceH importLasSrs(const std::string &wkt, const std::string &filename){
+    OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
+    char *wktp = const_cast<char *>(wkt.c_str());
+    if (OSRImportFromWkt(hSrs, &wktp) != OGRERR_NONE){
+        OSRDestroySpatialReference(hSrs);
+        throw GDALException("Cannot read spatial reference system for " + filename + ". Is PROJ available?");
+    }
+#if GDAL_VERSION_MAJOR >= 3
+    OSRSetAxisMappingStrategy(hSrs, OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+
+    return hSrs;
+}
+
+// Reads point cloud info straight from a LAS/LAZ header,
+// returns false if the header does not have all the information we need
+static bool getLasInfo(const std::string &filename, PointCloudInfo &info){
+    LasHeader header;
+    if (!readLasHeader(filename, header)) return false;
+
+    const std::string wkt = getLasWkt(header);
+
+    // User defined GeoTIFF keys are left to PDAL
+    if (wkt.empty() && header.hasGeoKeys){
+        LOGD << "Cannot get SRS from LAS header of " << filename << ", falling back to PDAL";
+        return false;
+    }
+
+    info.pointCount = header.pointCount;
+    info.wktProjection = wkt;
+    info.dimensions = header.dimensions();
+    info.bounds = { header.maxX, header.maxY, header.maxZ, header.minX, header.minY, header.minZ };
+
+    if (!wkt.empty()){
+        OGRSpatialReferenceH hSrs = importLasSrs(wkt, filename);
+        try{
+            setGeoBounds(info, hSrs, filename, header.minX, header.minY, header.minZ,
+                         header.maxX, header.maxY, header.maxZ);
+        }catch(...){
+            OSRDestroySpatialReference(hSrs);
+            throw;
+        }
+        OSRDestroySpatialReference(hSrs);
+    }
+
+    return true;
+}
+
 bool getPointCloudInfo(const std::string &filename, PointCloudInfo &info){
+    // LAS/LAZ headers have everything we need, avoid setting up a PDAL stage
+    if (getLasInfo(filename, info)) return true;
+
     pdal::StageFactory factory;
     std::string driver = factory.inferReaderDriver(filename);
     if (driver.empty()){
@@ -71,61 +195,560 @@ bool getPointCloudInfo(const std::string &filename, PointCloudInfo &info){
         // We need to convert the bbox to EPSG:4326
         if (qi.m_srs.valid()){
             OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
-            OGRSpatialReferenceH hWgs84 = OSRNewSpatialReference(nullptr);
 
             std::string proj = qi.m_srs.getProj4();
             if (OSRImportFromProj4(hSrs, proj.c_str()) != OGRERR_NONE){
                 throw GDALException("Cannot import spatial reference system " + proj + ". Is PROJ available?");
             }
-            OSRImportFromEPSG(hWgs84, 4326);
-            OGRCoordinateTransformationH hTransform = OCTNewCoordinateTransformation(hSrs, hWgs84);
 
-            double geoMinX = bbox.minx;
-            double geoMinY = bbox.miny;
-            double geoMinZ = bbox.minz;
-            double geoMaxX = bbox.maxx;
-            double geoMaxY = bbox.maxy;
-            double geoMaxZ = bbox.maxz;
+            setGeoBounds(info, hSrs, proj, bbox.minx, bbox.miny, bbox.minz, bbox.maxx, bbox.maxy, bbox.maxz);
+
+            OSRDestroySpatialReference(hSrs);
+        }
+    }
+
+    return true;
+}
+
+// Fill gaps of one cell between occupied cells (morphological closing)
+static void closeGrid(std::vector<uint8_t> &grid, int width, int height){
+    const auto at = [&](const std::vector<uint8_t> &g, int x, int y, uint8_t outside){
+        if (x < 0 || y < 0 || x >= width || y >= height) return outside;
+        return g[y * width + x];
+    };
+
+    std::vector<uint8_t> dilated(grid.size(), 0);
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < width; x++){
+            uint8_t v = 0;
+            for (int dy = -1; dy <= 1 && !v; dy++)
+                for (int dx = -1; dx <= 1 && !v; dx++)
+                    v = at(grid, x + dx, y + dy, 0);
+            dilated[y * width + x] = v;
+        }
+    }
 
-            bool minSuccess = OCTTransform(hTransform, 1, &geoMinX, &geoMinY, &geoMinZ);
-            bool maxSuccess = OCTTransform(hTransform, 1, &geoMaxX, &geoMaxY, &geoMaxZ);
+    // Cells outside of the grid count as occupied, so that
+    // erosion does not eat the cells along the edges
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < width; x++){
+            uint8_t v = 1;
+            for (int dy = -1; dy <= 1 && v; dy++)
+                for (int dx = -1; dx <= 1 && v; dx++)
+                    v = at(dilated, x + dx, y + dy, 1);
+            grid[y * width + x] = v;
+        }
+    }
+}
 
-            if (!minSuccess || !maxSuccess){
-                throw GDALException("Cannot transform coordinates " + bbox.toWKT() + " to " + proj);
+// Separate areas with fewer cells than this are treated as noise
+#define FOOTPRINT_MIN_AREA_CELLS 16
+
+// Keeps only the largest 8-connected area of occupied cells. Returns false
+// (leaving the grid untouched) when another area of at least FOOTPRINT_MIN_AREA_CELLS
+// cells exists, since a single ring cannot describe it
+static bool keepLargestArea(std::vector<uint8_t> &grid, int width, int height){
+    std::vector<int> labels(grid.size(), 0);
+    std::vector<size_t> stack;
+    int bestLabel = 0;
+    size_t bestSize = 0;
+    size_t largeAreas = 0;
+    int label = 0;
+
+    for (size_t i = 0; i < grid.size(); i++){
+        if (!grid[i] || labels[i]) continue;
+
+        label++;
+        size_t size = 0;
+        labels[i] = label;
+        stack.push_back(i);
+
+        while (!stack.empty()){
+            const size_t c = stack.back();
+            stack.pop_back();
+            size++;
+
+            const int cx = static_cast<int>(c % width);
+            const int cy = static_cast<int>(c / width);
+            for (int dy = -1; dy <= 1; dy++){
+                for (int dx = -1; dx <= 1; dx++){
+                    const int nx = cx + dx;
+                    const int ny = cy + dy;
+                    if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+                    const size_t n = static_cast<size_t>(ny) * width + nx;
+                    if (grid[n] && !labels[n]){
+                        labels[n] = label;
+                        stack.push_back(n);
+                    }
+                }
             }
+        }
+
+        if (size >= FOOTPRINT_MIN_AREA_CELLS) largeAreas++;
+        if (size > bestSize){
+            bestSize = size;
+            bestLabel = label;
+        }
+    }
 
-            info.polyBounds.clear();
-            info.polyBounds.addPoint(geoMinY, geoMinX, geoMinZ);
-            info.polyBounds.addPoint(geoMinY, geoMaxX, geoMinZ);
-            info.polyBounds.addPoint(geoMaxY, geoMaxX, geoMinZ);
-            info.polyBounds.addPoint(geoMaxY, geoMinX, geoMinZ);
-            info.polyBounds.addPoint(geoMinY, geoMinX, geoMinZ);
-
-            double centroidX = (bbox.minx + bbox.maxx) / 2.0;
-            double centroidY = (bbox.miny + bbox.maxy) / 2.0;
-            double centroidZ = bbox.minz;
-
-            if (OCTTransform(hTransform, 1, &centroidX, &centroidY, &centroidZ)){
-                info.centroid.clear();
-                info.centroid.addPoint(centroidY, centroidX, centroidZ);
-            }else{
-                throw GDALException("Cannot transform coordinates " + std::to_string(centroidX) + ", " + std::to_string(centroidY) + " to " + proj);
+    if (largeAreas > 1) return false;
+
+    for (size_t i = 0; i < grid.size(); i++){
+        grid[i] = labels[i] == bestLabel && bestLabel != 0 ? 1 : 0;
+    }
+
+    return true;
+}
+
+// Occupied cells that only touch diagonally would make the outline
+// touch itself: join them by occupying one of the other two cells
+static void removeDiagonalContacts(std::vector<uint8_t> &grid, int width, int height){
+    bool changed = true;
+    while (changed){
+        changed = false;
+        for (int y = 0; y + 1 < height; y++){
+            for (int x = 0; x + 1 < width; x++){
+                uint8_t *tl = &grid[y * width + x];
+                uint8_t *tr = tl + 1;
+                uint8_t *bl = &grid[(y + 1) * width + x];
+                uint8_t *br = bl + 1;
+
+                if (*tl && *br && !*tr && !*bl){
+                    *tr = 1;
+                    changed = true;
+                }else if (*tr && *bl && !*tl && !*br){
+                    *tl = 1;
+                    changed = true;
+                }
             }
+        }
+    }
+}
 
-            OCTDestroyCoordinateTransformation(hTransform);
-            OSRDestroySpatialReference(hWgs84);
-            OSRDestroySpatialReference(hSrs);
+std::vector<Point> traceOccupancyBoundary(std::vector<uint8_t> grid, int width, int height){
+    if (width <= 0 || height <= 0 || grid.size() != static_cast<size_t>(width) * height)
+        throw InvalidArgsException("Invalid occupancy grid size");
+
+    std::vector<Point> boundary;
+    if (!keepLargestArea(grid, width, height)) return boundary;
+    removeDiagonalContacts(grid, width, height);
+
+    const auto isSet = [&](int x, int y){
+        return x >= 0 && y >= 0 && x < width && y < height && grid[y * width + x];
+    };
+
+    // Directed cell edges between an occupied and an empty cell, going
+    // clockwise around occupied cells. Without diagonal contacts each
+    // corner has at most one outgoing edge, so edges form simple rings.
+    // Corners are indexed as y * (width + 1) + x
+    const int cornersWidth = width + 1;
+    std::vector<int> next(static_cast<size_t>(cornersWidth) * (height + 1), -1);
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < width; x++){
+            if (!isSet(x, y)) continue;
+
+            const int tl = y * cornersWidth + x;
+            const int tr = tl + 1;
+            const int bl = tl + cornersWidth;
+            const int br = bl + 1;
+
+            if (!isSet(x, y - 1)) next[tl] = tr;
+            if (!isSet(x + 1, y)) next[tr] = br;
+            if (!isSet(x, y + 1)) next[br] = bl;
+            if (!isSet(x - 1, y)) next[bl] = tl;
+        }
+    }
+
+    // The top edge of the first occupied cell (in scan order)
+    // is always part of the outer ring
+    int start = -1;
+    for (int i = 0; i < width * height && start < 0; i++){
+        if (grid[i]) start = (i / width) * cornersWidth + i % width;
+    }
+    if (start < 0) return boundary;
+
+    int c = start;
+    do{
+        boundary.emplace_back(c % cornersWidth, c / cornersWidth);
+        c = next[c];
+    }while (c != start && c >= 0 && boundary.size() <= next.size());
+
+    boundary.emplace_back(start % cornersWidth, start / cornersWidth);
+
+    return boundary;
+}
+
+static double segmentDistance(const Point &p, const Point &a, const Point &b){
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2 : 0.0;
+    t = std::max(0.0, std::min(1.0, t));
+    return std::hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
+}
+
+// Douglas-Peucker
+static std::vector<Point> simplifyRing(const std::vector<Point> &ring, double tolerance){
+    if (ring.size() < 5) return ring;
+
+    std::vector<uint8_t> keep(ring.size(), 0);
+    keep.front() = keep.back() = 1;
+
+    std::vector<std::pair<size_t, size_t>> stack = { {0, ring.size() - 1} };
+    while (!stack.empty()){
+        const auto range = stack.back();
+        stack.pop_back();
+
+        double maxDist = 0;
+        size_t maxIdx = range.first;
+        for (size_t i = range.first + 1; i < range.second; i++){
+            const double d = segmentDistance(ring[i], ring[range.first], ring[range.second]);
+            if (d > maxDist){
+                maxDist = d;
+                maxIdx = i;
+            }
+        }
+
+        if (maxDist > tolerance){
+            keep[maxIdx] = 1;
+            stack.emplace_back(range.first, maxIdx);
+            stack.emplace_back(maxIdx, range.second);
         }
     }
 
+    std::vector<Point> result;
+    for (size_t i = 0; i < ring.size(); i++){
+        if (keep[i]) result.push_back(ring[i]);
+    }
+
+    // Need at least a triangle
+    return result.size() >= 4 ? result : ring;
+}
+
+// Points decoded by each thread (at least)
+#define POINTS_PER_THREAD 1000000
+#define POINTS_STREAM_CHUNK 10000
+
+typedef std::pair<uint64_t, uint64_t> PointRange; // start, count
+
+// Streams ranges of points of a LAS/LAZ file, spreading the ranges over numThreads threads.
+// LAZ files are compressed in independent chunks, so each thread can decode its own ranges.
+// callback(t, point) is invoked from thread number t.
+static void streamPointRanges(const std::string &filename, const std::vector<PointRange> &ranges, size_t numThreads,
+                              const std::function<void(size_t, pdal::PointRef &)> &callback){
+    numThreads = std::max<size_t>(1, std::min(numThreads, ranges.size()));
+
+    std::vector<std::exception_ptr> errors(numThreads);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < numThreads; t++){
+        threads.emplace_back([&, t](){
+            try{
+                for (size_t r = t; r < ranges.size(); r += numThreads){
+                    pdal::StageFactory factory;
+                    pdal::Stage *reader = factory.createStage("readers.las");
+                    pdal::Options opts;
+                    opts.add("filename", filename);
+                    opts.add("start", ranges[r].first);
+                    opts.add("count", ranges[r].second);
+                    reader->setOptions(opts);
+
+                    pdal::StreamCallbackFilter f;
+                    f.setCallback([&](pdal::PointRef &p){
+                        callback(t, p);
+                        return true;
+                    });
+                    f.setInput(*reader);
+
+                    pdal::FixedPointTable table(POINTS_STREAM_CHUNK);
+                    f.prepare(table);
+                    f.execute(table);
+                }
+            }catch(...){
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto &t : threads) t.join();
+    for (auto &e : errors){
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+static size_t maxThreads(){
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool getPointCloudFootprint(const std::string &filename, BasicPolygonGeometry &footprint, int gridSize, int subsample){
+    if (gridSize < 2) throw InvalidArgsException("Grid size must be at least 2");
+    if (subsample < 1) throw InvalidArgsException("Subsample must be at least 1");
+
+    LasHeader header;
+    if (!readLasHeader(filename, header) || header.pointCount == 0) return false;
+
+    const std::string wkt = getLasWkt(header);
+    if (wkt.empty()){
+        LOGD << "Cannot compute footprint of " << filename << " (no SRS)";
+        return false;
+    }
+
+    const double cellSize = std::max(header.maxX - header.minX, header.maxY - header.minY) / gridSize;
+    if (cellSize <= 0) return false;
+
+    const int width = static_cast<int>((header.maxX - header.minX) / cellSize) + 1;
+    const int height = static_cast<int>((header.maxY - header.minY) / cellSize) + 1;
+
+    const uint64_t numThreads = std::max<uint64_t>(1, std::min<uint64_t>(maxThreads(), header.pointCount / POINTS_PER_THREAD));
+
+    std::vector<PointRange> ranges;
+    for (uint64_t t = 0; t < numThreads; t++){
+        const uint64_t start = header.pointCount * t / numThreads;
+        const uint64_t end = header.pointCount * (t + 1) / numThreads;
+        ranges.emplace_back(start, end - start);
+    }
+
+    std::vector<std::vector<uint8_t>> grids(numThreads, std::vector<uint8_t>(static_cast<size_t>(width) * height, 0));
+    std::vector<size_t> counters(numThreads, 0);
+
+    LOGD << "Computing footprint of " << filename << " (" << width << "x" << height << " grid, " << numThreads << " threads)";
+
+    streamPointRanges(filename, ranges, numThreads, [&](size_t t, pdal::PointRef &p){
+        if (counters[t]++ % subsample != 0) return;
+
+        const double x = p.getFieldAs<double>(pdal::Dimension::Id::X);
+        const double y = p.getFieldAs<double>(pdal::Dimension::Id::Y);
+        const int cx = std::max(0, std::min(width - 1, static_cast<int>((x - header.minX) / cellSize)));
+        const int cy = std::max(0, std::min(height - 1, static_cast<int>((y - header.minY) / cellSize)));
+        grids[t][static_cast<size_t>(cy) * width + cx] = 1;
+    });
+
+    auto &grid = grids[0];
+    for (size_t t = 1; t < grids.size(); t++){
+        for (size_t i = 0; i < grid.size(); i++) grid[i] |= grids[t][i];
+    }
+
+    closeGrid(grid, width, height);
+    const auto ring = simplifyRing(traceOccupancyBoundary(grid, width, height), 1.0);
+    if (ring.size() < 4) return false;
+
+    // Cell corners to WGS84
+    std::vector<double> xs, ys, zs;
+    for (const auto &p : ring){
+        xs.push_back(header.minX + p.x * cellSize);
+        ys.push_back(header.minY + p.y * cellSize);
+        zs.push_back(header.minZ);
+    }
+
+    OGRSpatialReferenceH hSrs = importLasSrs(wkt, filename);
+    OGRSpatialReferenceH hWgs84 = OSRNewSpatialReference(nullptr);
+    OSRImportFromEPSG(hWgs84, 4326);
+    OGRCoordinateTransformationH hTransform = OCTNewCoordinateTransformation(hSrs, hWgs84);
+
+    const bool success = OCTTransform(hTransform, static_cast<int>(xs.size()), xs.data(), ys.data(), zs.data());
+
+    OCTDestroyCoordinateTransformation(hTransform);
+    OSRDestroySpatialReference(hWgs84);
+    OSRDestroySpatialReference(hSrs);
+
+    if (!success) throw GDALException("Cannot transform footprint of " + filename + " to EPSG:4326");
+
+    footprint.clear();
+    for (size_t i = 0; i < xs.size(); i++){
+        footprint.addPoint(ys[i], xs[i], zs[i]);
+    }
+
     return true;
 }
 
-void buildEpt(const std::vector<std::string> &filenames, const std::string &outdir){
-    fs::path dest = outdir;
-    fs::path tmpDir = dest / "tmp";
+#define RASTER_POINTS_PER_THREAD 250000
+#define RASTER_ROW_LOCKS 256
+#define RASTER_POINTS_PER_PIXEL 4
 
-    untwine::Options options;
+// Blue -> cyan -> green -> yellow -> red, t in [0, 1]
+static void elevationColor(double t, uint8_t rgb[3]){
+    static const uint8_t ramp[5][3] = { {43, 131, 186}, {171, 221, 164}, {255, 255, 191}, {253, 174, 97}, {215, 25, 28} };
+
+    t = std::max(0.0, std::min(1.0, t)) * 4.0;
+    const int i = std::min(3, static_cast<int>(t));
+    const double f = t - i;
+    for (int c = 0; c < 3; c++){
+        rgb[c] = static_cast<uint8_t>(ramp[i][c] + (ramp[i + 1][c] - ramp[i][c]) * f);
+    }
+}
+
+void rasterizePointCloud(const std::string &filename, const std::string &outputFile, int size, uint64_t maxPoints){
+    if (size < 1) throw InvalidArgsException("Raster size must be at least 1");
+
+    LasHeader header;
+    if (!readLasHeader(filename, header)) throw InvalidArgsException(filename + " is not a valid LAS/LAZ file");
+    if (header.pointCount == 0) throw InvalidArgsException(filename + " has no points");
+
+    const double cellSize = std::max(header.maxX - header.minX, header.maxY - header.minY) / size;
+    if (cellSize <= 0) throw InvalidArgsException(filename + " has empty bounds");
+
+    const int width = std::max(1, std::min(size, static_cast<int>(std::ceil((header.maxX - header.minX) / cellSize))));
+    const int height = std::max(1, std::min(size, static_cast<int>(std::ceil((header.maxY - header.minY) / cellSize))));
+    const size_t pixels = static_cast<size_t>(width) * height;
+
+    // A few points per pixel are plenty, more would only be hidden
+    if (maxPoints == 0) maxPoints = static_cast<uint64_t>(pixels) * RASTER_POINTS_PER_PIXEL;
+
+    const int f = header.pointFormat;
+    const bool hasColor = f == 2 || f == 3 || f == 5 || f == 7 || f == 8 || f == 10;
+
+    // Decimate with a stride over the whole file, so that sparse
+    // and dense parts of the cloud are sampled alike
+    const uint64_t stride = (header.pointCount + maxPoints - 1) / maxPoints;
+    const uint64_t sampled = (header.pointCount + stride - 1) / stride;
+    const uint64_t numThreads = std::max<uint64_t>(1, std::min<uint64_t>(maxThreads(), header.pointCount / RASTER_POINTS_PER_THREAD));
+
+    std::vector<PointRange> ranges;
+    for (uint64_t t = 0; t < numThreads; t++){
+        const uint64_t start = header.pointCount * t / numThreads;
+        const uint64_t end = header.pointCount * (t + 1) / numThreads;
+        ranges.emplace_back(start, end - start);
+    }
+    std::vector<uint64_t> counters(numThreads, 0);
+
+    LOGD << "Rasterizing " << filename << " (" << width << "x" << height << ", "
+         << sampled << " points, " << numThreads << " threads)";
+
+    // The highest point of every cell, shared by all threads. Rows are
+    // guarded by a small set of striped locks, so that threads writing
+    // to different parts of the raster rarely wait for each other
+    struct Raster{
+        std::vector<float> z;
+        std::vector<uint16_t> rgb;
+        std::atomic<uint16_t> maxColor{0};
+    } raster;
+    raster.z.assign(pixels, -std::numeric_limits<float>::infinity());
+    if (hasColor) raster.rgb.assign(pixels * 3, 0);
+    std::vector<std::mutex> rowLocks(RASTER_ROW_LOCKS);
+
+    streamPointRanges(filename, ranges, numThreads, [&](size_t t, pdal::PointRef &p){
+        if (counters[t]++ % stride != 0) return;
+
+        const double x = p.getFieldAs<double>(pdal::Dimension::Id::X);
+        const double y = p.getFieldAs<double>(pdal::Dimension::Id::Y);
+        const float z = p.getFieldAs<float>(pdal::Dimension::Id::Z);
+        const int cx = std::max(0, std::min(width - 1, static_cast<int>((x - header.minX) / cellSize)));
+        const int cy = std::max(0, std::min(height - 1, static_cast<int>((header.maxY - y) / cellSize)));
+        const size_t i = static_cast<size_t>(cy) * width + cx;
+
+        uint16_t rgb[3] = {0, 0, 0};
+        if (hasColor){
+            rgb[0] = p.getFieldAs<uint16_t>(pdal::Dimension::Id::Red);
+            rgb[1] = p.getFieldAs<uint16_t>(pdal::Dimension::Id::Green);
+            rgb[2] = p.getFieldAs<uint16_t>(pdal::Dimension::Id::Blue);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(rowLocks[static_cast<size_t>(cy) % RASTER_ROW_LOCKS]);
+            if (z <= raster.z[i]) return;
+            raster.z[i] = z;
+            if (hasColor) std::copy(rgb, rgb + 3, raster.rgb.begin() + i * 3);
+        }
+
+        if (hasColor){
+            const uint16_t c = std::max({rgb[0], rgb[1], rgb[2]});
+            uint16_t current = raster.maxColor.load();
+            while (c > current && !raster.maxColor.compare_exchange_weak(current, c)){}
+        }
+    });
+
+    // Band sequential RGBA
+    std::vector<uint8_t> bands(pixels * 4, 0);
+    uint8_t *red = bands.data(), *green = red + pixels, *blue = green + pixels, *alpha = blue + pixels;
+
+    // LAS colors are supposed to be 16 bit, but many writers store 8 bit values
+    const int colorShift = raster.maxColor.load() > 255 ? 8 : 0;
+
+    float minZ = std::numeric_limits<float>::max(), maxZ = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < pixels; i++){
+        if (std::isinf(raster.z[i])) continue;
+        minZ = std::min(minZ, raster.z[i]);
+        maxZ = std::max(maxZ, raster.z[i]);
+    }
+
+    for (size_t i = 0; i < pixels; i++){
+        if (std::isinf(raster.z[i])) continue;
+
+        uint8_t rgb[3];
+        if (hasColor){
+            for (int c = 0; c < 3; c++) rgb[c] = static_cast<uint8_t>(raster.rgb[i * 3 + c] >> colorShift);
+        }else{
+            elevationColor(maxZ > minZ ? (raster.z[i] - minZ) / (maxZ - minZ) : 0.5, rgb);
+        }
+
+        red[i] = rgb[0];
+        green[i] = rgb[1];
+        blue[i] = rgb[2];
+        alpha[i] = 255;
+    }
+
+    // Fill small gaps between sampled points with the average of their neighbors
+    for (int pass = 0; pass < 2; pass++){
+        const std::vector<uint8_t> filled(alpha, alpha + pixels);
+        for (int y = 0; y < height; y++){
+            for (int x = 0; x < width; x++){
+                const size_t i = static_cast<size_t>(y) * width + x;
+                if (filled[i]) continue;
+
+                int n = 0, sum[3] = {0, 0, 0};
+                for (int dy = -1; dy <= 1; dy++){
+                    for (int dx = -1; dx <= 1; dx++){
+                        const int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+                        const size_t j = static_cast<size_t>(ny) * width + nx;
+                        if (!filled[j]) continue;
+                        sum[0] += red[j];
+                        sum[1] += green[j];
+                        sum[2] += blue[j];
+                        n++;
+                    }
+                }
+
+                if (n >= 3){
+                    red[i] = static_cast<uint8_t>(sum[0] / n);
+                    green[i] = static_cast<uint8_t>(sum[1] / n);
+                    blue[i] = static_cast<uint8_t>(sum[2] / n);
+                    alpha[i] = 255;
+                }
+            }
+        }
+    }
+
+    GDALDriverH hDriver = GDALGetDriverByName("GTiff");
+    if (!hDriver) throw GDALException("Cannot create GTiff driver");
+
+    char **options = nullptr;
+    options = CSLAddString(options, "TILED=YES");
+    options = CSLAddString(options, "COMPRESS=DEFLATE");
+    GDALDatasetH hDataset = GDALCreate(hDriver, outputFile.c_str(), width, height, 4, GDT_Byte, options);
+    CSLDestroy(options);
+    if (!hDataset) throw GDALException("Cannot create " + outputFile);
+
+    double geotransform[6] = { header.minX, cellSize, 0, header.maxY, 0, -cellSize };
+    GDALSetGeoTransform(hDataset, geotransform);
+
+    const std::string wkt = getLasWkt(header);
+    if (!wkt.empty()) GDALSetProjection(hDataset, wkt.c_str());
+
+    const bool written = GDALDatasetRasterIO(hDataset, GF_Write, 0, 0, width, height, bands.data(),
+                                             width, height, GDT_Byte, 4, nullptr, 0, 0, 0) == CE_None;
+    if (written){
+        const int interp[4] = { GCI_RedBand, GCI_GreenBand, GCI_BlueBand, GCI_AlphaBand };
+        for (int b = 0; b < 4; b++) GDALSetRasterColorInterpretation(GDALGetRasterBand(hDataset, b + 1), interp[b]);
+    }
+
+    GDALClose(hDataset);
+
+    if (!written) throw GDALException("Cannot write " + outputFile);
+}
+
+static void initUntwineOptions(untwine::Options &options, const std::vector<std::string> &filenames, const fs::path &tmpDir){
     for (const std::string &f : filenames){
         if (!fs::exists(f)) throw FSException(f + " does not exist");
 
@@ -135,11 +758,40 @@ void buildEpt(const std::vector<std::string> &filenames, const std::string &outd
         options.inputFiles.push_back(f);
     }
     options.tempDir = tmpDir.string();
-    options.outputDir = dest.string();
     options.fileLimit = 10000000;
     options.progressFd = -1;
     options.stats = false;
     options.level = -1;
+}
+
+static void runUntwine(const untwine::Options &options){
+    untwine::ProgressWriter progress(options.progressFd);
+
+    try{
+        untwine::BaseInfo common;
+
+        untwine::epf::Epf preflight(common);
+        preflight.run(options, progress);
+
+        untwine::bu::BuPyramid builder(common);
+        builder.run(options, progress);
+    }catch (const std::exception &e){
+        throw UntwineException(e.what());
+    }
+}
+
+void buildEpt(const std::vector<std::string> &filenames, const std::string &outdir){
+    fs::path dest = outdir;
+    fs::path tmpDir = dest / "tmp";
+
+    untwine::Options options;
+    initUntwineOptions(options, filenames, tmpDir);
+#ifdef DDB_COPC
+    options.outputName = dest.string();
+    options.singleFile = false;
+#else
+    options.outputDir = dest.string();
+#endif
 
     io::assureFolderExists(dest);
     io::assureFolderExists(tmpDir);
@@ -149,24 +801,37 @@ void buildEpt(const std::vector<std::string> &filenames, const std::string &outd
     io::assureFolderExists(dest / "ept-data");
     io::assureFolderExists(dest / "ept-hierarchy");
 
+    runUntwine(options);
 
-    untwine::ProgressWriter progress(options.progressFd);
+    io::assureIsRemoved(tmpDir);
+    io::assureIsRemoved(dest / "temp");
+}
 
-    try{
-        untwine::BaseInfo common;
+#ifdef DDB_COPC
+void buildCopc(const std::vector<std::string> &filenames, const std::string &outputFile){
+    const fs::path dest = outputFile;
+    if (dest.has_parent_path()) io::assureFolderExists(dest.parent_path());
 
-        untwine::epf::Epf preflight(common);
-        preflight.run(options, progress);
+    const fs::path tmpDir = dest.string() + "-tmp";
 
-        untwine::bu::BuPyramid builder(common);
-        builder.run(options, progress);
+    untwine::Options options;
+    initUntwineOptions(options, filenames, tmpDir);
+    options.outputName = dest.string();
+    options.singleFile = true;
 
+    io::assureIsRemoved(dest);
+    io::assureFolderExists(tmpDir);
+
+    try{
+        runUntwine(options);
+    }catch(...){
         io::assureIsRemoved(tmpDir);
-        io::assureIsRemoved(dest / "temp");
-    }catch (const std::exception &e){
-        throw UntwineException(e.what());
+        throw;
     }
+
+    io::assureIsRemoved(tmpDir);
 }
+#endif
 
 
 json PointCloudInfo::toJSON(){
@@ -24,8 +24,35 @@ struct PointCloudInfo{
 };
 
 DDB_DLL bool getPointCloudInfo(const std::string &filename, PointCloudInfo &info);
+
+// Computes the outline (in WGS84) of the area actually covered by the points
+// of a LAS/LAZ file, by rasterizing them on a coarse occupancy grid
+// (gridSize cells on the longest side). Only every subsample-th point is used.
+// Returns false when the points form more than one separate area.
+DDB_DLL bool getPointCloudFootprint(const std::string &filename, BasicPolygonGeometry &footprint,
+                                    int gridSize = 256, int subsample = 1);
+
+// Traces the outline of the largest connected area of occupied cells
+// in an occupancy grid (row major, width x height). Returns a closed ring
+// of cell corners in grid coordinates (cell x,y spans x..x+1, y..y+1).
+// Small separate areas are ignored; if there is more than one large area
+// the result is empty, so that callers keep the bounding box instead.
+DDB_DLL std::vector<Point> traceOccupancyBoundary(std::vector<uint8_t> grid, int width, int height);
+
+// Renders a top-down RGBA GeoTIFF preview of a LAS/LAZ file (size pixels on the
+// longest side, in the point cloud's SRS). Points are colored by their RGB values,
+// or by elevation when the file has no colors. About maxPoints evenly
+// spaced points are drawn (0 = a few points per pixel of the preview).
+DDB_DLL void rasterizePointCloud(const std::string &filename, const std::string &outputFile,
+                                 int size, uint64_t maxPoints = 0);
+
 DDB_DLL void buildEpt(const std::vector<std::string> &filenames, const std::string &outdir);
 
+#ifdef DDB_COPC
+// Builds a single file Cloud Optimized Point Cloud (.copc.laz)
+DDB_DLL void buildCopc(const std::vector<std::string> &filenames, const std::string &outputFile);
+#endif
+
 }
 
 #endif // POINTCLOUD_H
@@ -0,0 +1,145 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Closed-form WGS84 <--> UTM and WGS84 <--> Web Mercator (EPSG:3857)
+// conversions, so that the common cases don't need a PROJ transformation.
+// UTM uses the Krüger series to order n^6 (Karney, "Transverse Mercator with
+// an accuracy of a few nanometers", 2011), which is well below a millimeter
+// within a UTM zone.
+
+namespace ddb{
+
+constexpr double WGS84_A = 6378137.0;
+constexpr double WGS84_F = 1.0 / 298.257223563;
+constexpr double WGS84_E2 = WGS84_F * (2.0 - WGS84_F);
+
+constexpr double UTM_K0 = 0.9996;
+constexpr double UTM_FALSE_EASTING = 500000.0;
+constexpr double UTM_FALSE_NORTHING = 10000000.0;
+
+// Web Mercator is not defined past this latitude
+constexpr double WEB_MERCATOR_MAX_LATITUDE = 85.051128779806592;
+
+struct KruegerSeries{
+    double A;        // Rectifying radius
+    double alpha[6]; // Conformal to rectifying
+    double beta[6];  // Rectifying to conformal
+};
+
+constexpr KruegerSeries kruegerSeries(double a, double f){
+    const double n = f / (2.0 - f);
+    const double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+
+    KruegerSeries s{};
+    s.A = a / (1.0 + n) * (1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0);
+
+    s.alpha[0] = n / 2.0 - 2.0 * n2 / 3.0 + 5.0 * n3 / 16.0 + 41.0 * n4 / 180.0 - 127.0 * n5 / 288.0 + 7891.0 * n6 / 37800.0;
+    s.alpha[1] = 13.0 * n2 / 48.0 - 3.0 * n3 / 5.0 + 557.0 * n4 / 1440.0 + 281.0 * n5 / 630.0 - 1983433.0 * n6 / 1935360.0;
+    s.alpha[2] = 61.0 * n3 / 240.0 - 103.0 * n4 / 140.0 + 15061.0 * n5 / 26880.0 + 167603.0 * n6 / 181440.0;
+    s.alpha[3] = 49561.0 * n4 / 161280.0 - 179.0 * n5 / 168.0 + 6601661.0 * n6 / 7257600.0;
+    s.alpha[4] = 34729.0 * n5 / 80640.0 - 3418889.0 * n6 / 1995840.0;
+    s.alpha[5] = 212378941.0 * n6 / 319334400.0;
+
+    s.beta[0] = n / 2.0 - 2.0 * n2 / 3.0 + 37.0 * n3 / 96.0 - n4 / 360.0 - 81.0 * n5 / 512.0 + 96199.0 * n6 / 604800.0;
+    s.beta[1] = n2 / 48.0 + n3 / 15.0 - 437.0 * n4 / 1440.0 + 46.0 * n5 / 105.0 - 1118711.0 * n6 / 3870720.0;
+    s.beta[2] = 17.0 * n3 / 480.0 - 37.0 * n4 / 840.0 - 209.0 * n5 / 4480.0 + 5569.0 * n6 / 90720.0;
+    s.beta[3] = 4397.0 * n4 / 161280.0 - 11.0 * n5 / 504.0 - 830251.0 * n6 / 7257600.0;
+    s.beta[4] = 4583.0 * n5 / 161280.0 - 108847.0 * n6 / 3991680.0;
+    s.beta[5] = 20648693.0 * n6 / 638668800.0;
+
+    return s;
+}
+
+constexpr KruegerSeries WGS84_KRUEGER = kruegerSeries(WGS84_A, WGS84_F);
+
+constexpr double utmCentralMeridian(int zone){
+    return zone * 6.0 - 183.0;
+}
+
+inline void geographicToUTM(double latitude, double longitude, int zone, bool north, double &x, double &y){
+    const KruegerSeries &s = WGS84_KRUEGER;
+    const double e = std::sqrt(WGS84_E2);
+    const double phi = latitude * M_PI / 180.0;
+    const double lambda = (longitude - utmCentralMeridian(zone)) * M_PI / 180.0;
+
+    // Conformal latitude
+    const double sinPhi = std::sin(phi);
+    const double t = std::sinh(std::atanh(sinPhi) - e * std::atanh(e * sinPhi));
+
+    const double xi1 = std::atan2(t, std::cos(lambda));
+    const double eta1 = std::atanh(std::sin(lambda) / std::sqrt(1.0 + t * t));
+
+    double xi = xi1, eta = eta1;
+    for (int j = 1; j <= 6; j++){
+        xi += s.alpha[j - 1] * std::sin(2.0 * j * xi1) * std::cosh(2.0 * j * eta1);
+        eta += s.alpha[j - 1] * std::cos(2.0 * j * xi1) * std::sinh(2.0 * j * eta1);
+    }
+
+    x = UTM_FALSE_EASTING + UTM_K0 * s.A * eta;
+    y = (north ? 0.0 : UTM_FALSE_NORTHING) + UTM_K0 * s.A * xi;
+}
+
+inline void utmToGeographic(double x, double y, int zone, bool north, double &latitude, double &longitude){
+    const KruegerSeries &s = WGS84_KRUEGER;
+    const double e = std::sqrt(WGS84_E2);
+
+    const double xi = (y - (north ? 0.0 : UTM_FALSE_NORTHING)) / (UTM_K0 * s.A);
+    const double eta = (x - UTM_FALSE_EASTING) / (UTM_K0 * s.A);
+
+    double xi1 = xi, eta1 = eta;
+    for (int j = 1; j <= 6; j++){
+        xi1 -= s.beta[j - 1] * std::sin(2.0 * j * xi) * std::cosh(2.0 * j * eta);
+        eta1 -= s.beta[j - 1] * std::cos(2.0 * j * xi) * std::sinh(2.0 * j * eta);
+    }
+
+    const double sinhEta1 = std::sinh(eta1);
+    const double cosXi1 = std::cos(xi1);
+    const double tau1 = std::sin(xi1) / std::sqrt(sinhEta1 * sinhEta1 + cosXi1 * cosXi1);
+
+    // Conformal to geographic latitude (Newton's method, converges in 2-3 iterations)
+    double tau = tau1;
+    for (int i = 0; i < 5; i++){
+        const double sigma = std::sinh(e * std::atanh(e * tau / std::sqrt(1.0 + tau * tau)));
+        const double taui = tau * std::sqrt(1.0 + sigma * sigma) - sigma * std::sqrt(1.0 + tau * tau);
+        const double dtau = (tau1 - taui) / std::sqrt(1.0 + taui * taui) *
+                            (1.0 + (1.0 - WGS84_E2) * tau * tau) / ((1.0 - WGS84_E2) * std::sqrt(1.0 + tau * tau));
+        tau += dtau;
+        if (std::abs(dtau) < 1e-12) break;
+    }
+
+    latitude = std::atan(tau) * 180.0 / M_PI;
+    longitude = utmCentralMeridian(zone) + std::atan2(sinhEta1, cosXi1) * 180.0 / M_PI;
+}
+
+// Arrays of points, written so that the loops can be vectorized
+inline void geographicToUTM(const double *latitudes, const double *longitudes, double *x, double *y,
+                            size_t count, int zone, bool north){
+    for (size_t i = 0; i < count; i++) geographicToUTM(latitudes[i], longitudes[i], zone, north, x[i], y[i]);
+}
+
+inline void utmToGeographic(const double *x, const double *y, double *latitudes, double *longitudes,
+                            size_t count, int zone, bool north){
+    for (size_t i = 0; i < count; i++) utmToGeographic(x[i], y[i], zone, north, latitudes[i], longitudes[i]);
+}
+
+inline void geographicToWebMercator(double latitude, double longitude, double &x, double &y){
+    const double lat = std::max(-WEB_MERCATOR_MAX_LATITUDE, std::min(WEB_MERCATOR_MAX_LATITUDE, latitude));
+    x = WGS84_A * longitude * M_PI / 180.0;
+    y = WGS84_A * std::log(std::tan(M_PI / 4.0 + lat * M_PI / 360.0));
+}
+
+inline void webMercatorToGeographic(double x, double y, double &latitude, double &longitude){
+    longitude = x / WGS84_A * 180.0 / M_PI;
+    latitude = (2.0 * std::atan(std::exp(y / WGS84_A)) - M_PI / 2.0) * 180.0 / M_PI;
+}
+
+}
+
+#endif // PROJECTION_H
@@ -730,7 +730,8 @@ DDB_DLL void Registry::pull(const std::string &path, const bool force,
 }
 
 void zipFolder(const fs::path &folder, const fs::path &archive,
-               const std::vector<std::string> &excludes) {
+               const std::vector<std::string> &excludes,
+               const std::vector<std::pair<fs::path, std::string>> &extraFiles = {}) {
 
     miniz_cpp::zip_file file;
 
@@ -766,6 +767,12 @@ void zipFolder(const fs::path &folder, const fs::path &archive,
         }
     }
 
+    for (const auto &extra : extraFiles) {
+        LOGD << "Adding: '" << extra.second << "'";
+
+        file.write(extra.first.generic_string(), extra.second);
+    }
+
     file.save(archive.generic_string());
 
 }
@@ -859,7 +866,25 @@ DDB_DLL void Registry::push(const std::string &path, const bool force,
 
     out << "Zipping ddb folder" << std::endl;
 
-    zipFolder(ddbPath, tempArchive, {std::string(DDB_BUILD_PATH) + '/'});
+    // The live database (and its WAL) is replaced by a compact copy
+    const fs::path tempDbase =
+        fs::temp_directory_path() / (utils::generateRandomString(8) + ".sqlite");
+    try {
+        db->compactCopy(tempDbase);
+
+        zipFolder(ddbPath, tempArchive,
+                  {std::string(DDB_BUILD_PATH) + '/', "dbase.sqlite",
+                   "dbase.sqlite-wal", "dbase.sqlite-shm"},
+                  {{tempDbase, "dbase.sqlite"}});
+    } catch (...) {
+        // Don't leave a copy of the database (or a partial archive) behind
+        std::error_code ec;
+        fs::remove(tempDbase, ec);
+        fs::remove(tempArchive, ec);
+        throw;
+    }
+
+    fs::remove(tempDbase);
 
     // 5.1) Call POST endpoint passing zip
     PushManager pushManager(this, tagInfo.organization, tagInfo.dataset);
@@ -0,0 +1,133 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "search.h"
+
+#include <sstream>
+
+#include "exceptions.h"
+#include "logger.h"
+
+namespace ddb {
+
+#define SEARCH_FIELDS "e.path, e.hash, e.type, e.meta, e.mtime, e.size, e.depth, " \
+                      "AsGeoJSON(e.point_geom), AsGeoJSON(e.polygon_geom)"
+
+// The trigram tokenizer cannot match terms shorter than 3 characters
+// (and short prefixes would match most of a words index)
+#define MIN_TERM_LENGTH 3
+
+// Quote each term as an FTS5 string so that user input
+// is never interpreted as query syntax. With prefix, the
+// last word of each term matches the beginning of a word.
+static std::string toMatchExpression(const std::vector<std::string> &terms, bool prefix) {
+    std::string expr;
+    for (const auto &t : terms) {
+        if (!expr.empty()) expr += " ";
+        expr += '"';
+        for (const char c : t) {
+            if (c == '"') expr += '"';
+            expr += c;
+        }
+        expr += '"';
+        if (prefix) expr += '*';
+    }
+    return expr;
+}
+
+static std::string escapeLike(const std::string &term) {
+    std::string s;
+    for (const char c : term) {
+        if (c == '%' || c == '_' || c == '/') s += '/';
+        s += c;
+    }
+    return "%" + s + "%";
+}
+
+std::vector<Entry> search(Database *db, const std::string &query, int limit, int offset) {
+    if (offset < 0) throw InvalidArgsException("Offset cannot be negative");
+
+    std::vector<std::string> terms;
+    std::istringstream iss(query);
+    std::string term;
+    bool shortTerms = false;
+    while (iss >> term) {
+        terms.push_back(term);
+        if (term.length() < MIN_TERM_LENGTH) shortTerms = true;
+    }
+
+    if (terms.empty()) throw InvalidArgsException("Search query cannot be empty");
+
+    const std::string page = " LIMIT " + std::to_string(limit > 0 ? limit : -1) +
+                             " OFFSET " + std::to_string(offset);
+
+    std::unique_ptr<Statement> q;
+
+    // A trigram index made by a newer SQLite cannot be read by an older one
+    const bool hasIndex = db->hasSearchIndex();
+    const bool substrings = hasIndex && db->hasTrigramSearchIndex();
+    if (!shortTerms && hasIndex && (!substrings || Database::supportsTrigramSearch())) {
+        // Path matches weigh more than camera matches
+        q = db->query("SELECT " SEARCH_FIELDS " FROM entries_fts f "
+                      "JOIN entries e ON e.rowid = f.rowid "
+                      "WHERE entries_fts MATCH ? "
+                      "ORDER BY bm25(entries_fts, 10.0, 1.0), e.path" + page);
+        q->bind(1, toMatchExpression(terms, !substrings));
+    } else {
+        // Fall back to a table scan
+        LOGD << "Search index not usable for query '" << query << "', scanning entries";
+
+        const std::string make = db->metaColumn("make");
+        const std::string model = db->metaColumn("model");
+        std::string sql = "SELECT " SEARCH_FIELDS " FROM entries e WHERE 1";
+        for (size_t i = 0; i < terms.size(); i++) {
+            sql += " AND (e.path LIKE ? ESCAPE '/' OR " + make + " LIKE ? ESCAPE '/' OR " + model + " LIKE ? ESCAPE '/')";
+        }
+        q = db->query(sql + " ORDER BY e.path" + page);
+
+        int p = 1;
+        for (const auto &t : terms) {
+            const auto pattern = escapeLike(t);
+            q->bind(p++, pattern);
+            q->bind(p++, pattern);
+            q->bind(p++, pattern);
+        }
+    }
+
+    std::vector<Entry> entries;
+    while (q->fetch()) {
+        entries.emplace_back(*q);
+    }
+
+    return entries;
+}
+
+void searchIndex(Database *db, const std::string &query, std::ostream &output,
+                 const std::string &format, int limit, int offset) {
+    if (format != "json" && format != "text")
+        throw InvalidArgsException("Invalid format " + format);
+
+    const auto entries = search(db, query, limit, offset);
+
+    if (format == "text") {
+        for (const auto &e : entries) {
+            output << e.path << std::endl;
+        }
+    } else {
+        output << "[";
+
+        bool first = true;
+        for (const auto &e : entries) {
+            json j;
+            e.toJSON(j);
+            if (!first) output << ",";
+            output << j.dump();
+            first = false;
+        }
+
+        output << "]";
+    }
+}
+
+}  // namespace ddb
@@ -0,0 +1,29 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <string>
+#include <vector>
+
+#include "database.h"
+#include "entry.h"
+#include "ddb_export.h"
+
+namespace ddb {
+
+// Find entries whose path or camera (make/model) contains
+// each of the whitespace separated terms in query (case insensitive).
+// With SQLite older than 3.34 the index matches terms at the
+// beginning of words only (e.g. "0001" or "DJI_00" in DJI_0001.JPG).
+// Results are ranked by relevance (path matches weigh more) and paginated
+// with limit/offset (limit <= 0 returns all results).
+DDB_DLL std::vector<Entry> search(Database *db, const std::string &query, int limit = 100, int offset = 0);
+
+DDB_DLL void searchIndex(Database *db, const std::string &query, std::ostream &output,
+                         const std::string &format = "text", int limit = 100, int offset = 0);
+
+}
+
+#endif // SEARCH_H
@@ -10,6 +10,10 @@
 namespace ddb{
 
 std::mutex dbInitMutex;
+
+// Guards the caches and the (shared) database connection,
+// entries can be parsed by multiple threads
+std::mutex sensorCacheMutex;
 SqliteDatabase* SensorData::db = nullptr;
 std::map<std::string, double> SensorData::cacheHits;
 std::map<std::string, bool> SensorData::cacheMiss;
@@ -29,6 +33,7 @@ void SensorData::checkDbInit(){
 }
 
 bool SensorData::contains(const std::string &sensor){
+    std::lock_guard<std::mutex> guard(sensorCacheMutex);
     if (cacheHits.count(sensor) > 0) return true;
     if (cacheMiss.count(sensor) > 0) return false;
 
@@ -46,6 +51,7 @@ bool SensorData::contains(const std::string &sensor){
 }
 
 double SensorData::getFocal(const std::string &sensor){
+    std::lock_guard<std::mutex> guard(sensorCacheMutex);
     if (cacheHits.count(sensor) > 0) return cacheHits.at(sensor);
     if (cacheMiss.count(sensor) > 0) throw DBException("Cannot get focal value for " + sensor + ", no entry found");
 
@@ -63,6 +69,7 @@ double SensorData::getFocal(const std::string &sensor){
 }
 
 void SensorData::clearCache(){
+    std::lock_guard<std::mutex> guard(sensorCacheMutex);
     cacheHits.clear();
     cacheMiss.clear();
 }
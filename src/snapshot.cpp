@@ -0,0 +1,365 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "snapshot.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <unordered_map>
+
+#include "exceptions.h"
+#include "json.h"
+#include "logger.h"
+#include "mio.h"
+#include "utils.h"
+
+namespace ddb {
+
+IndexSnapshot::IndexSnapshot(Database *db) : db(db) {
+    if (db == nullptr) throw InvalidArgsException("Database pointer should not be null");
+}
+
+void IndexSnapshot::reset() {
+    rows = 0;
+    loaded = 0;
+
+    folders.clear();
+    folderIds.clear();
+    names.clear();
+    types.clear();
+    sizes.clear();
+    mtimes.clear();
+    captureTimes.clear();
+    cameraIds.clear();
+    cameras.clear();
+    lons.clear();
+    lats.clear();
+}
+
+void IndexSnapshot::invalidate() {
+    reset();
+}
+
+IndexSnapshot &IndexSnapshot::load(int columns) {
+    const int missing = columns & SCAll & ~loaded;
+    if (!missing) return *this;
+
+    // Build a query that fetches only the missing columns.
+    // Rows are ordered by rowid so that columns loaded by separate
+    // queries line up.
+    std::vector<std::string> fields;
+    if (missing & SCPath) fields.emplace_back("path");
+    if (missing & SCType) fields.emplace_back("type");
+    if (missing & SCSize) fields.emplace_back("size");
+    if (missing & SCMtime) fields.emplace_back("mtime");
+    if (missing & SCCaptureTime) fields.emplace_back(db->metaColumn("capture_time"));
+    if (missing & SCCamera) {
+        fields.emplace_back(db->metaColumn("make"));
+        fields.emplace_back(db->metaColumn("model"));
+    }
+    if (missing & SCLocation) {
+        fields.emplace_back("X(point_geom)");
+        fields.emplace_back("Y(point_geom)");
+    }
+
+    const std::string sql = "SELECT " + utils::join(fields) + " FROM entries ORDER BY rowid";
+    LOGD << "Loading snapshot columns: " << sql;
+
+    std::unordered_map<std::string, uint32_t> folderDict;
+    for (uint32_t i = 0; i < folders.size(); i++) folderDict[folders[i]] = i;
+
+    std::map<std::pair<std::string, std::string>, int32_t> cameraDict;
+    for (int32_t i = 0; i < static_cast<int32_t>(cameras.size()); i++) cameraDict[cameras[i]] = i;
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    size_t count = 0;
+
+    auto q = db->query(sql);
+    while (q->fetch()) {
+        int c = 0;
+
+        if (missing & SCPath) {
+            const std::string p = q->getText(c++);
+            const auto slash = p.rfind('/');
+            const std::string folder = slash == std::string::npos ? "" : p.substr(0, slash);
+
+            auto it = folderDict.find(folder);
+            if (it == folderDict.end()) {
+                it = folderDict.emplace(folder, static_cast<uint32_t>(folders.size())).first;
+                folders.push_back(folder);
+            }
+
+            folderIds.push_back(it->second);
+            names.push_back(slash == std::string::npos ? p : p.substr(slash + 1));
+        }
+
+        if (missing & SCType) types.push_back(static_cast<uint8_t>(q->getInt(c++)));
+        if (missing & SCSize) sizes.push_back(static_cast<std::uintmax_t>(q->getInt64(c++)));
+        if (missing & SCMtime) mtimes.push_back(q->getInt64(c++));
+
+        if (missing & SCCaptureTime) {
+            // A capture time of zero means "unknown" (see ExifParser::extractCaptureTime)
+            const double t = q->isNull(c) ? 0.0 : q->getDouble(c);
+            captureTimes.push_back(t > 0.0 ? t : nan);
+            c++;
+        }
+
+        if (missing & SCCamera) {
+            const bool hasCamera = !q->isNull(c) || !q->isNull(c + 1);
+            if (hasCamera) {
+                const auto key = std::make_pair(q->getText(c), q->getText(c + 1));
+                auto it = cameraDict.find(key);
+                if (it == cameraDict.end()) {
+                    it = cameraDict.emplace(key, static_cast<int32_t>(cameras.size())).first;
+                    cameras.push_back(key);
+                }
+                cameraIds.push_back(it->second);
+            } else {
+                cameraIds.push_back(-1);
+            }
+            c += 2;
+        }
+
+        if (missing & SCLocation) {
+            if (q->isNull(c)) {
+                lons.push_back(nan);
+                lats.push_back(nan);
+            } else {
+                lons.push_back(q->getDouble(c));
+                lats.push_back(q->getDouble(c + 1));
+            }
+            c += 2;
+        }
+
+        count++;
+    }
+
+    if (loaded != 0 && count != rows) {
+        // The index changed since the other columns were loaded,
+        // start over so that all columns come from the same state
+        LOGD << "Index changed (" << rows << " --> " << count << " rows), reloading snapshot";
+        const int all = loaded | columns;
+        reset();
+        return load(all);
+    }
+
+    rows = count;
+    loaded |= missing;
+
+    return *this;
+}
+
+std::string IndexSnapshot::path(size_t row) const {
+    if (!hasColumns(SCPath)) throw InvalidArgsException("Path column is not loaded");
+
+    const std::string &folder = folders[folderIds[row]];
+    return folder.empty() ? names[row] : folder + "/" + names[row];
+}
+
+// Directories have no size and nested DroneDB entries report the size of
+// files that are also indexed individually: neither counts toward totals
+static inline bool countsTowardSize(uint8_t type) {
+    return type != EntryType::Directory && type != EntryType::DroneDB;
+}
+
+std::uintmax_t IndexSnapshot::totalSize() {
+    load(SCType | SCSize);
+
+    std::uintmax_t total = 0;
+    const uint8_t *t = types.data();
+    const std::uintmax_t *s = sizes.data();
+    for (size_t i = 0; i < rows; i++) {
+        total += countsTowardSize(t[i]) ? s[i] : 0;
+    }
+
+    return total;
+}
+
+std::map<EntryType, TypeStats> IndexSnapshot::countByType() {
+    load(SCType | SCSize);
+
+    // Entry types fit in a small fixed array, avoid map lookups in the loop
+    std::array<TypeStats, 256> acc{};
+    const uint8_t *t = types.data();
+    const std::uintmax_t *s = sizes.data();
+    for (size_t i = 0; i < rows; i++) {
+        acc[t[i]].count++;
+        acc[t[i]].size += countsTowardSize(t[i]) ? s[i] : 0;
+    }
+
+    std::map<EntryType, TypeStats> result;
+    for (size_t i = 0; i < acc.size(); i++) {
+        if (acc[i].count > 0) result[static_cast<EntryType>(i)] = acc[i];
+    }
+
+    return result;
+}
+
+bool IndexSnapshot::captureTimeRange(double &min, double &max) {
+    load(SCCaptureTime);
+
+    min = std::numeric_limits<double>::infinity();
+    max = -std::numeric_limits<double>::infinity();
+
+    const double *ct = captureTimes.data();
+    for (size_t i = 0; i < rows; i++) {
+        // NaN comparisons are always false, so missing values are skipped
+        if (ct[i] < min) min = ct[i];
+        if (ct[i] > max) max = ct[i];
+    }
+
+    return min <= max;
+}
+
+std::vector<HistogramBin> IndexSnapshot::captureTimeHistogram(double binWidth) {
+    if (binWidth <= 0) throw InvalidArgsException("Histogram bin width must be positive");
+
+    load(SCCaptureTime);
+
+    // Sparse histogram: only bins with at least one entry are returned
+    std::map<int64_t, size_t> bins;
+    const double *ct = captureTimes.data();
+    for (size_t i = 0; i < rows; i++) {
+        if (std::isnan(ct[i])) continue;
+        bins[static_cast<int64_t>(std::floor(ct[i] / binWidth))]++;
+    }
+
+    std::vector<HistogramBin> result;
+    result.reserve(bins.size());
+    for (const auto &b : bins) {
+        result.push_back({static_cast<double>(b.first) * binWidth, b.second});
+    }
+
+    return result;
+}
+
+std::vector<CameraStats> IndexSnapshot::cameraBreakdown() {
+    load(SCCamera);
+
+    std::vector<size_t> counts(cameras.size(), 0);
+    const int32_t *c = cameraIds.data();
+    for (size_t i = 0; i < rows; i++) {
+        if (c[i] >= 0) counts[c[i]]++;
+    }
+
+    std::vector<CameraStats> result;
+    result.reserve(cameras.size());
+    for (size_t i = 0; i < cameras.size(); i++) {
+        result.push_back({cameras[i].first, cameras[i].second, counts[i]});
+    }
+
+    std::sort(result.begin(), result.end(), [](const CameraStats &l, const CameraStats &r) {
+        return l.count > r.count;
+    });
+
+    return result;
+}
+
+bool IndexSnapshot::extent(double &minLon, double &minLat, double &maxLon, double &maxLat) {
+    load(SCLocation);
+
+    minLon = minLat = std::numeric_limits<double>::infinity();
+    maxLon = maxLat = -std::numeric_limits<double>::infinity();
+
+    const double *x = lons.data();
+    const double *y = lats.data();
+    for (size_t i = 0; i < rows; i++) {
+        if (x[i] < minLon) minLon = x[i];
+        if (x[i] > maxLon) maxLon = x[i];
+        if (y[i] < minLat) minLat = y[i];
+        if (y[i] > maxLat) maxLat = y[i];
+    }
+
+    return minLon <= maxLon;
+}
+
+std::string formatCaptureTime(double ms) {
+    const time_t t = static_cast<time_t>(ms / 1000.0);
+    std::ostringstream os;
+    os << std::put_time(std::gmtime(&t), "%Y-%m-%d %H:%M:%S UTC");
+    return os.str();
+}
+
+#define STATS_HISTOGRAM_BIN 86400000.0  // 1 day
+
+void stats(Database *db, std::ostream &output, const std::string &format) {
+    if (format != "json" && format != "text")
+        throw InvalidArgsException("Invalid format " + format);
+
+    IndexSnapshot snapshot(db);
+    snapshot.load(SCType | SCSize | SCCaptureTime | SCCamera | SCLocation);
+
+    const auto byType = snapshot.countByType();
+    const auto cameras = snapshot.cameraBreakdown();
+
+    double minTime, maxTime;
+    const bool hasTime = snapshot.captureTimeRange(minTime, maxTime);
+
+    double minLon, minLat, maxLon, maxLat;
+    const bool hasExtent = snapshot.extent(minLon, minLat, maxLon, maxLat);
+
+    if (format == "json") {
+        json j;
+        j["entries"] = snapshot.size();
+        j["totalSize"] = snapshot.totalSize();
+
+        j["types"] = json::object();
+        for (const auto &t : byType) {
+            j["types"][typeToHuman(t.first)] = {{"count", t.second.count}, {"size", t.second.size}};
+        }
+
+        if (hasTime) {
+            j["captureTime"] = {{"min", minTime}, {"max", maxTime}};
+            j["captureTime"]["histogram"] = json::array();
+            for (const auto &b : snapshot.captureTimeHistogram(STATS_HISTOGRAM_BIN)) {
+                j["captureTime"]["histogram"].push_back(json::array({b.start, b.count}));
+            }
+        } else {
+            j["captureTime"] = nullptr;
+        }
+
+        j["cameras"] = json::array();
+        for (const auto &c : cameras) {
+            j["cameras"].push_back({{"make", c.make}, {"model", c.model}, {"count", c.count}});
+        }
+
+        if (hasExtent) j["extent"] = {minLon, minLat, maxLon, maxLat};
+        else j["extent"] = nullptr;
+
+        output << j.dump();
+    } else {
+        output << "Entries: " << snapshot.size() << std::endl;
+        output << "Total size: " << io::bytesToHuman(snapshot.totalSize()) << std::endl;
+
+        output << "Types:" << std::endl;
+        for (const auto &t : byType) {
+            output << "\t" << typeToHuman(t.first) << ": " << t.second.count;
+            if (t.second.size > 0) output << " (" << io::bytesToHuman(t.second.size) << ")";
+            output << std::endl;
+        }
+
+        if (hasTime) {
+            output << "Capture time: " << formatCaptureTime(minTime) << " - "
+                   << formatCaptureTime(maxTime) << std::endl;
+        }
+
+        if (!cameras.empty()) {
+            output << "Cameras:" << std::endl;
+            for (const auto &c : cameras) {
+                output << "\t" << c.make << " " << c.model << ": " << c.count << std::endl;
+            }
+        }
+
+        if (hasExtent) {
+            output << "Extent: " << std::setprecision(13) << "[" << minLon << ", " << minLat
+                   << "],[" << maxLon << ", " << maxLat << "]" << std::endl;
+        }
+    }
+}
+
+}  // namespace ddb
@@ -0,0 +1,107 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "database.h"
+#include "entry_types.h"
+#include "ddb_export.h"
+
+namespace ddb {
+
+// Columns that can be loaded into an IndexSnapshot
+enum SnapshotColumn {
+    SCPath = 1 << 0,
+    SCType = 1 << 1,
+    SCSize = 1 << 2,
+    SCMtime = 1 << 3,
+    SCCaptureTime = 1 << 4,
+    SCCamera = 1 << 5,
+    SCLocation = 1 << 6,
+    SCAll = (1 << 7) - 1
+};
+
+struct TypeStats {
+    size_t count = 0;
+    std::uintmax_t size = 0;
+};
+
+struct CameraStats {
+    std::string make;
+    std::string model;
+    size_t count = 0;
+};
+
+struct HistogramBin {
+    double start;
+    size_t count;
+};
+
+// In-memory, column oriented copy of the entries table.
+// Each column is stored in its own contiguous array and
+// loaded lazily, so that aggregates only read
+// (and only fetch from the database) the columns they need.
+// Row i of every column refers to the same entry.
+class IndexSnapshot {
+    Database *db;
+    size_t rows = 0;
+    int loaded = 0;
+
+    // Paths are split into a folder dictionary and a file name
+    std::vector<std::string> folders;
+    std::vector<uint32_t> folderIds;
+    std::vector<std::string> names;
+
+    std::vector<uint8_t> types;
+    std::vector<std::uintmax_t> sizes;
+    std::vector<int64_t> mtimes;
+
+    // Milliseconds since epoch (like meta.captureTime), NaN when not available
+    std::vector<double> captureTimes;
+
+    // Index into cameras, -1 when not available
+    std::vector<int32_t> cameraIds;
+    std::vector<std::pair<std::string, std::string>> cameras;
+
+    // NaN when not available
+    std::vector<double> lons;
+    std::vector<double> lats;
+
+    void reset();
+
+  public:
+    DDB_DLL IndexSnapshot(Database *db);
+
+    // Make sure that the requested columns (a combination of SnapshotColumn)
+    // are available. Columns that are already loaded are not fetched again.
+    DDB_DLL IndexSnapshot &load(int columns);
+
+    // Discard all loaded columns
+    DDB_DLL void invalidate();
+
+    DDB_DLL size_t size() const { return rows; }
+    DDB_DLL bool hasColumns(int columns) const { return (loaded & columns) == columns; }
+
+    DDB_DLL std::string path(size_t row) const;
+    DDB_DLL EntryType type(size_t row) const { return static_cast<EntryType>(types[row]); }
+
+    // Aggregates (capture times and bin widths are in milliseconds)
+    DDB_DLL std::uintmax_t totalSize();
+    DDB_DLL std::map<EntryType, TypeStats> countByType();
+    DDB_DLL bool captureTimeRange(double &min, double &max);
+    DDB_DLL std::vector<HistogramBin> captureTimeHistogram(double binWidth);
+    DDB_DLL std::vector<CameraStats> cameraBreakdown();
+    DDB_DLL bool extent(double &minLon, double &minLat, double &maxLon, double &maxLat);
+};
+
+DDB_DLL void stats(Database *db, std::ostream &output, const std::string &format = "text");
+
+}
+
+#endif // SNAPSHOT_H
@@ -14,10 +14,11 @@ namespace ddb{
 
 SqliteDatabase::SqliteDatabase() : db(nullptr) {}
 
-SqliteDatabase &SqliteDatabase::open(const std::string &file) {
+SqliteDatabase &SqliteDatabase::open(const std::string &file, bool readOnly) {
     if (db != nullptr) throw DBException("Can't open database " + file + ", one is already open (" + openFile + ")");
     LOGD << "Opening connection to " << file;
-    if( sqlite3_open(file.c_str(), &db) != SQLITE_OK ) throw DBException("Can't open database: " + file);
+    const int flags = readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    if( sqlite3_open_v2(file.c_str(), &db, flags, nullptr) != SQLITE_OK ) throw DBException("Can't open database: " + file);
 
 //    if( sqlite3_enable_load_extension(db, 1) != SQLITE_OK ) throw DBException("Cannot enable load extension");
 //    char *errMsg;
@@ -71,6 +72,19 @@ bool SqliteDatabase::tableExists(const std::string &table){
     return false;
 }
 
+bool SqliteDatabase::columnExists(const std::string &table, const std::string &column){
+    // table_xinfo (unlike table_info) also lists generated columns
+    auto q = query("SELECT count(*) FROM pragma_table_xinfo(?) WHERE name=?");
+    q->bind(1, table);
+    q->bind(2, column);
+
+    if (q->fetch()){
+        return q->getInt(0) == 1;
+    }
+
+    return false;
+}
+
 std::string SqliteDatabase::getOpenFile(){
     return openFile;
 }
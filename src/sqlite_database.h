@@ -25,11 +25,13 @@ class SqliteDatabase {
     std::string openFile;
   public:
     DDB_DLL SqliteDatabase();
-    DDB_DLL SqliteDatabase &open(const std::string &file);
+    // A read only connection never creates the file nor writes to it
+    DDB_DLL SqliteDatabase &open(const std::string &file, bool readOnly = false);
     DDB_DLL virtual void afterOpen();
     DDB_DLL SqliteDatabase &close();
     DDB_DLL SqliteDatabase &exec(const std::string &sql);
     DDB_DLL bool tableExists(const std::string &table);
+    DDB_DLL bool columnExists(const std::string &table, const std::string &column);
     DDB_DLL std::string getOpenFile();
     DDB_DLL int changes();
     DDB_DLL void setJournalMode(const std::string &mode);
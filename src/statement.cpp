@@ -51,6 +51,20 @@ Statement &Statement::bind(int paramNum, long long value) {
     return *this;
 }
 
+Statement &Statement::bind(int paramNum, double value) {
+    assert(stmt != nullptr && db != nullptr);
+    LOGD << "Bind " << value << " as param " << paramNum;
+    bindCheck(sqlite3_bind_double(stmt, paramNum, value));
+    return *this;
+}
+
+Statement &Statement::bindNull(int paramNum) {
+    assert(stmt != nullptr && db != nullptr);
+    LOGD << "Bind NULL as param " << paramNum;
+    bindCheck(sqlite3_bind_null(stmt, paramNum));
+    return *this;
+}
+
 Statement &Statement::step() {
     assert(stmt != nullptr);
 
@@ -101,6 +115,18 @@ double Statement::getDouble(int columnId){
     return sqlite3_column_double(stmt, columnId);
 }
 
+const void *Statement::getBlob(int columnId, int &size){
+    assert(stmt != nullptr);
+    const void *res = sqlite3_column_blob(stmt, columnId);
+    size = sqlite3_column_bytes(stmt, columnId);
+    return res;
+}
+
+bool Statement::isNull(int columnId){
+    assert(stmt != nullptr);
+    return sqlite3_column_type(stmt, columnId) == SQLITE_NULL;
+}
+
 int Statement::getColumnsCount() const
 {
     assert(stmt != nullptr);
@@ -28,6 +28,8 @@ class Statement {
     DDB_DLL Statement &bind(int paramNum, const std::string &value);
     DDB_DLL Statement &bind(int paramNum, int value);
     DDB_DLL Statement &bind(int paramNum, long long value);
+    DDB_DLL Statement &bind(int paramNum, double value);
+    DDB_DLL Statement &bindNull(int paramNum);
 
     DDB_DLL bool fetch();
 
@@ -35,6 +37,10 @@ class Statement {
     DDB_DLL long long getInt64(int columnId);
     DDB_DLL std::string getText(int columnId);
     DDB_DLL double getDouble(int columnId);
+    DDB_DLL bool isNull(int columnId);
+
+    // Pointer to the column bytes, valid until the next fetch (nullptr if NULL)
+    DDB_DLL const void *getBlob(int columnId, int &size);
 
     DDB_DLL int getColumnsCount() const;
     // TODO: more
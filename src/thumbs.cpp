@@ -1,6 +1,8 @@
 /* This Source Code Form is subject to the terms of the Mozilla Public
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <fstream>
+#include <memory>
 #include <sstream>
 #include <cstdlib>
 #include <gdal_priv.h>
@@ -13,21 +15,37 @@
 #include "userprofile.h"
 #include "dbops.h"
 #include "mio.h"
+#include "pointcloud.h"
+#include "video.h"
+#include "usercache.h"
 
 namespace ddb{
 
 fs::path getThumbFromUserCache(const fs::path &imagePath, int thumbSize, bool forceRecreate){
     if (std::rand() % 1000 == 0) cleanupThumbsUserCache();
+
+    // Hot thumbnails are served from memory, without touching the filesystem
+    const std::string key = imagePath.string() + "*" + std::to_string(thumbSize);
+    if (!forceRecreate){
+        const fs::path cached = UserCacheIndex::thumbs().lookup(key);
+        if (!cached.empty()) return cached;
+    }
+
     if (!fs::exists(imagePath)) throw FSException(imagePath.string() + " does not exist");
 
     fs::path outdir = UserProfile::get()->getThumbsDir(thumbSize);
     io::Path p = imagePath;
-    fs::path thumbPath = outdir / getThumbFilename(imagePath, p.getModifiedTime(), thumbSize);
-    return generateThumb(imagePath, thumbSize, thumbPath, forceRecreate);
+    const time_t modifiedTime = p.getModifiedTime();
+    fs::path thumbPath = outdir / getThumbFilename(imagePath, modifiedTime, thumbSize);
+    thumbPath = generateThumb(imagePath, thumbSize, thumbPath, forceRecreate);
+
+    UserCacheIndex::thumbs().store(key, imagePath, modifiedTime, thumbPath);
+    return thumbPath;
 }
 
 bool supportsThumbnails(EntryType type){
-    return type == EntryType::Image || type == EntryType::GeoImage || type == EntryType::GeoRaster;
+    return type == EntryType::Image || type == EntryType::GeoImage || type == EntryType::GeoRaster ||
+           type == EntryType::PointCloud || type == EntryType::Video || type == EntryType::GeoVideo;
 }
 
 void generateThumbs(const std::vector<std::string> &input, const fs::path &output, int thumbSize, bool useCrc){
@@ -61,12 +79,58 @@ void generateThumbs(const std::vector<std::string> &input, const fs::path &outpu
 fs::path getThumbFilename(const fs::path &imagePath, time_t modifiedTime, int thumbSize){
     // Thumbnails are JPG files idenfitied by:
     // CRC64(imagePath + "*" + modifiedTime + "*" + thumbSize).jpg
-    std::ostringstream os;
-    os << imagePath.string() << "*" << modifiedTime << "*" << thumbSize;
-    return fs::path(Hash::strCRC64(os.str()) + ".jpg");
+    // (or XXH64, see Hash::cacheKey)
+    const std::string key = imagePath.string() + "*" + std::to_string(modifiedTime) + "*" + std::to_string(thumbSize);
+    return fs::path(Hash::cacheKey(key) + ".jpg");
 }
 
 
+#define VIDEO_PLACEHOLDER_WIDTH 320
+#define VIDEO_PLACEHOLDER_HEIGHT 180
+
+// Gray 16:9 frame with a play symbol, for videos without a still image
+// (H.264/H.265 frames cannot be decoded)
+static void writeVideoPlaceholder(const fs::path &outputFile){
+    const int width = VIDEO_PLACEHOLDER_WIDTH, height = VIDEO_PLACEHOLDER_HEIGHT;
+    const size_t pixels = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> bands(pixels * 3, 64);
+
+    // Triangle pointing right, centered
+    const int size = height / 3;
+    const int left = (width - size) / 2, top = (height - size) / 2;
+    for (int y = 0; y < size; y++){
+        const int half = std::min(y, size - 1 - y);
+        for (int x = 0; x <= half * 2 && x < size; x++){
+            const size_t i = static_cast<size_t>(top + y) * width + left + x;
+            for (int b = 0; b < 3; b++) bands[b * pixels + i] = 230;
+        }
+    }
+
+    GDALDriverH hDriver = GDALGetDriverByName("GTiff");
+    if (!hDriver) throw GDALException("Cannot create GTiff driver");
+    GDALDatasetH hDataset = GDALCreate(hDriver, outputFile.string().c_str(), width, height, 3, GDT_Byte, nullptr);
+    if (!hDataset) throw GDALException("Cannot create " + outputFile.string());
+
+    const bool written = GDALDatasetRasterIO(hDataset, GF_Write, 0, 0, width, height, bands.data(),
+                                             width, height, GDT_Byte, 3, nullptr, 0, 0, 0) == CE_None;
+    GDALClose(hDataset);
+
+    if (!written) throw GDALException("Cannot write " + outputFile.string());
+}
+
+// Intermediate file with a unique name in the temp directory,
+// removed when going out of scope
+struct TmpFile{
+    const fs::path path;
+    TmpFile(const std::string &ext) :
+        path(fs::temp_directory_path() / ("ddb-thumb-" + utils::generateRandomString(16) + ext)){}
+    ~TmpFile(){
+        std::error_code e;
+        fs::remove(path, e);
+        if (e) LOGD << "Cannot remove " << path.string();
+    }
+};
+
 // imagePath can be either absolute or relative and it's up to the user to
 // invoke the function properly as to avoid conflicts with relative paths
 fs::path generateThumb(const fs::path &imagePath, int thumbSize, const fs::path &outImagePath, bool forceRecreate){
@@ -81,11 +145,43 @@ fs::path generateThumb(const fs::path &imagePath, int thumbSize, const fs::path
     LOGD << "OutImagePath = " << outImagePath;
     LOGD << "Size = " << thumbSize;
 
+    // Point clouds are first rendered to a raster of the right size
+    fs::path sourcePath = imagePath;
+    std::unique_ptr<TmpFile> tmpFile;
+    const bool pointCloud = io::Path(imagePath).checkExtension({"laz", "las"});
+    if (pointCloud){
+        tmpFile = std::make_unique<TmpFile>(".tif");
+        sourcePath = tmpFile->path;
+        rasterizePointCloud(imagePath.string(), sourcePath.string(), thumbSize);
+    }
+
+    // Videos use a still image stored in the file (a Motion JPEG frame or the
+    // cover image). There is no video decoder, so H.264/H.265 videos without
+    // a cover image get a placeholder.
+    const bool video = io::Path(imagePath).checkExtension({"mp4", "mov"});
+    bool placeholder = false;
+    std::vector<uint8_t> frame;
+    if (video && !extractVideoStill(imagePath.string(), frame)){
+        LOGD << "Cannot extract a frame from " << imagePath.string() << ", using a placeholder";
+        placeholder = true;
+        tmpFile = std::make_unique<TmpFile>(".tif");
+        sourcePath = tmpFile->path;
+        writeVideoPlaceholder(sourcePath);
+    }else if (video){
+        const bool png = frame.size() >= 4 && frame[0] == 0x89 && frame[1] == 'P' && frame[2] == 'N' && frame[3] == 'G';
+        tmpFile = std::make_unique<TmpFile>(png ? ".png" : ".jpg");
+        sourcePath = tmpFile->path;
+        std::ofstream f(sourcePath.string(), std::ios::binary);
+        f.write(reinterpret_cast<const char *>(frame.data()), frame.size());
+        f.close();
+        if (!f) throw FSException("Cannot write " + sourcePath.string());
+    }
+
     // Compute image with GDAL otherwise
-    GDALDatasetH hSrcDataset = GDALOpen(imagePath.string().c_str(), GA_ReadOnly);
+    GDALDatasetH hSrcDataset = GDALOpen(sourcePath.string().c_str(), GA_ReadOnly);
 
     if (!hSrcDataset)
-        throw GDALException("Cannot open " + imagePath.string() + " for reading");
+        throw GDALException("Cannot open " + sourcePath.string() + " for reading");
   
     int width = GDALGetRasterXSize(hSrcDataset);
     int height = GDALGetRasterYSize(hSrcDataset);
@@ -108,13 +204,14 @@ fs::path generateThumb(const fs::path &imagePath, int thumbSize, const fs::path
     targs = CSLAddString(targs, "-ot");
     targs = CSLAddString(targs, "Byte");
 
-    targs = CSLAddString(targs, "-scale");
+    // Point cloud previews and placeholders are already 8 bit
+    if (!pointCloud && !placeholder) targs = CSLAddString(targs, "-scale");
 
     targs = CSLAddString(targs, "-co");
     targs = CSLAddString(targs, "WRITE_EXIF_METADATA=NO");
 
-    // Max 3 bands + alpha
-    if (GDALGetRasterCount(hSrcDataset) > 4){
+    // Max 3 bands + alpha (point cloud previews: RGB only, JPGs have no alpha)
+    if (GDALGetRasterCount(hSrcDataset) > 4 || pointCloud){
         targs = CSLAddString(targs, "-b");
         targs = CSLAddString(targs, "1");
         targs = CSLAddString(targs, "-b");
@@ -142,6 +239,7 @@ fs::path generateThumb(const fs::path &imagePath, int thumbSize, const fs::path
 
 void cleanupThumbsUserCache(){
     LOGD << "Cleaning up thumbs user cache";
+    UserCacheIndex::thumbs().clear();
 
     time_t threshold = utils::currentUnixTimestamp() - 60 * 60 * 24 * 5; // 5 days
     fs::path thumbsDir = UserProfile::get()->getThumbsDir();
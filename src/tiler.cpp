@@ -14,7 +14,11 @@
 #include "hash.h"
 #include "logger.h"
 #include "mio.h"
+#include "overviews.h"
+#include "pointcloud.h"
+#include "projection.h"
 #include "userprofile.h"
+#include "usercache.h"
 
 namespace ddb {
 
@@ -368,15 +372,24 @@ BoundingBox<int> TilerHelper::parseZRange(const std::string &zRange) {
 
 fs::path TilerHelper::getCacheFolderName(const fs::path &tileablePath,
                                          time_t modifiedTime, int tileSize) {
-    std::ostringstream os;
-    os << tileablePath.string() << "*" << modifiedTime << "*" << tileSize;
-    return Hash::strCRC64(os.str());
+    return Hash::cacheKey(tileablePath.string() + "*" + std::to_string(modifiedTime) +
+                          "*" + std::to_string(tileSize));
 }
 
 fs::path TilerHelper::getFromUserCache(const fs::path &tileablePath, int tz,
                                        int tx, int ty, int tileSize, bool tms,
                                        bool forceRecreate) {
     if (std::rand() % 1000 == 0) cleanupUserCache();
+
+    // Hot tiles are served from memory, without touching the filesystem
+    const std::string key = tileablePath.string() + "*" + std::to_string(tileSize) +
+                            (tms ? "*t*" : "*x*") + std::to_string(tz) + "/" +
+                            std::to_string(tx) + "/" + std::to_string(ty);
+    if (!forceRecreate) {
+        const fs::path cached = UserCacheIndex::tiles().lookup(key);
+        if (!cached.empty()) return cached;
+    }
+
     if (!fs::exists(tileablePath))
         throw FSException(tileablePath.string() + " does not exist");
 
@@ -389,24 +402,36 @@ fs::path TilerHelper::getFromUserCache(const fs::path &tileablePath, int tz,
 
     // Cache hit
     if (fs::exists(outputFile) && !forceRecreate) {
+        UserCacheIndex::tiles().store(key, tileablePath, modifiedTime, outputFile);
         return outputFile;
     }
 
     const fs::path fileToTile = toGeoTIFF(tileablePath, tileSize, forceRecreate,
                                           (tileCacheFolder / "geoprojected.tif"));
     Tiler t(fileToTile.string(), tileCacheFolder.string(), tileSize, tms);
-    return t.tile(tz, tx, ty);
+    outputFile = t.tile(tz, tx, ty);
+
+    UserCacheIndex::tiles().store(key, tileablePath, modifiedTime, outputFile);
+    return outputFile;
 }
 
 std::mutex geoprojectMutex;
 
+#define POINTCLOUD_PREVIEW_SIZE 2048
+
 fs::path TilerHelper::toGeoTIFF(const fs::path &tileablePath, int tileSize,
                                 bool forceRecreate,
                                 const fs::path &outputGeotiff) {
     const EntryType type = fingerprint(tileablePath);
 
     if (type == EntryType::GeoRaster) {
-        // Georasters can be tiled directly
+        // Georasters can be tiled directly, through the overviews
+        // built by "ddb build" when available (much faster at low zoom levels)
+        const fs::path overviews = findBuiltOverviews(tileablePath);
+        if (!overviews.empty()) {
+            LOGD << "Using overviews " << overviews.string();
+            return overviews;
+        }
         return tileablePath;
     } else {
         fs::path outputPath = outputGeotiff;
@@ -435,8 +460,14 @@ fs::path TilerHelper::toGeoTIFF(const fs::path &tileablePath, int tileSize,
             // Recheck is needed for other processes that might have generated
             // the file
             if (!fs::exists(outputPath)){
-                ddb::geoProject({tileablePath.string()}, outputPath.string(),
-                                "100%", true);
+                if (type == EntryType::PointCloud) {
+                    // Point clouds are rendered to a georeferenced preview
+                    ddb::rasterizePointCloud(tileablePath.string(), outputPath.string(),
+                                             POINTCLOUD_PREVIEW_SIZE);
+                } else {
+                    ddb::geoProject({tileablePath.string()}, outputPath.string(),
+                                    "100%", true);
+                }
             }
         }
 
@@ -446,6 +477,7 @@ fs::path TilerHelper::toGeoTIFF(const fs::path &tileablePath, int tileSize,
 
 void TilerHelper::cleanupUserCache() {
     LOGD << "Cleaning up tiles user cache";
+    UserCacheIndex::tiles().clear();
 
     const time_t threshold =
         utils::currentUnixTimestamp() - 60 * 60 * 24 * 5;  // 5 days
@@ -657,12 +689,9 @@ BoundingBox<Projected2D> GlobalMercator::tileBounds(int tx, int ty,
 }
 
 Geographic2D GlobalMercator::metersToLatLon(double mx, double my) const {
-    double lon = mx / originShift * 180.0;
-    double lat = my / originShift * 180.0;
-
-    lat = 180.0 / M_PI *
-          (2 * std::atan(std::exp(lat * M_PI / 180.0)) - M_PI / 2.0);
-    return Geographic2D(lon, lat);
+    Geographic2D g;
+    webMercatorToGeographic(mx, my, g.latitude, g.longitude);
+    return g;
 }
 
 Projected2Di GlobalMercator::metersToTile(double mx, double my,
@@ -9,7 +9,7 @@
 
 using namespace ddb;
 
-bool Timezone::initialized = false;
+std::atomic<bool> Timezone::initialized(false);
 ZoneDetect *Timezone::db = nullptr;
 std::mutex timezoneMutex;
 
@@ -20,6 +20,7 @@ std::mutex timezoneMutex;
 void Timezone::init() {
     if (initialized) return;
     std::lock_guard<std::mutex> guard(timezoneMutex);
+    if (initialized) return; // Another thread got here first
 
     ZDSetErrorHandler(onError);
     fs::path dbPath = io::getDataPath("timezone21.bin");
@@ -4,13 +4,14 @@
 #ifndef TIMEZONE_H
 #define TIMEZONE_H
 
+#include <atomic>
 #include "cctz/time_zone.h"
 #include "../vendor/zonedetect/zonedetect.h"
 #include "ddb_export.h"
 
 class Timezone{
 public:
-    static bool initialized;
+    static std::atomic<bool> initialized;
     static ZoneDetect *db;
 
     DDB_DLL static void init();
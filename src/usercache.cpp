@@ -0,0 +1,127 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include "usercache.h"
+#include "exceptions.h"
+#include "mio.h"
+
+namespace ddb {
+
+double UserCacheStats::hitRate() const{
+    const uint64_t total = hits + misses;
+    return total > 0 ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+}
+
+json UserCacheStats::toJSON() const{
+    return {
+        {"hits", hits},
+        {"misses", misses},
+        {"revalidations", revalidations},
+        {"entries", entries},
+        {"hitRate", hitRate()}
+    };
+}
+
+UserCacheIndex::UserCacheIndex(size_t capacity, int revalidateSeconds) :
+    capacity(capacity), revalidateInterval(revalidateSeconds){
+}
+
+fs::path UserCacheIndex::lookup(const std::string &key){
+    Item item;
+
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        const auto it = index.find(key);
+        if (it == index.end()){
+            stats.misses++;
+            return fs::path();
+        }
+
+        items.splice(items.begin(), items, it->second);
+        if (std::chrono::steady_clock::now() - it->second->checked < revalidateInterval){
+            stats.hits++;
+            return it->second->file;
+        }
+
+        item = *it->second;
+    }
+
+    // Revalidate without holding the lock, the source might
+    // be on a slow filesystem
+    bool valid = false;
+    try{
+        valid = io::Path(item.source).getModifiedTime() == item.mtime && fs::exists(item.file);
+    }catch(const FSException &){
+        // Source was removed
+    }
+
+    std::lock_guard<std::mutex> guard(mutex);
+    const auto it = index.find(key);
+    if (valid){
+        stats.hits++;
+        stats.revalidations++;
+        if (it != index.end()) it->second->checked = std::chrono::steady_clock::now();
+        return item.file;
+    }
+
+    stats.misses++;
+    if (it != index.end() && it->second->file == item.file){
+        items.erase(it->second);
+        index.erase(it);
+    }
+    return fs::path();
+}
+
+void UserCacheIndex::store(const std::string &key, const fs::path &source, time_t mtime, const fs::path &file){
+    if (capacity == 0) return;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    const auto it = index.find(key);
+    if (it != index.end()){
+        items.erase(it->second);
+        index.erase(it);
+    }
+
+    items.push_front({key, source, file, mtime, std::chrono::steady_clock::now()});
+    index[key] = items.begin();
+    evict();
+}
+
+void UserCacheIndex::evict(){
+    while (items.size() > capacity){
+        index.erase(items.back().key);
+        items.pop_back();
+    }
+}
+
+void UserCacheIndex::clear(){
+    std::lock_guard<std::mutex> guard(mutex);
+    items.clear();
+    index.clear();
+}
+
+void UserCacheIndex::setLimits(size_t capacity, int revalidateSeconds){
+    std::lock_guard<std::mutex> guard(mutex);
+    this->capacity = capacity;
+    revalidateInterval = std::chrono::seconds(revalidateSeconds);
+    evict();
+}
+
+UserCacheStats UserCacheIndex::getStats() const{
+    std::lock_guard<std::mutex> guard(mutex);
+    UserCacheStats s = stats;
+    s.entries = items.size();
+    return s;
+}
+
+UserCacheIndex &UserCacheIndex::thumbs(){
+    static UserCacheIndex instance;
+    return instance;
+}
+
+UserCacheIndex &UserCacheIndex::tiles(){
+    static UserCacheIndex instance;
+    return instance;
+}
+
+}
@@ -0,0 +1,71 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef USERCACHE_H
+#define USERCACHE_H
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "fs.h"
+#include "json.h"
+#include "ddb_export.h"
+
+namespace ddb {
+
+struct UserCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t revalidations = 0; // Hits that had to check the filesystem
+    size_t entries = 0;
+
+    DDB_DLL double hitRate() const;
+    DDB_DLL json toJSON() const;
+};
+
+// In-memory LRU of the files already generated in the user cache
+// (thumbnails, tiles), so that hot requests can be served without
+// probing the filesystem. Entries are revalidated against the
+// modified time of their source file at most every revalidateSeconds.
+class UserCacheIndex {
+    struct Item {
+        std::string key;
+        fs::path source;
+        fs::path file;
+        time_t mtime;
+        std::chrono::steady_clock::time_point checked;
+    };
+
+    size_t capacity;
+    std::chrono::seconds revalidateInterval;
+
+    std::list<Item> items; // Most recently used first
+    std::unordered_map<std::string, std::list<Item>::iterator> index;
+    UserCacheStats stats;
+    mutable std::mutex mutex;
+
+    void evict();
+  public:
+    DDB_DLL UserCacheIndex(size_t capacity = 4096, int revalidateSeconds = 5);
+
+    // Returns the cached file for key, or an empty path if there's none
+    // (or if it's no longer valid)
+    DDB_DLL fs::path lookup(const std::string &key);
+
+    // Remembers that file was generated from source, as it was at mtime
+    DDB_DLL void store(const std::string &key, const fs::path &source, time_t mtime, const fs::path &file);
+
+    DDB_DLL void clear();
+    DDB_DLL void setLimits(size_t capacity, int revalidateSeconds);
+    DDB_DLL UserCacheStats getStats() const;
+
+    DDB_DLL static UserCacheIndex &thumbs();
+    DDB_DLL static UserCacheIndex &tiles();
+};
+
+}
+
+#endif // USERCACHE_H
@@ -96,6 +96,10 @@ fs::path UserProfile::getAuthFile(){
     return getProfileDir() / "auth.json";
 }
 
+fs::path UserProfile::getCatalogFile(){
+    return getProfileDir() / "catalog.sqlite";
+}
+
 AuthManager *UserProfile::getAuthManager(){
     return authManager;
 }
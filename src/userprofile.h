@@ -25,6 +25,7 @@ public:
     DDB_DLL fs::path getTemplatesDir();
 
     DDB_DLL fs::path getAuthFile();
+    DDB_DLL fs::path getCatalogFile();
 
     DDB_DLL AuthManager *getAuthManager();
 private:
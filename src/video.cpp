@@ -0,0 +1,549 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <regex>
+
+#include "video.h"
+#include "fs.h"
+#include "logger.h"
+
+namespace ddb{
+
+// The movie box holds the sample tables and grows with the length of the video
+// (roughly 1MB per hour at 60fps), anything larger is not worth loading
+#define MP4_MAX_MOOV_SIZE (64 * 1024 * 1024)
+
+// About 48 hours at 60fps, tracks that claim more samples are corrupt
+#define MP4_MAX_SAMPLES (10 * 1024 * 1024)
+
+// Telemetry subtitles are short, larger samples are not telemetry
+#define MP4_MAX_TEXT_SAMPLE 4096
+
+// Media data is big endian
+static inline uint16_t readBE16(const uint8_t *p){
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t readBE32(const uint8_t *p){
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static inline uint64_t readBE64(const uint8_t *p){
+    return (static_cast<uint64_t>(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+struct Mp4Box{
+    std::string type;
+    const uint8_t *data; // payload
+    size_t size;
+};
+
+static std::vector<Mp4Box> childBoxes(const uint8_t *data, size_t size){
+    std::vector<Mp4Box> boxes;
+    size_t offset = 0;
+    while (offset + 8 <= size){
+        uint64_t boxSize = readBE32(data + offset);
+        size_t header = 8;
+        if (boxSize == 1){
+            if (offset + 16 > size) break;
+            boxSize = readBE64(data + offset + 8);
+            header = 16;
+        }else if (boxSize == 0){
+            boxSize = size - offset;
+        }
+        if (boxSize < header || boxSize > size - offset) break;
+
+        boxes.push_back({std::string(reinterpret_cast<const char *>(data + offset + 4), 4),
+                         data + offset + header, static_cast<size_t>(boxSize - header)});
+        offset += static_cast<size_t>(boxSize);
+    }
+    return boxes;
+}
+
+static const Mp4Box *findBox(const std::vector<Mp4Box> &boxes, const std::string &type){
+    for (const auto &b : boxes){
+        if (b.type == type) return &b;
+    }
+    return nullptr;
+}
+
+// Follows a path of nested boxes (e.g. "mdia/minf/stbl")
+static bool findPath(const Mp4Box &parent, const std::vector<std::string> &path, Mp4Box &result){
+    Mp4Box current = parent;
+    for (const auto &type : path){
+        const auto children = childBoxes(current.data, current.size);
+        const auto b = findBox(children, type);
+        if (b == nullptr) return false;
+        current = *b;
+    }
+    result = current;
+    return true;
+}
+
+struct Mp4Track{
+    std::string handler; // "vide", "soun", "text", "sbtl", ...
+    std::string format;  // sample entry type ("avc1", "tx3g", "jpeg", ...)
+    uint32_t timescale = 0;
+    uint64_t duration = 0;
+    int width = 0;
+    int height = 0;
+
+    std::vector<uint32_t> sampleSizes;
+    std::vector<uint64_t> chunkOffsets;
+    std::vector<std::pair<uint32_t, uint32_t>> samplesPerChunk; // first chunk (1-based), samples
+    std::vector<std::pair<uint32_t, uint32_t>> timeToSample;    // count, delta
+    std::vector<uint32_t> syncSamples; // 1-based, empty if every sample is a sync sample
+
+    bool isText() const{
+        return handler == "text" || handler == "sbtl" || format == "tx3g" || format == "text";
+    }
+
+    bool isMotionJpeg() const{
+        return handler == "vide" && (format == "jpeg" || format == "mjpa" || format == "mjpb");
+    }
+
+    std::vector<uint64_t> sampleOffsets() const{
+        std::vector<uint64_t> offsets;
+        offsets.reserve(sampleSizes.size());
+
+        size_t s = 0;
+        for (size_t e = 0; e < samplesPerChunk.size(); e++){
+            const size_t firstChunk = samplesPerChunk[e].first - 1;
+            const size_t lastChunk = e + 1 < samplesPerChunk.size() ? samplesPerChunk[e + 1].first - 1 : chunkOffsets.size();
+            for (size_t c = firstChunk; c < lastChunk && c < chunkOffsets.size(); c++){
+                uint64_t offset = chunkOffsets[c];
+                for (uint32_t i = 0; i < samplesPerChunk[e].second && s < sampleSizes.size(); i++){
+                    offsets.push_back(offset);
+                    offset += sampleSizes[s++];
+                }
+            }
+        }
+
+        return offsets;
+    }
+
+    // Start time of each sample, in seconds
+    std::vector<double> sampleTimes() const{
+        std::vector<double> times;
+        times.reserve(sampleSizes.size());
+
+        uint64_t t = 0;
+        for (const auto &e : timeToSample){
+            for (uint32_t i = 0; i < e.first && times.size() < sampleSizes.size(); i++){
+                times.push_back(timescale > 0 ? static_cast<double>(t) / timescale : 0.0);
+                t += e.second;
+            }
+        }
+        while (times.size() < sampleSizes.size()) times.push_back(timescale > 0 ? static_cast<double>(t) / timescale : 0.0);
+
+        return times;
+    }
+};
+
+// Number of entries of a full box table, checking that they fit in the box
+static uint32_t tableEntries(const Mp4Box &b, size_t headerSize, size_t entrySize){
+    if (b.size < headerSize) return 0;
+    const uint32_t count = readBE32(b.data + headerSize - 4);
+    return static_cast<uint32_t>(std::min<uint64_t>(count, (b.size - headerSize) / entrySize));
+}
+
+// Returns false if the sample tables of the track are not plausible
+// for a file of fileSize bytes
+static bool parseTrack(const Mp4Box &trak, uint64_t fileSize, Mp4Track &track){
+    Mp4Box b;
+    if (findPath(trak, {"tkhd"}, b) && b.size >= 84){
+        const size_t o = b.data[0] == 1 ? 88 : 76;
+        if (b.size >= o + 8){
+            track.width = static_cast<int>(readBE32(b.data + o) >> 16);
+            track.height = static_cast<int>(readBE32(b.data + o + 4) >> 16);
+        }
+    }
+    if (findPath(trak, {"mdia", "mdhd"}, b) && b.size >= 20){
+        if (b.data[0] == 1 && b.size >= 32){
+            track.timescale = readBE32(b.data + 20);
+            track.duration = readBE64(b.data + 24);
+        }else{
+            track.timescale = readBE32(b.data + 12);
+            track.duration = readBE32(b.data + 16);
+        }
+    }
+    if (findPath(trak, {"mdia", "hdlr"}, b) && b.size >= 12){
+        track.handler = std::string(reinterpret_cast<const char *>(b.data + 8), 4);
+    }
+
+    Mp4Box stbl;
+    if (!findPath(trak, {"mdia", "minf", "stbl"}, stbl)) return true;
+
+    if (findPath(stbl, {"stsd"}, b) && b.size >= 16){
+        track.format = std::string(reinterpret_cast<const char *>(b.data + 12), 4);
+    }
+    if (findPath(stbl, {"stts"}, b)){
+        const auto n = tableEntries(b, 8, 8);
+        for (uint32_t i = 0; i < n; i++){
+            track.timeToSample.emplace_back(readBE32(b.data + 8 + i * 8), readBE32(b.data + 12 + i * 8));
+        }
+    }
+    if (findPath(stbl, {"stsc"}, b)){
+        const auto n = tableEntries(b, 8, 12);
+        for (uint32_t i = 0; i < n; i++){
+            track.samplesPerChunk.emplace_back(readBE32(b.data + 8 + i * 12), readBE32(b.data + 12 + i * 12));
+        }
+    }
+    if (findPath(stbl, {"stsz"}, b) && b.size >= 12){
+        const uint32_t fixedSize = readBE32(b.data + 4);
+        const uint32_t count = readBE32(b.data + 8);
+        if (count > MP4_MAX_SAMPLES){
+            LOGD << "Track has too many samples (" << count << ")";
+            return false;
+        }
+
+        if (fixedSize > 0){
+            // There's no table to check the count against, but the samples must fit in the file
+            if (static_cast<uint64_t>(count) * fixedSize > fileSize){
+                LOGD << "Track samples do not fit in the file (" << count << " x " << fixedSize << " bytes)";
+                return false;
+            }
+            track.sampleSizes.assign(count, fixedSize);
+        }else{
+            const auto n = tableEntries(b, 12, 4);
+            track.sampleSizes.reserve(n);
+            for (uint32_t i = 0; i < n; i++){
+                const uint32_t size = readBE32(b.data + 12 + i * 4);
+                if (size > fileSize){
+                    LOGD << "Track sample does not fit in the file (" << size << " bytes)";
+                    return false;
+                }
+                track.sampleSizes.push_back(size);
+            }
+        }
+    }
+    if (findPath(stbl, {"stco"}, b)){
+        const auto n = tableEntries(b, 8, 4);
+        for (uint32_t i = 0; i < n; i++) track.chunkOffsets.push_back(readBE32(b.data + 8 + i * 4));
+    }else if (findPath(stbl, {"co64"}, b)){
+        const auto n = tableEntries(b, 8, 8);
+        for (uint32_t i = 0; i < n; i++) track.chunkOffsets.push_back(readBE64(b.data + 8 + i * 8));
+    }
+    if (findPath(stbl, {"stss"}, b)){
+        const auto n = tableEntries(b, 8, 4);
+        for (uint32_t i = 0; i < n; i++) track.syncSamples.push_back(readBE32(b.data + 8 + i * 4));
+    }
+
+    return true;
+}
+
+// Reads the movie box, skipping over everything else (including the media data)
+static bool readMoov(std::ifstream &f, uint64_t fileSize, std::vector<uint8_t> &moov){
+    static const char *topLevel[] = { "ftyp", "moov", "mdat", "free", "skip", "wide", "pnot", "uuid", "meta" };
+
+    uint64_t offset = 0;
+    bool first = true;
+    while (true){
+        uint8_t header[16];
+        f.seekg(offset);
+        if (!f.read(reinterpret_cast<char *>(header), 8)) return false;
+
+        const std::string type(reinterpret_cast<const char *>(header + 4), 4);
+        if (first && std::none_of(std::begin(topLevel), std::end(topLevel), [&type](const char *t){ return type == t; })){
+            return false;
+        }
+        first = false;
+
+        uint64_t size = readBE32(header);
+        uint64_t headerSize = 8;
+        if (size == 1){
+            if (!f.read(reinterpret_cast<char *>(header + 8), 8)) return false;
+            size = readBE64(header + 8);
+            headerSize = 16;
+        }else if (size == 0){
+            // Extends to the end of the file
+            if (type != "moov") return false;
+            size = fileSize - offset;
+        }
+
+        // Every box must move the offset forward and end within the file
+        if (size < headerSize || size > fileSize - offset) return false;
+
+        if (type == "moov"){
+            if (size - headerSize > MP4_MAX_MOOV_SIZE){
+                LOGD << "Movie box is too large (" << size << " bytes)";
+                return false;
+            }
+
+            moov.resize(static_cast<size_t>(size - headerSize));
+            return static_cast<bool>(f.read(reinterpret_cast<char *>(moov.data()), moov.size()));
+        }
+
+        offset += size;
+    }
+}
+
+static bool readTracks(std::ifstream &f, std::vector<Mp4Track> &tracks, double &duration, std::vector<uint8_t> &moov){
+    f.seekg(0, std::ios::end);
+    const auto end = f.tellg();
+    if (end < 0) return false;
+    const uint64_t fileSize = static_cast<uint64_t>(end);
+
+    if (!readMoov(f, fileSize, moov)) return false;
+
+    const auto boxes = childBoxes(moov.data(), moov.size());
+    const auto mvhd = findBox(boxes, "mvhd");
+    if (mvhd != nullptr && mvhd->size >= 20){
+        uint32_t timescale;
+        uint64_t d;
+        if (mvhd->data[0] == 1 && mvhd->size >= 32){
+            timescale = readBE32(mvhd->data + 20);
+            d = readBE64(mvhd->data + 24);
+        }else{
+            timescale = readBE32(mvhd->data + 12);
+            d = readBE32(mvhd->data + 16);
+        }
+        if (timescale > 0) duration = static_cast<double>(d) / timescale;
+    }
+
+    for (const auto &b : boxes){
+        if (b.type != "trak") continue;
+        tracks.emplace_back();
+        if (!parseTrack(b, fileSize, tracks.back())){
+            LOGD << "Skipping corrupt track";
+            tracks.pop_back();
+        }
+    }
+
+    return true;
+}
+
+static double parseNumber(const std::string &s){
+    try{
+        return std::stod(s);
+    }catch(const std::logic_error &){
+        return 0.0;
+    }
+}
+
+// Reads a position from the text of a telemetry subtitle. Supports the formats
+// written by DJI drones over the years, for example:
+// "[latitude: 46.842] [longitude: -91.994] [rel_alt: 10.0 abs_alt: 250.1]"
+// "[latitude : 46.842] [longtitude : -91.994] [altitude: 250.1]"
+// "GPS(-91.994,46.842,19) BAROMETER:25.7"
+static bool parseTelemetryText(const std::string &text, VideoTrackPoint &p){
+    static const std::regex latRe("\\[\\s*latitude\\s*:\\s*(-?[0-9.]+)", std::regex::icase);
+    static const std::regex lonRe("\\[\\s*longt?itude\\s*:\\s*(-?[0-9.]+)", std::regex::icase);
+    static const std::regex absAltRe("abs_alt\\s*:\\s*(-?[0-9.]+)", std::regex::icase);
+    static const std::regex altRe("\\[\\s*altitude\\s*:\\s*(-?[0-9.]+)", std::regex::icase);
+    static const std::regex gpsRe("GPS\\s*\\(\\s*(-?[0-9.]+)\\s*,\\s*(-?[0-9.]+)(?:\\s*,\\s*(-?[0-9.]+))?", std::regex::icase);
+    static const std::regex baroRe("BAROMETER\\s*:\\s*(-?[0-9.]+)", std::regex::icase);
+
+    std::smatch m;
+    p.altitude = 0.0;
+
+    if (std::regex_search(text, m, latRe)){
+        p.latitude = parseNumber(m[1]);
+        if (!std::regex_search(text, m, lonRe)) return false;
+        p.longitude = parseNumber(m[1]);
+
+        if (std::regex_search(text, m, absAltRe) || std::regex_search(text, m, altRe)){
+            p.altitude = parseNumber(m[1]);
+        }
+    }else if (std::regex_search(text, m, gpsRe)){
+        p.longitude = parseNumber(m[1]);
+        p.latitude = parseNumber(m[2]);
+        if (m[3].matched) p.altitude = parseNumber(m[3]);
+        else if (std::regex_search(text, m, baroRe)) p.altitude = parseNumber(m[1]);
+    }else{
+        return false;
+    }
+
+    // No GPS fix
+    if (p.latitude == 0.0 && p.longitude == 0.0) return false;
+
+    return std::abs(p.latitude) <= 90.0 && std::abs(p.longitude) <= 180.0;
+}
+
+void parseSrtTelemetry(std::istream &in, std::vector<VideoTrackPoint> &track, double minInterval){
+    std::string line;
+    std::string text;
+    double time = -1.0;
+    double lastTime = -std::numeric_limits<double>::infinity();
+
+    auto flush = [&](){
+        if (time >= 0.0 && time >= lastTime + minInterval){
+            VideoTrackPoint p;
+            p.time = time;
+            if (parseTelemetryText(text, p)){
+                track.push_back(p);
+                lastTime = time;
+            }
+        }
+        text.clear();
+        time = -1.0;
+    };
+
+    while (std::getline(in, line)){
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        int h, m, s, ms;
+        if (sscanf(line.c_str(), "%d:%d:%d,%d -->", &h, &m, &s, &ms) == 4 && line.find("-->") != std::string::npos){
+            flush();
+            time = h * 3600.0 + m * 60.0 + s + ms / 1000.0;
+        }else if (line.empty()){
+            flush();
+        }else if (time >= 0.0){
+            // Only keep the text of blocks we are going to parse
+            if (time >= lastTime + minInterval) text += line + "\n";
+        }
+    }
+    flush();
+}
+
+#define TELEMETRY_MIN_INTERVAL 1.0
+
+static void readEmbeddedTelemetry(std::ifstream &f, const Mp4Track &track, std::vector<VideoTrackPoint> &points){
+    const auto offsets = track.sampleOffsets();
+    const auto times = track.sampleTimes();
+
+    std::vector<uint8_t> sample;
+    double lastTime = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < offsets.size(); i++){
+        const uint32_t size = track.sampleSizes[i];
+        if (size < 2 || size > MP4_MAX_TEXT_SAMPLE || times[i] < lastTime + TELEMETRY_MIN_INTERVAL) continue;
+
+        sample.resize(size);
+        f.seekg(offsets[i]);
+        if (!f.read(reinterpret_cast<char *>(sample.data()), size)){
+            f.clear();
+            continue;
+        }
+
+        // Text samples start with a 16 bit length
+        const size_t len = std::min<size_t>(readBE16(sample.data()), size - 2);
+        const std::string text(reinterpret_cast<const char *>(sample.data() + 2), len);
+
+        VideoTrackPoint p;
+        p.time = times[i];
+        if (parseTelemetryText(text, p)){
+            points.push_back(p);
+            lastTime = p.time;
+        }
+    }
+}
+
+bool getVideoInfo(const std::string &filename, VideoInfo &info){
+    std::ifstream f(filename, std::ios::binary);
+    if (!f.is_open()) return false;
+
+    info = VideoInfo();
+
+    std::vector<Mp4Track> tracks;
+    std::vector<uint8_t> moov;
+    if (!readTracks(f, tracks, info.duration, moov)) return false;
+
+    for (const auto &t : tracks){
+        if (t.handler == "vide" && info.width == 0){
+            info.width = t.width;
+            info.height = t.height;
+        }
+    }
+
+    for (const auto &t : tracks){
+        if (t.isText()){
+            readEmbeddedTelemetry(f, t, info.track);
+            if (!info.track.empty()) break;
+        }
+    }
+
+    // DJI drones can also write the telemetry to a sidecar subtitle file
+    if (info.track.empty()){
+        for (const auto &ext : { ".SRT", ".srt" }){
+            const auto srt = fs::path(filename).replace_extension(ext);
+            if (fs::exists(srt)){
+                LOGD << "Reading telemetry from " << srt.string();
+                std::ifstream in(srt.string());
+                parseSrtTelemetry(in, info.track, TELEMETRY_MIN_INTERVAL);
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Cover art stored in the iTunes style metadata (udta/meta/ilst/covr/data)
+static bool readCoverImage(const std::vector<uint8_t> &moov, std::vector<uint8_t> &image){
+    const auto boxes = childBoxes(moov.data(), moov.size());
+    const auto udta = findBox(boxes, "udta");
+    if (udta == nullptr) return false;
+
+    const auto meta = findBox(childBoxes(udta->data, udta->size), "meta");
+    if (meta == nullptr || meta->size < 8) return false;
+
+    // ISO meta boxes have a version/flags header, QuickTime ones don't
+    const bool fullBox = memcmp(meta->data + 4, "hdlr", 4) != 0;
+    Mp4Box content = { "meta", meta->data + (fullBox ? 4 : 0), meta->size - (fullBox ? 4 : 0) };
+
+    Mp4Box data;
+    if (!findPath(content, {"ilst", "covr", "data"}, data) || data.size <= 8) return false;
+
+    // Type indicator 13 is JPEG, 14 is PNG
+    const uint32_t dataType = readBE32(data.data) & 0xFFFFFF;
+    if (dataType != 13 && dataType != 14) return false;
+
+    image.assign(data.data + 8, data.data + data.size);
+    return true;
+}
+
+bool extractVideoStill(const std::string &filename, std::vector<uint8_t> &image, double position){
+    std::ifstream f(filename, std::ios::binary);
+    if (!f.is_open()) return false;
+
+    std::vector<Mp4Track> tracks;
+    std::vector<uint8_t> moov;
+    double duration = 0;
+    if (!readTracks(f, tracks, duration, moov)) return false;
+
+    for (const auto &t : tracks){
+        if (!t.isMotionJpeg() || t.sampleSizes.empty()) continue;
+
+        // Seek to the sync sample closest to the requested position
+        const auto offsets = t.sampleOffsets();
+        const auto times = t.sampleTimes();
+        const double target = std::max(0.0, std::min(1.0, position)) * (times.back() > 0 ? times.back() : duration);
+
+        size_t best = 0;
+        double bestDistance = std::numeric_limits<double>::infinity();
+        auto consider = [&](size_t s){
+            if (s >= offsets.size()) return;
+            const double d = std::abs(times[s] - target);
+            if (d < bestDistance){
+                bestDistance = d;
+                best = s;
+            }
+        };
+
+        if (t.syncSamples.empty()){
+            const auto it = std::lower_bound(times.begin(), times.end(), target);
+            const size_t s = static_cast<size_t>(it - times.begin());
+            consider(s);
+            if (s > 0) consider(s - 1);
+        }else{
+            for (const auto s : t.syncSamples) consider(s - 1);
+        }
+
+        if (bestDistance == std::numeric_limits<double>::infinity()) continue;
+
+        image.resize(t.sampleSizes[best]);
+        f.seekg(offsets[best]);
+        if (f.read(reinterpret_cast<char *>(image.data()), image.size())) return true;
+        f.clear();
+    }
+
+    return readCoverImage(moov, image);
+}
+
+}
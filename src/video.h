@@ -0,0 +1,48 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include "ddb_export.h"
+
+namespace ddb{
+
+struct VideoTrackPoint{
+    double time; // seconds from the start of the video
+    double longitude;
+    double latitude;
+    double altitude;
+};
+
+struct VideoInfo{
+    double duration = 0; // seconds
+    int width = 0;
+    int height = 0;
+
+    // Flight track, from a telemetry subtitle stream or a sidecar .SRT file
+    std::vector<VideoTrackPoint> track;
+};
+
+// Reads the metadata of a MP4/MOV file. Only the movie header box is
+// loaded in memory, media data is never read except for telemetry samples.
+// Returns false if the file is not a (valid) MP4/MOV file.
+DDB_DLL bool getVideoInfo(const std::string &filename, VideoInfo &info);
+
+// Parses telemetry from DJI style subtitles (SRT), keeping
+// at most one point every minInterval seconds
+DDB_DLL void parseSrtTelemetry(std::istream &in, std::vector<VideoTrackPoint> &track, double minInterval = 1.0);
+
+// Extracts a still image (JPEG or PNG) that is stored as is in a MP4/MOV file:
+// the sync frame closest to position (0-1) of a Motion JPEG video track, or the
+// embedded cover image. Nothing is decoded, so H.264/H.265 frames are not supported.
+// Returns false if the file has no such image.
+DDB_DLL bool extractVideoStill(const std::string &filename, std::vector<uint8_t> &image, double position = 0.5);
+
+}
+
+#endif // VIDEO_H
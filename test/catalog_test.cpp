@@ -0,0 +1,161 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <sstream>
+#include "gtest/gtest.h"
+#include "catalog.h"
+#include "dbops.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void createDataset(const fs::path &folder, double lon, double lat, double captureTime) {
+    fs::create_directories(folder);
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth, point_geom) "
+                       "VALUES (?, '', ?, ?, 0, 1000, 0, GeomFromText(?, 4326))");
+    for (int i = 0; i < 3; i++) {
+        q->bind(1, "img" + std::to_string(i) + ".JPG");
+        q->bind(2, EntryType::GeoImage);
+        q->bind(3, json({{"captureTime", captureTime + i * 1000.0}}).dump());
+        q->bind(4, "POINT Z (" + std::to_string(lon + i * 0.001) + " " + std::to_string(lat) + " 100)");
+        q->execute();
+        q->reset();
+    }
+
+    db->setLastUpdate(1600000000);
+}
+
+TEST(catalog, harvest) {
+    TestArea ta(TEST_NAME, true);
+    const auto root = ta.getFolder("datasets");
+
+    // 2020-09-13 and 2021-01-01
+    createDataset(root / "a", 11.0, 46.0, 1600000000000.0);
+    createDataset(root / "b" / "c", -91.99, 46.84, 1609459200000.0);
+
+    Catalog catalog((ta.getFolder() / "catalog.sqlite").string());
+    EXPECT_EQ(catalog.harvest({root.string()}), 2);
+
+    auto all = catalog.search();
+    ASSERT_EQ(all.size(), 2);
+    EXPECT_EQ(fs::path(all[0].path).filename().string(), "a");
+    EXPECT_EQ(all[0].entries, 3);
+    EXPECT_EQ(all[0].images, 3);
+    EXPECT_EQ(all[0].size, 3000);
+    EXPECT_EQ(all[0].mtime, 1600000000);
+    EXPECT_DOUBLE_EQ(all[0].minCaptureTime, 1600000000000.0);
+    EXPECT_DOUBLE_EQ(all[0].maxCaptureTime, 1600000002000.0);
+    ASSERT_TRUE(all[0].hasExtent);
+    EXPECT_NEAR(all[0].minLon, 11.0, 1e-9);
+    EXPECT_NEAR(all[0].maxLon, 11.002, 1e-9);
+
+    CatalogFilter filter;
+    filter.hasBounds = true;
+    filter.minLon = 10.0;
+    filter.minLat = 45.0;
+    filter.maxLon = 11.0005;
+    filter.maxLat = 47.0;
+    auto found = catalog.search(filter);
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(fs::path(found[0].path).filename().string(), "a");
+
+    filter = CatalogFilter();
+    filter.capturedAfter = 1609000000000.0;
+    found = catalog.search(filter);
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(fs::path(found[0].path).filename().string(), "c");
+
+    // Nothing changed
+    EXPECT_EQ(catalog.harvest({root.string()}), 0);
+
+    // Only changed datasets are summarized again
+    {
+        auto db = ddb::open((root / "a").string(), false);
+        db->exec("DELETE FROM entries WHERE path = 'img2.JPG'");
+        db->setLastUpdate(1600000100);
+    }
+    std::vector<std::string> updated;
+    EXPECT_EQ(catalog.harvest({root.string()}, [&updated](const DatasetSummary &s, bool isUpdate, bool removed) {
+        EXPECT_TRUE(isUpdate);
+        EXPECT_FALSE(removed);
+        updated.push_back(s.path);
+    }), 1);
+    ASSERT_EQ(updated.size(), 1);
+    all = catalog.search();
+    EXPECT_EQ(all[0].entries, 2);
+    EXPECT_NEAR(all[0].maxLon, 11.001, 1e-9);
+
+    // Changes within the same second as the last harvest (same mtime attribute)
+    {
+        auto db = ddb::open((root / "a").string(), false);
+        db->exec("DELETE FROM entries WHERE path = 'img1.JPG'");
+    }
+    EXPECT_EQ(catalog.harvest({root.string()}), 1);
+    all = catalog.search();
+    EXPECT_EQ(all[0].entries, 1);
+    EXPECT_EQ(all[0].mtime, 1600000100);
+    EXPECT_EQ(catalog.harvest({root.string()}), 0);
+
+    // Datasets indexed before the change counter existed are summarized
+    // without migrating them, on every harvest until they are migrated
+    const auto dbase = (root / "a" / ".ddb" / "dbase.sqlite").string();
+    {
+        Database db;
+        db.open(dbase);
+        db.exec("DROP TRIGGER entries_changes_update; DELETE FROM attributes WHERE name = 'stats_changes'");
+    }
+    EXPECT_EQ(catalog.harvest({root.string()}), 1);
+    EXPECT_EQ(catalog.harvest({root.string()}), 1);
+    all = catalog.search();
+    EXPECT_EQ(all[0].entries, 1);
+    EXPECT_TRUE(all[0].hasExtent);
+    {
+        SqliteDatabase db;
+        db.open(dbase, true);
+        auto q = db.query("SELECT COUNT(*) FROM sqlite_master WHERE name = 'entries_changes_update'");
+        ASSERT_TRUE(q->fetch());
+        EXPECT_EQ(q->getInt(0), 0);
+    }
+
+    ddb::open((root / "a").string(), false);
+    EXPECT_EQ(catalog.harvest({root.string()}), 1);
+    EXPECT_EQ(catalog.harvest({root.string()}), 0);
+
+    // Removed datasets are dropped
+    fs::remove_all(root / "b");
+    EXPECT_EQ(catalog.harvest({root.string()}), 1);
+    EXPECT_EQ(catalog.search().size(), 1);
+}
+
+TEST(catalog, listCatalog) {
+    TestArea ta(TEST_NAME, true);
+    const auto root = ta.getFolder("datasets");
+    createDataset(root / "a", 11.0, 46.0, 1600000000000.0);
+
+    Catalog catalog((ta.getFolder() / "catalog.sqlite").string());
+    catalog.harvest({root.string()});
+
+    std::ostringstream out;
+    listCatalog(catalog, out, "json");
+    auto j = json::parse(out.str());
+    ASSERT_EQ(j.size(), 1);
+    EXPECT_EQ(j[0]["entries"], 3);
+    EXPECT_EQ(j[0]["extent"].size(), 4);
+    EXPECT_EQ(j[0]["captureTime"].size(), 2);
+
+    out.str("");
+    listCatalog(catalog, out, "text");
+    EXPECT_NE(out.str().find("3 entries, 3 images"), std::string::npos);
+    EXPECT_NE(out.str().find("captured 2020-09-13 - 2020-09-13"), std::string::npos);
+
+    EXPECT_THROW(listCatalog(catalog, out, "xml"), InvalidArgsException);
+}
+
+}
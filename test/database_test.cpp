@@ -0,0 +1,211 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <tuple>
+#include "gtest/gtest.h"
+#include "dbops.h"
+#include "search.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+TEST(database, compactCopy) {
+    TestArea ta(TEST_NAME, true);
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth) "
+                       "VALUES (?, '', 2, '{}', 0, 0, 0)");
+    for (int i = 0; i < 1000; i++) {
+        q->bind(1, "file_" + std::to_string(i) + ".txt");
+        q->execute();
+    }
+
+    const auto copyFile = ta.getFolder() / "copy.sqlite";
+    db->compactCopy(copyFile);
+    EXPECT_TRUE(fs::exists(copyFile));
+    EXPECT_FALSE(fs::exists(copyFile.string() + "-wal"));
+
+    // The search index is dropped from the copy and rebuilt on open
+    Database copy;
+    copy.open(copyFile.string());
+    EXPECT_FALSE(copy.hasSearchIndex());
+
+    auto count = copy.query("SELECT COUNT(*) FROM entries");
+    ASSERT_TRUE(count->fetch());
+    EXPECT_EQ(count->getInt(0), 1000);
+
+    // So are the meta indexes
+    const auto metaIndexes = [&copy]() {
+        auto q = copy.query("SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name LIKE 'ix_entries_%'");
+        return q->fetch() ? q->getInt(0) : -1;
+    };
+    EXPECT_EQ(metaIndexes(), 0);
+
+    copy.ensureSchemaConsistency();
+    EXPECT_TRUE(copy.hasSearchIndex());
+    EXPECT_EQ(search(&copy, "file_99", 0).size(), 11);
+    if (copy.hasMetaColumns()) EXPECT_EQ(metaIndexes(), 4);
+}
+
+TEST(database, metaColumns) {
+    TestArea ta(TEST_NAME, true);
+    Database db;
+    db.open((ta.getFolder() / "dbase.sqlite").string());
+
+    // Index created before the meta columns existed
+    db.exec("CREATE TABLE entries (path TEXT PRIMARY KEY, hash TEXT, type INTEGER, meta TEXT, mtime INTEGER, "
+            "size INTEGER, depth INTEGER, point_geom BLOB, polygon_geom BLOB);"
+            "INSERT INTO entries (path, type, meta) VALUES ('a.JPG', 3, '{\"make\":\"DJI\"}'), ('b.txt', 2, 'null');");
+    EXPECT_FALSE(db.hasMetaColumns());
+
+    // Filters parse meta until the columns are added
+    auto countDji = [&db]() {
+        auto q = db.query("SELECT COUNT(*) FROM entries WHERE " + db.metaColumn("make") + " = 'DJI'");
+        return q->fetch() ? q->getInt(0) : -1;
+    };
+    EXPECT_NE(db.metaColumn("make"), "make");
+    EXPECT_EQ(countDji(), 1);
+    EXPECT_THROW(db.metaColumn("unknown"), InvalidArgsException);
+
+    if (!Database::supportsGeneratedColumns()) return;
+
+    db.ensureSchemaConsistency();
+    EXPECT_TRUE(db.hasMetaColumns());
+    EXPECT_EQ(db.metaColumn("make"), "make");
+    EXPECT_EQ(countDji(), 1);
+
+    // Nothing left to migrate
+    db.ensureSchemaConsistency();
+    EXPECT_TRUE(db.hasMetaColumns());
+}
+
+TEST(database, optimize) {
+    TestArea ta(TEST_NAME, true);
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    auto autoVacuum = db->query("PRAGMA auto_vacuum");
+    ASSERT_TRUE(autoVacuum->fetch());
+    EXPECT_EQ(autoVacuum->getInt(0), 2);
+    autoVacuum.reset();
+
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth) "
+                       "VALUES (?, '', 2, json_object('data', hex(randomblob(2000))), 0, 0, 0)");
+    db->exec("BEGIN TRANSACTION");
+    for (int i = 0; i < 2000; i++) {
+        q->bind(1, "file_" + std::to_string(i) + ".txt");
+        q->execute();
+    }
+    db->exec("COMMIT");
+    q.reset();
+
+    db->exec("DELETE FROM entries");
+    EXPECT_GT(db->getStorageInfo().freePages, 0);
+
+    // Most pages are free: reclaimed automatically
+    EXPECT_TRUE(db->autoOptimize());
+    EXPECT_EQ(db->getStorageInfo().freePages, 0);
+    EXPECT_FALSE(db->autoOptimize());
+
+    std::ostringstream out;
+    optimizeIndex(db.get(), out, "json");
+    const auto j = json::parse(out.str());
+    EXPECT_EQ(j["after"]["freePages"], 0);
+    EXPECT_EQ(j["after"]["walSize"], 0);
+    EXPECT_TRUE(db->tableExists("sqlite_stat1"));
+
+    // A few changes don't trigger it
+    db->exec("INSERT INTO entries (path, hash, type, meta, mtime, size, depth) "
+             "VALUES ('a.txt', '', 2, json_object('data', hex(randomblob(200000))), 0, 0, 0);"
+             "DELETE FROM entries;");
+    EXPECT_GT(db->getStorageInfo().freePages, 0);
+    EXPECT_FALSE(db->autoOptimize());
+}
+
+TEST(database, stats) {
+    TestArea ta(TEST_NAME, true);
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    auto stats = db->getStats();
+    EXPECT_EQ(stats.entries, 0);
+    EXPECT_EQ(stats.size, 0);
+    EXPECT_FALSE(stats.hasExtent());
+
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth, point_geom) "
+                       "VALUES (?, '', ?, '{}', 0, ?, 0, GeomFromText(?, 4326))");
+    const std::vector<std::tuple<std::string, EntryType, int, std::string>> rows = {
+        {"a.JPG", EntryType::GeoImage, 100, "POINT Z (11 46 0)"},
+        {"b.JPG", EntryType::GeoImage, 200, "POINT Z (12 47 0)"},
+        {"c.txt", EntryType::Generic, 50, ""},
+    };
+    for (const auto &r : rows) {
+        q->bind(1, std::get<0>(r));
+        q->bind(2, std::get<1>(r));
+        q->bind(3, std::get<2>(r));
+        q->bind(4, std::get<3>(r));
+        q->execute();
+    }
+
+    stats = db->getStats();
+    EXPECT_EQ(stats.entries, 3);
+    EXPECT_EQ(stats.size, 350);
+    EXPECT_EQ(stats.countByType[EntryType::GeoImage], 2);
+    EXPECT_EQ(stats.countByType[EntryType::Generic], 1);
+    ASSERT_TRUE(stats.hasExtent());
+    EXPECT_DOUBLE_EQ(stats.minX, 11.0);
+    EXPECT_DOUBLE_EQ(stats.maxY, 47.0);
+    EXPECT_EQ(db->getAttributes()["entries"], 3);
+
+    // Updates and deletes
+    db->exec("UPDATE entries SET size = 20, type = 6 WHERE path = 'c.txt'");
+    db->exec("DELETE FROM entries WHERE path = 'b.JPG'");
+    stats = db->getStats();
+    EXPECT_EQ(stats.entries, 2);
+    EXPECT_EQ(stats.size, 120);
+    EXPECT_EQ(stats.countByType.count(EntryType::Generic), 0);
+    EXPECT_EQ(stats.countByType[EntryType::Image], 1);
+    EXPECT_DOUBLE_EQ(stats.maxX, 11.0);
+    EXPECT_DOUBLE_EQ(stats.maxY, 46.0);
+
+    // The stale extent is recomputed in memory, read-only connections work too
+    const auto extentDirty = [&db]() {
+        auto q = db->query("SELECT COUNT(*) FROM attributes WHERE name = 'stats_extent_dirty'");
+        return q->fetch() && q->getInt(0) == 1;
+    };
+    EXPECT_TRUE(extentDirty());
+    {
+        Database ro;
+        ro.open(db->getOpenFile(), true);
+        const auto roStats = ro.getStats();
+        EXPECT_DOUBLE_EQ(roStats.maxX, 11.0);
+        EXPECT_EQ(roStats.entries, 2);
+    }
+    EXPECT_TRUE(extentDirty());
+
+    // and saved by write paths
+    db->updateStatsExtent();
+    EXPECT_FALSE(extentDirty());
+    stats = db->getStats();
+    EXPECT_DOUBLE_EQ(stats.maxX, 11.0);
+    EXPECT_DOUBLE_EQ(stats.maxY, 46.0);
+
+    // Same as computing everything from scratch
+    db->exec("DROP TRIGGER entries_stats_update");
+    db->ensureSchemaConsistency();
+    const auto rebuilt = db->getStats();
+    EXPECT_EQ(rebuilt.entries, stats.entries);
+    EXPECT_EQ(rebuilt.size, stats.size);
+    EXPECT_EQ(rebuilt.countByType, stats.countByType);
+    EXPECT_DOUBLE_EQ(rebuilt.minX, stats.minX);
+}
+
+}
@@ -2,9 +2,13 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <fstream>
+#include <iostream>
+#include <sstream>
 #include "gtest/gtest.h"
 #include "dbops.h"
 #include "exceptions.h"
+#include "mio.h"
 #include "test.h"
 #include "testarea.h"
 
@@ -906,4 +910,42 @@ TEST(moveEntry, badParameters2) {
 
 }
 
+TEST(updateIndex, onlyIndexedFiles) {
+    TestArea ta(TEST_NAME, true);
+
+    const auto testFolder = ta.getFolder("test");
+    initIndex(testFolder.string());
+    auto db = ddb::open(testFolder.string(), false);
+
+    const auto indexed = testFolder / "indexed.txt";
+    const auto other = testFolder / "other.txt";
+    std::ofstream(indexed.string()) << "before";
+    addToIndex(db.get(), {indexed.string()});
+
+    Entry before;
+    ASSERT_NE(getEntry(db.get(), "indexed.txt", &before), nullptr);
+
+    std::ofstream(indexed.string()) << "after!";
+    std::ofstream(other.string()) << "other";
+    io::Path(indexed).setModifiedTime(before.mtime + 10);
+
+    std::vector<std::string> updated;
+    updateIndex(db.get(), {indexed.string(), other.string()}, [&updated](const Entry &e, bool){
+        updated.push_back(e.path);
+        return true;
+    });
+
+    ASSERT_EQ(updated.size(), 1);
+    EXPECT_EQ(updated[0], "indexed.txt");
+
+    Entry after;
+    ASSERT_NE(getEntry(db.get(), "indexed.txt", &after), nullptr);
+    EXPECT_NE(after.hash, before.hash);
+    EXPECT_EQ(after.mtime, before.mtime + 10);
+    EXPECT_EQ(after.size, 6);
+
+    // Not added
+    EXPECT_FALSE(pathExists(db.get(), "other.txt"));
+}
+
 }
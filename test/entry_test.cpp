@@ -2,6 +2,7 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <sstream>
 #include "gtest/gtest.h"
 #include "entry.h"
 
@@ -21,4 +22,73 @@ TEST(calculateFootprint, Normal) {
 	EXPECT_STREQ(geom.toWkt().c_str(), "POLYGONZ ((-91.994308101 46.84345864217 98.31, -91.99431905836 46.84287152156 98.31, -91.99300336858 46.84285995357 98.31, -91.99299239689 46.84344707395 98.31, -91.994308101 46.84345864217 98.31))");
 }
 
+TEST(basicGeometry, writers) {
+    BasicPointGeometry point;
+    EXPECT_EQ(point.toWkt(), "");
+    point.addPoint(-91.99456, 46.842607, 198.31);
+    EXPECT_EQ(point.toWkt(), "POINT Z (-91.994560 46.842607 198.310000)");
+
+    std::string out;
+    point.writeGeoJSONGeometry(out);
+    EXPECT_EQ(out, point.toGeoJSON()["geometry"].dump());
+    EXPECT_EQ(out, R"({"coordinates":[-91.99456,46.842607,198.31],"type":"Point"})");
+
+    // More points than fit inline
+    BasicPolygonGeometry polygon;
+    for (int i = 0; i < 8; i++) polygon.addPoint(-91.9 - i / 3.0, 46.8 + i * 1e-7, i == 0 ? 0.0 : 100.0 / i);
+    polygon.addPoint(polygon.points[0]);
+    ASSERT_EQ(polygon.size(), 9);
+    EXPECT_DOUBLE_EQ(polygon.points[8].x, -91.9);
+
+    std::ostringstream os;
+    os << "POLYGONZ ((";
+    for (size_t i = 0; i < polygon.points.size(); i++){
+        if (i > 0) os << ", ";
+        os << std::setprecision(13) << polygon.points[i].x << " " << polygon.points[i].y << " " << polygon.points[i].z;
+    }
+    os << "))";
+    EXPECT_EQ(polygon.toWkt(), os.str());
+
+    out.clear();
+    polygon.writeGeoJSONGeometry(out);
+    EXPECT_EQ(out, polygon.toGeoJSON()["geometry"].dump());
+
+    BasicPolygonGeometry copy = polygon;
+    polygon.clear();
+    EXPECT_TRUE(polygon.empty());
+    EXPECT_EQ(copy.size(), 9);
+    copy.clear();
+    copy.addPoint(1.0, 2.0, 3.0);
+    EXPECT_EQ(copy.toWkt(), "POLYGONZ ((1 2 3))");
+}
+
+TEST(entry, writeGeoJSON) {
+    Entry e;
+    e.path = "file:///data/\"quoted\".jpg";
+    e.hash = "abc";
+    e.type = EntryType::GeoImage;
+    e.mtime = 123;
+    e.size = 456;
+    e.meta["width"] = 4000;
+    e.meta["path"] = "overridden";
+    e.meta["aaa"] = json::array({1.5, 2});
+    e.point_geom.addPoint(-91.99456, 46.842607, 198.31);
+    e.polygon_geom.addPoint(1, 2, 3);
+    e.polygon_geom.addPoint(1.5, 2, 3e-7);
+
+    // Same bytes as the json tree
+    for (auto type : {BasicGeometryType::BGAuto, BasicGeometryType::BGPoint, BasicGeometryType::BGPolygon}) {
+        json j;
+        ASSERT_TRUE(e.toGeoJSON(j, type));
+        std::ostringstream ss;
+        ASSERT_TRUE(e.writeGeoJSON(ss, type));
+        EXPECT_EQ(ss.str(), j.dump());
+    }
+
+    Entry noGeom;
+    std::ostringstream ss;
+    EXPECT_FALSE(noGeom.writeGeoJSON(ss));
+    EXPECT_TRUE(ss.str().empty());
+}
+
 }
@@ -0,0 +1,134 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <fstream>
+#include <exiv2/exiv2.hpp>
+#include "gtest/gtest.h"
+#include "exifeditor.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void putU16(std::vector<uint8_t> &b, uint16_t v){
+    b.push_back(v & 0xFF);
+    b.push_back(v >> 8);
+}
+
+void putU32(std::vector<uint8_t> &b, uint32_t v){
+    for (int i = 0; i < 4; i++) b.push_back((v >> (i * 8)) & 0xFF);
+}
+
+void putEntry(std::vector<uint8_t> &b, uint16_t tag, uint16_t type, uint32_t count, uint32_t value){
+    putU16(b, tag);
+    putU16(b, type);
+    putU32(b, count);
+    putU32(b, value);
+}
+
+// Minimal JPEG with a little endian Exif segment holding the GPS tags
+// (the altitude tags are left out if withAltitude is false)
+void writeTestJpeg(const fs::path &file, bool withAltitude){
+    const uint16_t gpsCount = withAltitude ? 7 : 5;
+    const uint32_t gpsIfd = 26;
+    const uint32_t data = gpsIfd + 2 + gpsCount * 12 + 4;
+
+    std::vector<uint8_t> tiff = {'I', 'I', 42, 0};
+    putU32(tiff, 8);
+
+    // IFD0, pointing to the GPS IFD
+    putU16(tiff, 1);
+    putEntry(tiff, 0x8825, 4, 1, gpsIfd);
+    putU32(tiff, 0);
+
+    putU16(tiff, gpsCount);
+    putEntry(tiff, 0x0000, 1, 4, 0x00000302);       // GPSVersionID 2.3.0.0
+    putEntry(tiff, 0x0001, 2, 2, 'N');              // GPSLatitudeRef
+    putEntry(tiff, 0x0002, 5, 3, data);             // GPSLatitude
+    putEntry(tiff, 0x0003, 2, 2, 'E');              // GPSLongitudeRef
+    putEntry(tiff, 0x0004, 5, 3, data + 24);        // GPSLongitude
+    if (withAltitude){
+        putEntry(tiff, 0x0005, 1, 1, 0);            // GPSAltitudeRef
+        putEntry(tiff, 0x0006, 5, 1, data + 48);    // GPSAltitude
+    }
+    putU32(tiff, 0);
+
+    for (uint32_t v : {46u, 1u, 50u, 1u, 0u, 1u, 11u, 1u, 20u, 1u, 0u, 1u, 100u, 1u}) putU32(tiff, v);
+
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8, 0xFF, 0xE1};
+    const size_t len = 2 + 6 + tiff.size();
+    jpeg.push_back(static_cast<uint8_t>(len >> 8));
+    jpeg.push_back(len & 0xFF);
+    for (char c : std::string("Exif\0\0", 6)) jpeg.push_back(static_cast<uint8_t>(c));
+    jpeg.insert(jpeg.end(), tiff.begin(), tiff.end());
+
+    // Start of scan, some data and end of image
+    for (uint8_t c : {0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00, 0x12, 0x34, 0xFF, 0xD9}) jpeg.push_back(c);
+
+    std::ofstream f(file.string(), std::ios::binary);
+    f.write(reinterpret_cast<const char *>(jpeg.data()), static_cast<std::streamsize>(jpeg.size()));
+}
+
+Exiv2::ExifData readExif(const fs::path &file){
+    auto image = Exiv2::ImageFactory::open(file.string());
+    image->readMetadata();
+    return image->exifData();
+}
+
+TEST(exifEditor, inPlace) {
+    TestArea ta(TEST_NAME, true);
+
+    std::vector<std::string> files;
+    for (int i = 0; i < 8; i++){
+        const auto f = ta.getFolder() / ("img" + std::to_string(i) + ".jpg");
+        writeTestJpeg(f, true);
+        files.push_back(f.string());
+    }
+    const auto size = fs::file_size(files[0]);
+
+    ExifEditor editor(files);
+    ASSERT_TRUE(editor.canEdit());
+    editor.beginBatch();
+    editor.SetGPSLatitude(-10.5);
+    editor.SetGPSLongitude(-20.25);
+    EXPECT_EQ(editor.commit().size(), files.size());
+
+    for (const auto &f : files){
+        // Same size, tags were overwritten
+        EXPECT_EQ(fs::file_size(f), size);
+
+        auto exif = readExif(f);
+        EXPECT_EQ(exif["Exif.GPSInfo.GPSLatitudeRef"].toString(), "S");
+        EXPECT_EQ(exif["Exif.GPSInfo.GPSLatitude"].toString(), "10/1 30/1 0/10000");
+        EXPECT_EQ(exif["Exif.GPSInfo.GPSLongitudeRef"].toString(), "W");
+        EXPECT_EQ(exif["Exif.GPSInfo.GPSLongitude"].toString(), "20/1 15/1 0/10000");
+        EXPECT_EQ(exif["Exif.GPSInfo.GPSAltitude"].toString(), "100/1");
+    }
+
+    // Nothing to change
+    editor.beginBatch();
+    editor.SetGPSLatitude(-10.5);
+    EXPECT_TRUE(editor.commit().empty());
+}
+
+TEST(exifEditor, rewrite) {
+    TestArea ta(TEST_NAME, true);
+
+    const auto f = ta.getFolder() / "img.jpg";
+    writeTestJpeg(f, false);
+
+    // The altitude tags need to be added
+    ExifEditor editor(f.string());
+    editor.SetGPS(46.5, 11.25, 120.0);
+
+    auto exif = readExif(f);
+    EXPECT_EQ(exif["Exif.GPSInfo.GPSLatitude"].toString(), "46/1 30/1 0/10000");
+    EXPECT_EQ(exif["Exif.GPSInfo.GPSLongitude"].toString(), "11/1 15/1 0/10000");
+    EXPECT_EQ(exif["Exif.GPSInfo.GPSAltitude"].toString(), "120000/1000");
+    EXPECT_EQ(exif["Exif.GPSInfo.GPSAltitudeRef"].toString(), "0");
+}
+
+}
@@ -0,0 +1,75 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "gtest/gtest.h"
+#include "dbops.h"
+#include "export.h"
+#include "exceptions.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void insertEntry(Database *db, const std::string &path, EntryType type, const std::string &meta,
+                 const std::string &pointWkt, const std::string &polygonWkt) {
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth, point_geom, polygon_geom) "
+                       "VALUES (?, '', ?, ?, 0, 0, 0, GeomFromText(?, 4326), GeomFromText(?, 4326))");
+    q->bind(1, path);
+    q->bind(2, type);
+    q->bind(3, meta);
+    q->bind(4, pointWkt);
+    q->bind(5, polygonWkt);
+    q->execute();
+}
+
+TEST(exportEntries, flatGeobuf) {
+    if (GDALGetDriverByName("FlatGeobuf") == nullptr) GTEST_SKIP() << "FlatGeobuf needs GDAL 3.1 or later";
+
+    TestArea ta(TEST_NAME, true);
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    insertEntry(db.get(), "DJI_0001.JPG", EntryType::GeoImage,
+                R"({"make":"DJI","width":4000,"focalLength":8.8,"path":"clash"})",
+                "POINT Z (-91.99 46.84 198.3)", "");
+    insertEntry(db.get(), "DJI_0002.JPG", EntryType::GeoImage,
+                R"({"make":"DJI","width":4000,"focalLength":9,"bands":[1,2]})",
+                "POINT Z (-91.98 46.85 199.1)", "");
+    insertEntry(db.get(), "ortho.tif", EntryType::GeoRaster, R"({"width":1000})", "",
+                "POLYGONZ ((-91.99 46.84 0, -91.98 46.84 0, -91.98 46.85 0, -91.99 46.84 0))");
+    insertEntry(db.get(), "notes.txt", EntryType::Generic, "{}", "", "");
+
+    const auto out = ta.getFolder() / "entries.fgb";
+    EXPECT_EQ(exportEntries(db.get(), out.string()), 3);
+    EXPECT_EQ(exportEntries(db.get(), out.string(), "fgb", "polygon"), 1);
+    EXPECT_EQ(exportEntries(db.get(), out.string(), "fgb", "point"), 2);
+
+    GDALDatasetH hDs = GDALOpenEx(out.string().c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr);
+    ASSERT_TRUE(hDs != nullptr);
+    OGRLayerH hLayer = GDALDatasetGetLayer(hDs, 0);
+    EXPECT_EQ(OGR_L_GetFeatureCount(hLayer, TRUE), 2);
+
+    // Meta keys become typed columns
+    OGRFeatureDefnH hDefn = OGR_L_GetLayerDefn(hLayer);
+    EXPECT_EQ(OGR_Fld_GetType(OGR_FD_GetFieldDefn(hDefn, OGR_FD_GetFieldIndex(hDefn, "width"))), OFTInteger64);
+    EXPECT_EQ(OGR_Fld_GetType(OGR_FD_GetFieldDefn(hDefn, OGR_FD_GetFieldIndex(hDefn, "focalLength"))), OFTReal);
+    EXPECT_EQ(OGR_Fld_GetType(OGR_FD_GetFieldDefn(hDefn, OGR_FD_GetFieldIndex(hDefn, "make"))), OFTString);
+    EXPECT_GE(OGR_FD_GetFieldIndex(hDefn, "meta_path"), 0);
+    GDALClose(hDs);
+}
+
+TEST(exportEntries, invalidFormat) {
+    TestArea ta(TEST_NAME, true);
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    EXPECT_THROW(exportEntries(db.get(), (ta.getFolder() / "entries.txt").string()), InvalidArgsException);
+    EXPECT_THROW(exportEntries(db.get(), (ta.getFolder() / "entries.fgb").string(), "shp"), InvalidArgsException);
+}
+
+}
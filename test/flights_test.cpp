@@ -0,0 +1,157 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <sstream>
+#include "gtest/gtest.h"
+#include "dbops.h"
+#include "flights.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void insertImage(Database *db, const std::string &path, EntryType type, double captureTime, double lon, double lat) {
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth, point_geom) "
+                       "VALUES (?, '', ?, ?, 0, 0, 0, GeomFromText(?, 4326))");
+    q->bind(1, path);
+    q->bind(2, type);
+    q->bind(3, json({{"captureTime", captureTime}}).dump());
+    q->bind(4, "POINT Z (" + std::to_string(lon) + " " + std::to_string(lat) + " 100)");
+    q->execute();
+}
+
+std::unique_ptr<Database> createTestIndex(TestArea &ta) {
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    const double t = 1600000000000.0;
+
+    // First flight: a strip heading north (~11m apart), then a strip heading east
+    for (int i = 0; i < 5; i++) {
+        insertImage(db.get(), "a" + std::to_string(i) + ".JPG", EntryType::GeoImage, t + i * 2000.0, 11.0, 46.0 + i * 0.0001);
+    }
+    for (int i = 0; i < 3; i++) {
+        insertImage(db.get(), "b" + std::to_string(i) + ".JPG", EntryType::GeoImage, t + (5 + i) * 2000.0, 11.0 + (i + 1) * 0.00015, 46.0004);
+    }
+
+    // Second flight, 10 minutes later
+    insertImage(db.get(), "c0.JPG", EntryType::GeoImage, t + 600000.0, 11.0, 46.0);
+    insertImage(db.get(), "c1.JPG", EntryType::GeoImage, t + 602000.0, 11.0, 46.0001);
+
+    // Not a GeoImage, never clustered
+    insertImage(db.get(), "d0.JPG", EntryType::Image, t + 4000.0, 11.0, 46.0);
+
+    return db;
+}
+
+TEST(flights, cluster) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    EXPECT_TRUE(getFlights(db.get()).empty());
+
+    auto flights = clusterFlights(db.get());
+    ASSERT_EQ(flights.size(), 2);
+
+    EXPECT_EQ(flights[0].id, 1);
+    EXPECT_EQ(flights[0].images, 8);
+    EXPECT_EQ(flights[0].strips, 2);
+    EXPECT_DOUBLE_EQ(flights[0].startTime, 1600000000000.0);
+    EXPECT_DOUBLE_EQ(flights[0].endTime, 1600000014000.0);
+    EXPECT_EQ(flights[0].thumbnail, "a4.JPG");
+    EXPECT_FALSE(flights[0].footprint.empty());
+
+    EXPECT_EQ(flights[1].id, 2);
+    EXPECT_EQ(flights[1].images, 2);
+    EXPECT_EQ(flights[1].strips, 1);
+    EXPECT_EQ(flights[1].thumbnail, "c1.JPG");
+
+    // Collinear points have no area
+    EXPECT_TRUE(flights[1].footprint.empty());
+
+    MetaFilter filter;
+    filter.flight = 2;
+    auto entries = getMatchingEntries(db.get(), "", 0, false, filter);
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].meta["flight"], 2);
+    EXPECT_EQ(entries[0].meta["strip"], 1);
+
+    // Loaded entries are checked in memory the same way
+    EXPECT_TRUE(filter.matches(entries[0]));
+    filter.flight = 1;
+    EXPECT_FALSE(filter.matches(entries[0]));
+    filter.flight = 2;
+
+    // Tighter time gap, looser turns
+    FlightOptions options;
+    options.maxTimeGap = 5.0;
+    options.maxTurn = 100.0;
+    db->exec("UPDATE entries SET meta = json_set(meta, '$.captureTime', 1600000030000) WHERE path = 'b0.JPG'");
+    flights = clusterFlights(db.get(), options);
+    ASSERT_EQ(flights.size(), 3);
+    EXPECT_EQ(flights[0].images, 7);
+    EXPECT_EQ(flights[0].strips, 1);
+    EXPECT_EQ(flights[1].images, 1);
+    EXPECT_EQ(flights[1].thumbnail, "b0.JPG");
+    EXPECT_EQ(flights[2].images, 2);
+
+    // Entries that are no longer images lose their assignment
+    db->exec("UPDATE entries SET type = 1 WHERE path LIKE 'c%'");
+    flights = clusterFlights(db.get(), options);
+    ASSERT_EQ(flights.size(), 2);
+    filter.flight = 3;
+    EXPECT_TRUE(getMatchingEntries(db.get(), "", 0, false, filter).empty());
+}
+
+TEST(flights, rollback) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    // Fail halfway through the updates (c1.JPG is the last image)
+    db->exec("CREATE TRIGGER fail_cluster BEFORE UPDATE ON entries WHEN NEW.path = 'c1.JPG' "
+             "BEGIN SELECT json('not json'); END");
+    EXPECT_THROW(clusterFlights(db.get()), DBException);
+
+    // Nothing was assigned and the transaction is closed
+    EXPECT_TRUE(getFlights(db.get()).empty());
+    db->exec("DROP TRIGGER fail_cluster");
+    EXPECT_EQ(clusterFlights(db.get()).size(), 2);
+}
+
+TEST(flights, listFlights) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    std::ostringstream out;
+    listFlights(db.get(), out, "json", false);
+    EXPECT_EQ(out.str(), "[]");
+
+    out.str("");
+    listFlights(db.get(), out, "json");
+    auto j = json::parse(out.str());
+    ASSERT_EQ(j.size(), 2);
+    EXPECT_EQ(j[0]["images"], 8);
+    EXPECT_EQ(j[0]["footprint"]["type"], "Polygon");
+    EXPECT_TRUE(j[1]["footprint"].is_null());
+
+    out.str("");
+    listFlights(db.get(), out, "geojson", false);
+    j = json::parse(out.str());
+    EXPECT_EQ(j["type"], "FeatureCollection");
+    ASSERT_EQ(j["features"].size(), 2);
+    EXPECT_EQ(j["features"][0]["properties"]["id"], 1);
+    EXPECT_EQ(j["features"][0]["geometry"]["type"], "Polygon");
+
+    out.str("");
+    listFlights(db.get(), out, "text", false);
+    EXPECT_EQ(out.str(), "Flight 1: 8 images, 2 strips, 0 minutes (a4.JPG)\n"
+                         "Flight 2: 2 images, 1 strips, 0 minutes (c1.JPG)\n");
+
+    EXPECT_THROW(listFlights(db.get(), out, "xml"), InvalidArgsException);
+}
+
+}
@@ -2,8 +2,11 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <thread>
+#include <ogr_srs_api.h>
 #include "gtest/gtest.h"
 #include "geo.h"
+#include "projection.h"
 
 namespace {
 
@@ -25,4 +28,113 @@ TEST(testUTM, Normal) {
     EXPECT_NEAR(coords.longitude, longitude, 1E-10);
 }
 
+TEST(testUTM, Batch) {
+    UTMZone zone = getUTMZone(46.842979268105516, -91.99321949277439);
+
+    std::vector<Geographic2D> points = {
+        Geographic2D(-91.99321949277439, 46.842979268105516),
+        Geographic2D(-91.99, 46.84),
+        Geographic2D(-92.0, 46.85)
+    };
+
+    auto utm = toUTM(points, zone);
+    ASSERT_EQ(utm.size(), points.size());
+    EXPECT_NEAR(utm[0].x, 576764.77, 1E-2);
+    EXPECT_NEAR(utm[0].y, 5188207.22, 1E-2);
+
+    auto coords = fromUTM(utm, zone);
+    ASSERT_EQ(coords.size(), points.size());
+    for (size_t i = 0; i < points.size(); i++){
+        Projected2D p = toUTM(points[i].latitude, points[i].longitude, zone);
+        EXPECT_DOUBLE_EQ(utm[i].x, p.x);
+        EXPECT_DOUBLE_EQ(utm[i].y, p.y);
+        EXPECT_NEAR(coords[i].latitude, points[i].latitude, 1E-10);
+        EXPECT_NEAR(coords[i].longitude, points[i].longitude, 1E-10);
+    }
+
+    EXPECT_TRUE(toUTM(std::vector<Geographic2D>(), zone).empty());
+
+    // Southern hemisphere uses a different transformation
+    UTMZone south = getUTMZone(-33.9, 18.4);
+    EXPECT_FALSE(south.north);
+    Projected2D p = toUTM(-33.9, 18.4, south);
+    EXPECT_GT(p.y, 0.0);
+    Geographic2D g = fromUTM(p, south);
+    EXPECT_NEAR(g.latitude, -33.9, 1E-10);
+    EXPECT_NEAR(g.longitude, 18.4, 1E-10);
+}
+
+TEST(testUTM, Threads) {
+    UTMZone zone = getUTMZone(46.842979268105516, -91.99321949277439);
+    const Projected2D expected = toUTM(46.842979268105516, -91.99321949277439, zone);
+
+    // Conversions keep no state, so they can run concurrently
+    std::vector<std::thread> threads;
+    std::vector<Projected2D> results(4);
+    for (size_t t = 0; t < results.size(); t++){
+        threads.emplace_back([&, t](){
+            for (int i = 0; i < 100; i++) results[t] = toUTM(46.842979268105516, -91.99321949277439, zone);
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    for (const auto &r : results){
+        EXPECT_DOUBLE_EQ(r.x, expected.x);
+        EXPECT_DOUBLE_EQ(r.y, expected.y);
+    }
+}
+
+TEST(testUTM, AccuracyAgainstPROJ) {
+    // Both hemispheres, the central meridian and the edges of zones
+    const std::vector<std::pair<double, double>> points = {
+        {46.842979268105516, -91.99321949277439}, {0.0, -93.0}, {-33.9, 18.4}, {-33.9, 21.0},
+        {60.0, 5.9}, {83.5, -17.99}, {-79.5, 170.1}, {10.0, -177.0}, {45.0, 6.0}, {-0.0001, 12.0}
+    };
+
+    for (const auto &p : points){
+        const UTMZone zone = getUTMZone(p.first, p.second);
+
+        OGRSpatialReferenceH hSrs = OSRNewSpatialReference(nullptr);
+        OGRSpatialReferenceH hWgs84 = OSRNewSpatialReference(nullptr);
+        ASSERT_EQ(OSRImportFromProj4(hSrs, getProjForUTM(zone).c_str()), OGRERR_NONE);
+        OSRImportFromEPSG(hWgs84, 4326);
+        OGRCoordinateTransformationH hTransform = OCTNewCoordinateTransformation(hWgs84, hSrs);
+
+        double x = p.first;
+        double y = p.second;
+        ASSERT_TRUE(OCTTransform(hTransform, 1, &x, &y, nullptr));
+
+        OCTDestroyCoordinateTransformation(hTransform);
+        OSRDestroySpatialReference(hWgs84);
+        OSRDestroySpatialReference(hSrs);
+
+        const Projected2D utm = toUTM(p.first, p.second, zone);
+        EXPECT_NEAR(utm.x, x, 1E-3);
+        EXPECT_NEAR(utm.y, y, 1E-3);
+
+        const Geographic2D g = fromUTM(utm, zone);
+        EXPECT_NEAR(g.latitude, p.first, 1E-10);
+        EXPECT_NEAR(g.longitude, p.second, 1E-10);
+    }
+}
+
+TEST(webMercator, Normal) {
+    double x, y;
+    geographicToWebMercator(46.842979268105516, -91.99321949277439, x, y);
+    EXPECT_NEAR(x, -10240638.35, 1E-2);
+
+    double latitude, longitude;
+    webMercatorToGeographic(x, y, latitude, longitude);
+    EXPECT_NEAR(latitude, 46.842979268105516, 1E-10);
+    EXPECT_NEAR(longitude, -91.99321949277439, 1E-10);
+
+    geographicToWebMercator(0.0, 180.0, x, y);
+    EXPECT_NEAR(x, 20037508.34, 1E-2);
+    EXPECT_NEAR(y, 0.0, 1E-6);
+
+    // Clamped at the poles
+    geographicToWebMercator(90.0, 0.0, x, y);
+    EXPECT_NEAR(y, 20037508.34, 1E-2);
+}
+
 }
@@ -0,0 +1,56 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <random>
+#include <sstream>
+#include "gtest/gtest.h"
+#include "hash.h"
+#include "test.h"
+
+namespace {
+
+// Bit by bit CRC64 with the same (reflected) polynomial
+// and the formatting the cache keys have always had
+std::string referenceCRC64(const std::string &str){
+    uint64_t crc = 0;
+    for (unsigned char c : str){
+        crc ^= c;
+        for (int i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0x95AC9329AC4BC9B5ULL : crc >> 1;
+    }
+
+    std::ostringstream os;
+    os << std::hex << crc;
+    return os.str();
+}
+
+TEST(hash, crc64) {
+    EXPECT_EQ(Hash::strCRC64(""), "0");
+
+    std::mt19937 rng(42);
+    for (size_t len = 0; len < 200; len++){
+        std::string s;
+        for (size_t i = 0; i < len; i++) s += static_cast<char>(rng());
+        EXPECT_EQ(Hash::strCRC64(s), referenceCRC64(s)) << "length " << len;
+    }
+}
+
+TEST(hash, xxh64) {
+    EXPECT_EQ(Hash::xxh64("", 0), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(Hash::xxh64("abc", 3), 0x44BC2CF5AD770999ULL);
+    EXPECT_EQ(Hash::strXXH64("Nobody inspects the spammish repetition"), "fbcea83c8a378bf1");
+}
+
+TEST(hash, toHex) {
+    EXPECT_EQ(Hash::toHex(0), "0");
+    EXPECT_EQ(Hash::toHex(0xabc), "abc");
+    EXPECT_EQ(Hash::toHex(0xFFFFFFFFFFFFFFFFULL), "ffffffffffffffff");
+}
+
+TEST(hash, cacheKey) {
+    const std::string key = "/data/images/DJI_0001.JPG*1600000000*512";
+    EXPECT_EQ(Hash::cacheKey(key, CacheKeyScheme::CRC64), Hash::strCRC64(key));
+    EXPECT_EQ(Hash::cacheKey(key, CacheKeyScheme::XXH64), Hash::strXXH64(key));
+}
+
+}
@@ -0,0 +1,110 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <limits>
+#include <sstream>
+#include "gtest/gtest.h"
+#include "entry.h"
+#include "jsonwriter.h"
+
+namespace {
+
+using namespace ddb;
+
+TEST(jsonWriter, sameAsDump) {
+    const std::vector<std::string> strings = {
+        "", "plain/path.JPG", "with \"quotes\" and \\backslash\\", "tab\tnew\nline\r\x01\x1f\x7f",
+        "unicode \xc3\xa8\xe2\x82\xac \xf0\x9f\x9a\x81"
+    };
+    const std::vector<double> numbers = {
+        0.0, -0.0, 1.0, -91.99456, 46.842607, 198.31, 1e-7, 1.5e300, 123456789012345678.0,
+        std::numeric_limits<double>::infinity(), std::nan("")
+    };
+
+    json expected = json::object();
+    expected["bool"] = true;
+    expected["int"] = -42;
+    expected["uint"] = std::numeric_limits<std::uint64_t>::max();
+    expected["nested"] = {{"b", {1, 2.5, "x"}}, {"a", nullptr}, {"c", json::object()}};
+    expected["null"] = nullptr;
+    expected["numbers"] = numbers;
+    expected["strings"] = strings;
+
+    std::ostringstream out;
+    {
+        JsonWriter w(out);
+        w.startObject();
+        w.key("bool").value(true);
+        w.key("int").value(-42);
+        w.key("nested").value(expected["nested"]);
+        w.key("null").null();
+        w.key("numbers").startArray();
+        for (double n : numbers) w.value(n);
+        w.endArray();
+        w.key("strings").startArray();
+        for (const auto &s : strings) w.value(s);
+        w.endArray();
+        w.key("uint").value(std::numeric_limits<std::uint64_t>::max());
+        w.endObject();
+    }
+
+    EXPECT_EQ(out.str(), expected.dump());
+
+    // Invalid UTF-8 fails like dump() does
+    std::ostringstream bad;
+    JsonWriter w(bad);
+    EXPECT_THROW(w.value(std::string("\xff\xfe")), json::type_error);
+}
+
+TEST(jsonWriter, flush) {
+    std::ostringstream out;
+    json expected = json::array();
+    {
+        JsonWriter w(out);
+        w.startArray();
+        for (int i = 0; i < 20000; i++){
+            const std::string s = "entry/" + std::to_string(i) + ".JPG";
+            w.startObject().key("path").value(s).key("size").value(i).endObject();
+            expected.push_back({{"path", s}, {"size", i}});
+        }
+        w.endArray();
+
+        // Written in chunks, before the writer is done
+        EXPECT_GT(out.str().size(), 0);
+    }
+
+    EXPECT_EQ(out.str(), expected.dump());
+}
+
+TEST(entry, writeJSON) {
+    Entry e;
+    e.path = "images/\"quoted\" \xc3\xa8.jpg";
+    e.type = EntryType::GeoImage;
+    e.mtime = 1600000000;
+    e.size = 5000000000ULL;
+    e.depth = 1;
+
+    auto dump = [](const Entry &e){
+        json j;
+        e.toJSON(j);
+        return j.dump();
+    };
+    auto write = [](const Entry &e){
+        std::ostringstream out;
+        JsonWriter w(out);
+        e.writeJSON(w);
+        w.flush();
+        return out.str();
+    };
+
+    EXPECT_EQ(write(e), dump(e));
+
+    e.hash = "abc";
+    e.meta = {{"make", "DJI"}, {"captureTime", 1600000000000.0}, {"bands", {{{"type", "Byte"}}}}};
+    e.point_geom.addPoint(-91.99456, 46.842607, 198.31);
+    for (int i = 0; i < 7; i++) e.polygon_geom.addPoint(-91.9 - i * 1e-5, 46.8 + i / 3.0, 0.0);
+    EXPECT_EQ(write(e), dump(e));
+}
+
+}
@@ -0,0 +1,204 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include "gtest/gtest.h"
+#include "exceptions.h"
+#include "las.h"
+#include "octree.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void writeFile(const fs::path &p, const std::string &content) {
+    std::ofstream f(p.string(), std::ios::binary);
+    f << content;
+}
+
+template <typename T>
+void put(std::vector<char> &buf, size_t offset, T value) {
+    if (buf.size() < offset + sizeof(T)) buf.resize(offset + sizeof(T));
+    memcpy(buf.data() + offset, &value, sizeof(T));
+}
+
+void putEntry(std::vector<char> &buf, const NodeKey &k, uint64_t offset, int32_t byteSize, int32_t pointCount) {
+    const size_t o = buf.size();
+    put<int32_t>(buf, o, k.d);
+    put<int32_t>(buf, o + 4, k.x);
+    put<int32_t>(buf, o + 8, k.y);
+    put<int32_t>(buf, o + 12, k.z);
+    put<uint64_t>(buf, o + 16, offset);
+    put<int32_t>(buf, o + 24, byteSize);
+    put<int32_t>(buf, o + 28, pointCount);
+}
+
+std::vector<std::string> keys(const std::vector<OctreeNode> &nodes) {
+    std::vector<std::string> res;
+    for (const auto &n : nodes) res.push_back(n.key.toString());
+    return res;
+}
+
+const double inf = std::numeric_limits<double>::infinity();
+
+TEST(octree, nodeKey) {
+    const auto k = NodeKey::parse("2-3-1-0");
+    EXPECT_EQ(k.toString(), "2-3-1-0");
+    EXPECT_EQ(k.parent().toString(), "1-1-0-0");
+    EXPECT_EQ(k.child(7).toString(), "3-7-3-1");
+    EXPECT_EQ(NodeKey().parent().toString(), "0-0-0-0");
+
+    EXPECT_THROW(NodeKey::parse("1-2-0-0"), InvalidArgsException);
+    EXPECT_THROW(NodeKey::parse("1-0-0"), InvalidArgsException);
+    EXPECT_THROW(NodeKey::parse("1-0-0-0x"), InvalidArgsException);
+}
+
+TEST(octree, ept) {
+    TestArea ta(TEST_NAME, true);
+    const auto ept = ta.getFolder("ept");
+    fs::create_directories(ept / "ept-hierarchy");
+    fs::create_directories(ept / "ept-data");
+
+    writeFile(ept / "ept.json", R"({"bounds":[0,0,0,100,100,100],"points":40,"span":128,"dataType":"laszip","srs":{"wkt":"WKT"}})");
+    writeFile(ept / "ept-hierarchy" / "0-0-0-0.json", R"({"0-0-0-0":10,"1-0-0-0":5,"1-1-1-0":-1})");
+    writeFile(ept / "ept-hierarchy" / "1-1-1-0.json", R"({"1-1-1-0":15,"2-2-2-0":10})");
+    writeFile(ept / "ept-data" / "2-2-2-0.laz", "deep");
+
+    clearOctreeCache();
+    auto octree = openOctree(ept.string());
+    EXPECT_EQ(octree->format(), "ept");
+
+    const auto info = octree->info();
+    EXPECT_EQ(info["points"], 40);
+    EXPECT_EQ(info["srs"], "WKT");
+    EXPECT_DOUBLE_EQ(info["spacing"].get<double>(), 100.0 / 128.0);
+
+    // Pages are loaded as needed
+    OctreeNode n;
+    ASSERT_TRUE(octree->findNode(NodeKey::parse("2-2-2-0"), n));
+    EXPECT_EQ(n.pointCount, 10);
+    ASSERT_TRUE(octree->findNode(NodeKey::parse("1-1-1-0"), n));
+    EXPECT_EQ(n.pointCount, 15);
+    EXPECT_FALSE(octree->findNode(NodeKey::parse("2-0-0-0"), n));
+    EXPECT_FALSE(octree->findNode(NodeKey::parse("3-4-4-0"), n));
+
+    EXPECT_EQ(octree->hierarchy(NodeKey())["1-1-1-0"], -1);
+    EXPECT_EQ(octree->hierarchy(NodeKey::parse("1-1-1-0")).size(), 2);
+    EXPECT_THROW(octree->hierarchy(NodeKey::parse("1-0-0-0")), InvalidArgsException);
+
+    double bounds[6] = { 0, 0, -inf, 10, 10, inf };
+    EXPECT_EQ(keys(octree->query(bounds)), std::vector<std::string>({ "0-0-0-0", "1-0-0-0" }));
+
+    double all[6] = { -inf, -inf, -inf, inf, inf, inf };
+    EXPECT_EQ(octree->query(all, 1).size(), 3);
+    EXPECT_EQ(octree->query(all).size(), 4);
+
+    double b[6];
+    octree->nodeBounds(NodeKey::parse("2-2-2-0"), b);
+    EXPECT_DOUBLE_EQ(b[0], 50.0);
+    EXPECT_DOUBLE_EQ(b[5], 25.0);
+
+    const auto data = octree->readNode(NodeKey::parse("2-2-2-0"));
+    EXPECT_EQ(std::string(data.begin(), data.end()), "deep");
+    EXPECT_THROW(octree->readNode(NodeKey::parse("2-0-0-0")), InvalidArgsException);
+
+    // Cached until ept.json changes
+    EXPECT_EQ(openOctree((ept / "ept.json").string()).get(), octree.get());
+    fs::last_write_time(ept / "ept.json", fs::last_write_time(ept / "ept.json") + std::chrono::seconds(5));
+    EXPECT_NE(openOctree(ept.string()).get(), octree.get());
+}
+
+TEST(octree, copc) {
+    TestArea ta(TEST_NAME, true);
+
+    // LAS 1.4 header with the COPC info VLR
+    std::vector<char> buf(375, 0);
+    memcpy(buf.data(), "LASF", 4);
+    buf[24] = 1;
+    buf[25] = 4;
+    put<uint16_t>(buf, 94, 375);
+    put<uint32_t>(buf, 100, 1);
+    put<uint8_t>(buf, 104, 6 | 0x80);
+    put<uint16_t>(buf, 105, 30);
+    put<uint64_t>(buf, 247, 25);
+
+    std::vector<char> copcInfo(160, 0);
+    put<double>(copcInfo, 0, 50.0);
+    put<double>(copcInfo, 8, 50.0);
+    put<double>(copcInfo, 16, 50.0);
+    put<double>(copcInfo, 24, 50.0);
+    put<double>(copcInfo, 32, 1.0);
+
+    const size_t vlr = buf.size();
+    buf.resize(vlr + 54 + copcInfo.size(), 0);
+    memcpy(buf.data() + vlr + 2, "copc", 4);
+    put<uint16_t>(buf, vlr + 18, 1);
+    put<uint16_t>(buf, vlr + 20, 160);
+    memcpy(buf.data() + vlr + 54, copcInfo.data(), copcInfo.size());
+    const size_t pointData = buf.size();
+    put<uint32_t>(buf, 96, static_cast<uint32_t>(pointData));
+
+    // Node data, followed by the hierarchy pages
+    const std::string rootData = "root";
+    const std::string childData = "child";
+    buf.insert(buf.end(), rootData.begin(), rootData.end());
+    buf.insert(buf.end(), childData.begin(), childData.end());
+
+    const uint64_t rootPage = buf.size();
+    const uint64_t childPage = rootPage + 2 * 32;
+    std::vector<char> entries;
+    putEntry(entries, NodeKey(), pointData, 4, 10);
+    putEntry(entries, NodeKey(1, 1, 1, 1), childPage, 2 * 32, -1);
+    putEntry(entries, NodeKey(1, 1, 1, 1), pointData + 4, 5, 15);
+    putEntry(entries, NodeKey(2, 3, 3, 3), 0, 0, 0);
+    buf.insert(buf.end(), entries.begin(), entries.end());
+
+    memcpy(buf.data() + vlr + 54 + 40, &rootPage, 8);
+    const uint64_t rootPageSize = 2 * 32;
+    memcpy(buf.data() + vlr + 54 + 48, &rootPageSize, 8);
+
+    const auto copc = ta.getFolder() / "cloud.copc.laz";
+    writeFile(copc, std::string(buf.begin(), buf.end()));
+
+    LasHeader h;
+    ASSERT_TRUE(readLasHeader(copc.string(), h));
+    EXPECT_TRUE(h.isCopc);
+    EXPECT_EQ(h.copc.rootHierarchyOffset, rootPage);
+
+    clearOctreeCache();
+    auto octree = openOctree(copc.string());
+    EXPECT_EQ(octree->format(), "copc");
+    EXPECT_EQ(octree->info()["points"], 25);
+
+    const auto header = octree->readHeader();
+    EXPECT_EQ(header.size(), pointData);
+
+    auto data = octree->readNode(NodeKey());
+    EXPECT_EQ(std::string(data.begin(), data.end()), "root");
+    data = octree->readNode(NodeKey(1, 1, 1, 1));
+    EXPECT_EQ(std::string(data.begin(), data.end()), "child");
+
+    // Empty nodes exist but have no data
+    EXPECT_TRUE(octree->readNode(NodeKey(2, 3, 3, 3)).empty());
+
+    const auto page = octree->hierarchy(NodeKey(1, 1, 1, 1));
+    EXPECT_EQ(page["1-1-1-1"], 15);
+    EXPECT_EQ(page["2-3-3-3"], 0);
+
+    double bounds[6] = { 60, 60, 60, 70, 70, 70 };
+    EXPECT_EQ(keys(octree->query(bounds)), std::vector<std::string>({ "0-0-0-0", "1-1-1-1" }));
+
+    // Not a COPC file
+    const auto las = ta.getFolder() / "test.las";
+    buf.resize(375);
+    put<uint32_t>(buf, 100, 0);
+    writeFile(las, std::string(buf.begin(), buf.end()));
+    EXPECT_THROW(openOctree(las.string()), InvalidArgsException);
+}
+
+}
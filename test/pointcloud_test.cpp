@@ -2,8 +2,14 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <cstring>
+#include <fstream>
+#include <gdal_priv.h>
+#include <pdal/StageFactory.hpp>
 #include "gtest/gtest.h"
 #include "pointcloud.h"
+#include "thumbs.h"
+#include "las.h"
 #include "dbops.h"
 #include "test.h"
 #include "testarea.h"
@@ -23,6 +29,272 @@ TEST(pointcloud, parse) {
     ddb::PointCloudInfo i;
     EXPECT_TRUE(ddb::getPointCloudInfo(pc.string(), i));
     EXPECT_EQ(i.pointCount, 24503);
+
+    ddb::LasHeader h;
+    EXPECT_TRUE(ddb::readLasHeader(pc.string(), h));
+    EXPECT_TRUE(h.compressed);
+    EXPECT_EQ(h.pointCount, 24503);
+    EXPECT_EQ(i.bounds.size(), 6);
+}
+
+template <typename T>
+void put(std::vector<char> &buf, size_t offset, T value) {
+    if (buf.size() < offset + sizeof(T)) buf.resize(offset + sizeof(T));
+    memcpy(buf.data() + offset, &value, sizeof(T));
+}
+
+void putVlr(std::vector<char> &buf, const std::string &userId, uint16_t recordId, const std::vector<char> &data) {
+    const size_t o = buf.size();
+    buf.resize(o + 54 + data.size(), 0);
+    memcpy(buf.data() + o + 2, userId.c_str(), userId.length());
+    put<uint16_t>(buf, o + 18, recordId);
+    put<uint16_t>(buf, o + 20, static_cast<uint16_t>(data.size()));
+    memcpy(buf.data() + o + 54, data.data(), data.size());
+}
+
+// Minimal LAS file with the given version, point format and VLRs (no points)
+std::vector<char> lasHeader(uint8_t minor, uint8_t format, uint16_t recordLength, uint16_t headerSize) {
+    std::vector<char> buf(headerSize, 0);
+    memcpy(buf.data(), "LASF", 4);
+    buf[24] = 1;
+    buf[25] = minor;
+    put<uint16_t>(buf, 94, headerSize);
+    put<uint8_t>(buf, 104, format);
+    put<uint16_t>(buf, 105, recordLength);
+    for (int i = 0; i < 3; i++) put<double>(buf, 131 + i * 8, 0.01);
+    put<double>(buf, 179, 500100.0); // max x
+    put<double>(buf, 187, 500000.0); // min x
+    put<double>(buf, 195, 4500100.0); // max y
+    put<double>(buf, 203, 4500000.0); // min y
+    put<double>(buf, 211, 50.0); // max z
+    put<double>(buf, 219, 10.0); // min z
+    return buf;
+}
+
+void writeFile(const fs::path &p, const std::vector<char> &buf) {
+    std::ofstream f(p.string(), std::ios::binary);
+    f.write(buf.data(), buf.size());
+}
+
+TEST(pointcloud, lasHeader) {
+    TestArea ta(TEST_NAME, true);
+
+    // LAS 1.2, point format 3, GeoTIFF keys (EPSG:32617) and one extra dimension
+    auto buf = lasHeader(2, 3, 34 + 4, 227);
+    put<uint32_t>(buf, 107, 1234);
+
+    std::vector<char> keys;
+    const uint16_t geoKeys[] = { 1, 1, 0, 1, 3072, 0, 1, 32617 };
+    for (size_t i = 0; i < 8; i++) put<uint16_t>(keys, i * 2, geoKeys[i]);
+
+    std::vector<char> extraBytes(192, 0);
+    memcpy(extraBytes.data() + 4, "Reflectance", 11);
+
+    putVlr(buf, "LASF_Projection", 34735, keys);
+    putVlr(buf, "LASF_Spec", 4, extraBytes);
+    put<uint32_t>(buf, 100, 2);
+    put<uint32_t>(buf, 96, static_cast<uint32_t>(buf.size()));
+
+    const auto las12 = ta.getFolder() / "test12.las";
+    writeFile(las12, buf);
+
+    LasHeader h;
+    ASSERT_TRUE(readLasHeader(las12.string(), h));
+    EXPECT_EQ(h.versionMinor, 2);
+    EXPECT_EQ(h.pointFormat, 3);
+    EXPECT_FALSE(h.compressed);
+    EXPECT_EQ(h.pointCount, 1234);
+    EXPECT_EQ(h.epsg, 32617);
+    EXPECT_TRUE(h.wkt.empty());
+    EXPECT_DOUBLE_EQ(h.minX, 500000.0);
+    EXPECT_DOUBLE_EQ(h.maxZ, 50.0);
+
+    const auto dims = h.dimensions();
+    EXPECT_EQ(dims.size(), 12 + 1 + 3 + 1);
+    EXPECT_EQ(dims.back(), "Reflectance");
+
+    PointCloudInfo info;
+    ASSERT_TRUE(getPointCloudInfo(las12.string(), info));
+    EXPECT_EQ(info.pointCount, 1234);
+    EXPECT_FALSE(info.wktProjection.empty());
+    EXPECT_EQ(info.polyBounds.size(), 5);
+
+    // LAS 1.4, compressed point format 6 with a 64bit point count and WKT
+    buf = lasHeader(4, 6 | 0x80, 30, 375);
+    put<uint64_t>(buf, 247, 5000000000ULL);
+    const std::string wkt = "GEOGCS[\"WGS 84\",DATUM[\"WGS_1984\",SPHEROID[\"WGS 84\",6378137,298.257223563]],PRIMEM[\"Greenwich\",0],UNIT[\"degree\",0.0174532925199433]]";
+    putVlr(buf, "LASF_Projection", 2112, std::vector<char>(wkt.begin(), wkt.end()));
+    put<uint32_t>(buf, 100, 1);
+
+    const auto las14 = ta.getFolder() / "test14.laz";
+    writeFile(las14, buf);
+
+    ASSERT_TRUE(readLasHeader(las14.string(), h));
+    EXPECT_TRUE(h.compressed);
+    EXPECT_EQ(h.pointFormat, 6);
+    EXPECT_EQ(h.pointCount, 5000000000ULL);
+    EXPECT_EQ(h.wkt, wkt);
+    EXPECT_EQ(h.dimensions().size(), 12 + 2 + 1);
+
+    // Not a LAS file
+    const auto notLas = ta.getFolder() / "test.txt";
+    writeFile(notLas, std::vector<char>(400, 'a'));
+    EXPECT_FALSE(readLasHeader(notLas.string(), h));
+
+    // Records longer than the file
+    buf = lasHeader(2, 3, 34, 227);
+    putVlr(buf, "LASF_Projection", 2112, std::vector<char>(100, 'a'));
+    put<uint32_t>(buf, 100, 1);
+    buf.resize(buf.size() - 50);
+    const auto shortVlr = ta.getFolder() / "shortvlr.las";
+    writeFile(shortVlr, buf);
+    EXPECT_FALSE(readLasHeader(shortVlr.string(), h));
+
+    buf = lasHeader(4, 6, 30, 375);
+    put<uint64_t>(buf, 235, buf.size()); // EVLR start
+    put<uint32_t>(buf, 243, 1);
+    std::vector<char> evlr(60, 0);
+    memcpy(evlr.data() + 2, "LASF_Projection", 15);
+    put<uint16_t>(evlr, 18, 2112);
+    put<uint64_t>(evlr, 20, 0xFFFFFFFFFFFFULL);
+    buf.insert(buf.end(), evlr.begin(), evlr.end());
+    const auto hugeEvlr = ta.getFolder() / "hugeevlr.las";
+    writeFile(hugeEvlr, buf);
+    EXPECT_FALSE(readLasHeader(hugeEvlr.string(), h));
+}
+
+TEST(pointcloud, geographicLas) {
+    TestArea ta(TEST_NAME, true);
+
+    // LAS 1.2 in EPSG:4326 (longitude first, like every LAS file)
+    auto buf = lasHeader(2, 3, 34, 227);
+    put<double>(buf, 179, 11.001); // max x
+    put<double>(buf, 187, 11.0); // min x
+    put<double>(buf, 195, 46.002); // max y
+    put<double>(buf, 203, 46.0); // min y
+
+    std::vector<char> keys;
+    const uint16_t geoKeys[] = { 1, 1, 0, 2, 1024, 0, 1, 2, 2048, 0, 1, 4326 };
+    for (size_t i = 0; i < 12; i++) put<uint16_t>(keys, i * 2, geoKeys[i]);
+    putVlr(buf, "LASF_Projection", 34735, keys);
+    put<uint32_t>(buf, 100, 1);
+    put<uint32_t>(buf, 96, static_cast<uint32_t>(buf.size()));
+
+    const auto las = ta.getFolder() / "geographic.las";
+    writeFile(las, buf);
+
+    PointCloudInfo info;
+    ASSERT_TRUE(getPointCloudInfo(las.string(), info));
+    ASSERT_EQ(info.polyBounds.size(), 5);
+
+    // Same bounds as PDAL reports
+    pdal::StageFactory factory;
+    pdal::Stage *s = factory.createStage("readers.las");
+    pdal::Options opts;
+    opts.add("filename", las.string());
+    s->setOptions(opts);
+    const pdal::QuickInfo qi = s->preview();
+    ASSERT_TRUE(qi.valid());
+
+    const auto min = info.polyBounds.getPoint(0);
+    const auto max = info.polyBounds.getPoint(2);
+    EXPECT_NEAR(min.x, qi.m_bounds.minx, 1e-9);
+    EXPECT_NEAR(min.y, qi.m_bounds.miny, 1e-9);
+    EXPECT_NEAR(max.x, qi.m_bounds.maxx, 1e-9);
+    EXPECT_NEAR(max.y, qi.m_bounds.maxy, 1e-9);
+
+    EXPECT_NEAR(min.x, 11.0, 1e-9);
+    EXPECT_NEAR(min.y, 46.0, 1e-9);
+    EXPECT_NEAR(info.centroid.getPoint(0).x, 11.0005, 1e-9);
+    EXPECT_NEAR(info.centroid.getPoint(0).y, 46.001, 1e-9);
+}
+
+TEST(pointcloud, footprint) {
+    TestArea ta(TEST_NAME);
+    fs::path pc = ta.downloadTestAsset("https://github.com/DroneDB/test_data/raw/master/brighton/point_cloud.laz",
+                                          "point_cloud.laz");
+
+    ddb::PointCloudInfo i;
+    ASSERT_TRUE(ddb::getPointCloudInfo(pc.string(), i));
+
+    ddb::BasicPolygonGeometry footprint;
+    ASSERT_TRUE(ddb::getPointCloudFootprint(pc.string(), footprint, 64));
+    EXPECT_GE(footprint.size(), 4);
+
+    // Closed ring within the bounding box
+    const auto first = footprint.getPoint(0);
+    const auto last = footprint.getPoint(footprint.size() - 1);
+    EXPECT_DOUBLE_EQ(first.x, last.x);
+    EXPECT_DOUBLE_EQ(first.y, last.y);
+
+    const auto bboxMin = i.polyBounds.getPoint(0);
+    const auto bboxMax = i.polyBounds.getPoint(2);
+    for (int j = 0; j < footprint.size(); j++){
+        const auto p = footprint.getPoint(j);
+        EXPECT_GE(p.x, bboxMin.x - 1e-6);
+        EXPECT_LE(p.x, bboxMax.x + 1e-6);
+        EXPECT_GE(p.y, bboxMin.y - 1e-6);
+        EXPECT_LE(p.y, bboxMax.y + 1e-6);
+    }
+}
+
+TEST(pointcloud, occupancyBoundary) {
+    // A diagonal strip: the outline follows it instead of the bounding box
+    const int size = 50;
+    std::vector<uint8_t> grid(size * size, 0);
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            if (std::abs(x - y) < 6) grid[y * size + x] = 1;
+
+    // Smaller, separate area is ignored
+    grid[size - 1] = 1;
+
+    const auto ring = ddb::traceOccupancyBoundary(grid, size, size);
+    ASSERT_GE(ring.size(), 5);
+    EXPECT_DOUBLE_EQ(ring.front().x, ring.back().x);
+    EXPECT_DOUBLE_EQ(ring.front().y, ring.back().y);
+
+    for (const auto &p : ring){
+        EXPECT_LE(std::abs(p.x - p.y), 7);
+    }
+
+    const auto single = ddb::traceOccupancyBoundary({0, 0, 0, 1}, 2, 2);
+    ASSERT_EQ(single.size(), 5);
+    EXPECT_DOUBLE_EQ(single[0].x, 1);
+    EXPECT_DOUBLE_EQ(single[2].y, 2);
+
+    EXPECT_TRUE(ddb::traceOccupancyBoundary({0, 0, 0, 0}, 2, 2).empty());
+
+    // Two large, separate areas cannot be described by one ring
+    std::vector<uint8_t> twoAreas(size * size, 0);
+    for (int y = 0; y < 10; y++)
+        for (int x = 0; x < 10; x++){
+            twoAreas[y * size + x] = 1;
+            twoAreas[(y + 30) * size + x + 30] = 1;
+        }
+    EXPECT_TRUE(ddb::traceOccupancyBoundary(twoAreas, size, size).empty());
+}
+
+TEST(pointcloud, rasterize){
+    TestArea ta(TEST_NAME);
+    fs::path pc = ta.downloadTestAsset("https://github.com/DroneDB/test_data/raw/master/brighton/point_cloud.laz",
+                                          "point_cloud.laz");
+
+    const auto preview = ta.getFolder() / "preview.tif";
+    ddb::rasterizePointCloud(pc.string(), preview.string(), 256, 10000);
+
+    GDALDatasetH hDataset = GDALOpen(preview.string().c_str(), GA_ReadOnly);
+    ASSERT_TRUE(hDataset != nullptr);
+    EXPECT_EQ(GDALGetRasterCount(hDataset), 4);
+    EXPECT_EQ(std::max(GDALGetRasterXSize(hDataset), GDALGetRasterYSize(hDataset)), 256);
+    EXPECT_STRNE(GDALGetProjectionRef(hDataset), "");
+    GDALClose(hDataset);
+
+    EXPECT_TRUE(ddb::supportsThumbnails(EntryType::PointCloud));
+    const auto thumb = ta.getFolder() / "thumb.jpg";
+    ddb::generateThumb(pc, 128, thumb, true);
+    EXPECT_TRUE(fs::exists(thumb));
+    EXPECT_FALSE(fs::exists(thumb.string() + ".tif"));
 }
 
 TEST(pointcloud, ept){
@@ -34,5 +306,23 @@ TEST(pointcloud, ept){
     EXPECT_TRUE(fs::exists(ta.getFolder("ept") / "ept.json"));
 }
 
+#ifdef DDB_COPC
+TEST(pointcloud, copc){
+    TestArea ta(TEST_NAME);
+    fs::path pc = ta.downloadTestAsset("https://github.com/DroneDB/test_data/raw/master/brighton/point_cloud.laz",
+                                          "point_cloud.laz");
+
+    const auto out = ta.getFolder() / "cloud.copc.laz";
+    ddb::buildCopc({ pc.string() }, out.string());
+    EXPECT_TRUE(fs::exists(out));
+    EXPECT_FALSE(fs::exists(out.string() + "-tmp"));
+
+    // The output is a valid LAS 1.4 file
+    ddb::PointCloudInfo info;
+    EXPECT_TRUE(ddb::getPointCloudInfo(out.string(), info));
+    EXPECT_GT(info.pointCount, 0);
+}
+#endif
+
 
 }
@@ -0,0 +1,120 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include "gtest/gtest.h"
+#include "dbops.h"
+#include "search.h"
+#include "exceptions.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void insertEntry(Database *db, const std::string &path, EntryType type, const std::string &meta) {
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth) "
+                       "VALUES (?, '', ?, ?, 0, 0, ?)");
+    q->bind(1, path);
+    q->bind(2, type);
+    q->bind(3, meta);
+    q->bind(4, static_cast<int>(std::count(path.begin(), path.end(), '/')));
+    q->execute();
+}
+
+std::unique_ptr<Database> createTestIndex(TestArea &ta) {
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    insertEntry(db.get(), "flight1", EntryType::Directory, "null");
+    insertEntry(db.get(), "flight1/DJI_0001.JPG", EntryType::GeoImage, R"({"make":"DJI","model":"FC6310"})");
+    insertEntry(db.get(), "flight1/DJI_0002.JPG", EntryType::GeoImage, R"({"make":"DJI","model":"FC6310"})");
+    insertEntry(db.get(), "IMG_1234.JPG", EntryType::Image, R"({"make":"Canon","model":"EOS 5D"})");
+    insertEntry(db.get(), "notes_dji.md", EntryType::Markdown, "{}");
+
+    return db;
+}
+
+std::vector<std::string> paths(const std::vector<Entry> &entries) {
+    std::vector<std::string> result;
+    for (const auto &e : entries) result.push_back(e.path);
+    return result;
+}
+
+TEST(search, ranked) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    ASSERT_TRUE(db->hasSearchIndex());
+    EXPECT_EQ(db->hasTrigramSearchIndex(), Database::supportsTrigramSearch());
+
+    // Case insensitive, matches both paths and cameras
+    auto results = paths(search(db.get(), "dji"));
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_NE(std::find(results.begin(), results.end(), "notes_dji.md"), results.end());
+
+    EXPECT_EQ(paths(search(db.get(), "canon")), std::vector<std::string>({"IMG_1234.JPG"}));
+    EXPECT_EQ(paths(search(db.get(), "0002 flight")), std::vector<std::string>({"flight1/DJI_0002.JPG"}));
+    EXPECT_TRUE(search(db.get(), "nothing").empty());
+
+    // Quotes are not query syntax
+    EXPECT_TRUE(search(db.get(), "\"dji\" AND").empty());
+
+    EXPECT_THROW(search(db.get(), "  "), InvalidArgsException);
+}
+
+TEST(search, pagination) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    EXPECT_EQ(search(db.get(), "JPG", 2, 0).size(), 2);
+    EXPECT_EQ(search(db.get(), "JPG", 2, 2).size(), 1);
+    EXPECT_EQ(search(db.get(), "JPG", 0, 0).size(), 3);
+}
+
+TEST(search, shortTerms) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    // Too short for the trigram index, falls back to a scan
+    EXPECT_EQ(paths(search(db.get(), "5D")), std::vector<std::string>({"IMG_1234.JPG"}));
+    EXPECT_EQ(search(db.get(), "_").size(), 4);
+}
+
+TEST(search, wordsIndex) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    // Index built by SQLite versions without the trigram tokenizer
+    db->exec("DROP TRIGGER entries_fts_insert; DROP TRIGGER entries_fts_delete; "
+             "DROP TRIGGER entries_fts_update; DROP TABLE entries_fts;");
+    ASSERT_TRUE(db->createSearchIndex(false));
+    EXPECT_FALSE(db->hasTrigramSearchIndex());
+
+    EXPECT_EQ(search(db.get(), "dji").size(), 3);
+    EXPECT_EQ(search(db.get(), "DJI_00").size(), 2);
+    EXPECT_EQ(paths(search(db.get(), "0002 flight")), std::vector<std::string>({"flight1/DJI_0002.JPG"}));
+    EXPECT_EQ(search(db.get(), "FC63").size(), 2);
+    EXPECT_TRUE(search(db.get(), "\"dji\" AND").empty());
+}
+
+TEST(search, inSync) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    moveEntry(db.get(), "IMG_1234.JPG", "renamed.JPG");
+    EXPECT_EQ(paths(search(db.get(), "renamed")), std::vector<std::string>({"renamed.JPG"}));
+    EXPECT_TRUE(search(db.get(), "1234").empty());
+
+    db->exec("DELETE FROM entries WHERE path = 'notes_dji.md'");
+    EXPECT_EQ(search(db.get(), "dji").size(), 2);
+
+    db->rebuildSearchIndex();
+    EXPECT_EQ(search(db.get(), "dji").size(), 2);
+    EXPECT_EQ(search(db.get(), "canon").size(), 1);
+}
+
+}
@@ -0,0 +1,140 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cmath>
+#include "gtest/gtest.h"
+#include "dbops.h"
+#include "snapshot.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void insertEntry(Database *db, const std::string &path, EntryType type, long long size,
+                 const std::string &meta, const std::string &pointWkt = "") {
+    auto q = db->query("INSERT INTO entries (path, hash, type, meta, mtime, size, depth, point_geom) "
+                       "VALUES (?, '', ?, ?, 0, ?, ?, GeomFromText(?, 4326))");
+    q->bind(1, path);
+    q->bind(2, type);
+    q->bind(3, meta);
+    q->bind(4, size);
+    q->bind(5, static_cast<int>(std::count(path.begin(), path.end(), '/')));
+    q->bind(6, pointWkt);
+    q->execute();
+}
+
+std::unique_ptr<Database> createTestIndex(TestArea &ta) {
+    const auto folder = ta.getFolder("test");
+    initIndex(folder.string());
+    auto db = ddb::open(folder.string(), false);
+
+    insertEntry(db.get(), "flight1", EntryType::Directory, 0, "null");
+    insertEntry(db.get(), "flight1/a.JPG", EntryType::GeoImage, 100,
+                R"({"captureTime":1600000000000,"make":"DJI","model":"FC6310"})", "POINT Z (10 45 100)");
+    insertEntry(db.get(), "flight1/b.JPG", EntryType::GeoImage, 200,
+                R"({"captureTime":1600000060000,"make":"DJI","model":"FC6310"})", "POINT Z (11 46 100)");
+    insertEntry(db.get(), "c.JPG", EntryType::Image, 50,
+                R"({"captureTime":1600086400000,"make":"Canon","model":"EOS"})");
+    insertEntry(db.get(), "readme.md", EntryType::Markdown, 10, "{}");
+
+    return db;
+}
+
+TEST(indexSnapshot, aggregates) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    IndexSnapshot snapshot(db.get());
+
+    EXPECT_EQ(snapshot.totalSize(), 360);
+    EXPECT_EQ(snapshot.size(), 5);
+
+    // Only the columns that were needed are loaded
+    EXPECT_TRUE(snapshot.hasColumns(SCType | SCSize));
+    EXPECT_FALSE(snapshot.hasColumns(SCCaptureTime));
+    EXPECT_FALSE(snapshot.hasColumns(SCPath));
+
+    auto byType = snapshot.countByType();
+    EXPECT_EQ(byType[EntryType::GeoImage].count, 2);
+    EXPECT_EQ(byType[EntryType::GeoImage].size, 300);
+    EXPECT_EQ(byType[EntryType::Directory].count, 1);
+    EXPECT_EQ(byType.count(EntryType::PointCloud), 0);
+
+    double minTime, maxTime;
+    EXPECT_TRUE(snapshot.captureTimeRange(minTime, maxTime));
+    EXPECT_DOUBLE_EQ(minTime, 1600000000000.0);
+    EXPECT_DOUBLE_EQ(maxTime, 1600086400000.0);
+
+    const auto hist = snapshot.captureTimeHistogram(86400000.0);
+    ASSERT_EQ(hist.size(), 2);
+    EXPECT_EQ(hist[0].count, 2);
+    EXPECT_EQ(hist[1].count, 1);
+
+    const auto cameras = snapshot.cameraBreakdown();
+    ASSERT_EQ(cameras.size(), 2);
+    EXPECT_EQ(cameras[0].make, "DJI");
+    EXPECT_EQ(cameras[0].count, 2);
+
+    double minLon, minLat, maxLon, maxLat;
+    EXPECT_TRUE(snapshot.extent(minLon, minLat, maxLon, maxLat));
+    EXPECT_DOUBLE_EQ(minLon, 10.0);
+    EXPECT_DOUBLE_EQ(maxLat, 46.0);
+
+    snapshot.load(SCPath);
+    EXPECT_EQ(snapshot.path(1), "flight1/a.JPG");
+    EXPECT_EQ(snapshot.path(3), "c.JPG");
+}
+
+TEST(indexSnapshot, reloadsOnChange) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    IndexSnapshot snapshot(db.get());
+    snapshot.load(SCType);
+    EXPECT_EQ(snapshot.size(), 5);
+
+    insertEntry(db.get(), "d.txt", EntryType::Generic, 1, "{}");
+
+    // Loading a new column on a changed index reloads everything
+    snapshot.load(SCSize);
+    EXPECT_EQ(snapshot.size(), 6);
+    EXPECT_TRUE(snapshot.hasColumns(SCType | SCSize));
+    EXPECT_EQ(snapshot.totalSize(), 361);
+}
+
+TEST(getMatchingEntries, metaFilter) {
+    TestArea ta(TEST_NAME, true);
+    auto db = createTestIndex(ta);
+
+    MetaFilter filter;
+    filter.capturedAfter = 1600000030000.0;
+    auto entries = getMatchingEntries(db.get(), "", 0, false, filter);
+    ASSERT_EQ(entries.size(), 2);
+
+    filter.capturedBefore = 1600000060000.0;
+    entries = getMatchingEntries(db.get(), "", 0, false, filter);
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(entries[0].path, "flight1/b.JPG");
+
+    MetaFilter camera;
+    camera.camera = "DJI FC6310";
+    EXPECT_EQ(getMatchingEntries(db.get(), "", 0, false, camera).size(), 2);
+    camera.camera = "EOS";
+    EXPECT_EQ(getMatchingEntries(db.get(), "", 0, false, camera).size(), 1);
+    camera.camera = "Canon FC6310";
+    EXPECT_EQ(getMatchingEntries(db.get(), "", 0, false, camera).size(), 0);
+
+    std::ostringstream out;
+    listIndex(db.get(), {}, out, "text", true, 0, camera);
+    EXPECT_EQ(out.str(), "");
+
+    camera.camera = "DJI";
+    out.str("");
+    listIndex(db.get(), {}, out, "text", true, 0, camera);
+    EXPECT_EQ(out.str(), "flight1/a.JPG\nflight1/b.JPG\n");
+}
+
+}
@@ -4,6 +4,7 @@
 
 #include "test.h"
 #include "tiler.h"
+#include "overviews.h"
 #include "testarea.h"
 
 namespace {
@@ -49,4 +50,24 @@ TEST(testTiler, DSM){
     //      - different tile sizes
 }
 
+TEST(testTiler, Overviews){
+    TestArea ta(TEST_NAME);
+    fs::path dsm = ta.downloadTestAsset("https://github.com/DroneDB/test_data/raw/master/brighton/dsm.tif",
+                                          "dsm.tif");
+    const fs::path vrt = ta.getFolder("overviews") / DDB_OVERVIEWS_FILE;
+
+    EXPECT_TRUE(buildOverviews(dsm.string(), vrt.string(), 64));
+    EXPECT_TRUE(fs::exists(vrt));
+    EXPECT_TRUE(fs::exists(vrt.string() + ".ovr"));
+
+    // Not part of a dataset
+    EXPECT_TRUE(findBuiltOverviews(dsm).empty());
+
+    fs::path tileDir = ta.getFolder("tiles");
+    Tiler t(vrt.string(), tileDir.string());
+    t.tile(20, 256337, 679094);
+
+    EXPECT_TRUE(fs::exists(tileDir / "20" / "256337" / "679094.png"));
+}
+
 }
@@ -0,0 +1,85 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <fstream>
+#include "gtest/gtest.h"
+#include "usercache.h"
+#include "mio.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+void touch(const fs::path &p){
+    std::ofstream f(p.string());
+    f << "x";
+}
+
+TEST(userCacheIndex, lookup) {
+    TestArea ta(TEST_NAME, true);
+    const auto source = ta.getFolder() / "image.jpg";
+    const auto thumb = ta.getFolder() / "thumb.jpg";
+    touch(source);
+    touch(thumb);
+    const time_t mtime = io::Path(source).getModifiedTime();
+
+    UserCacheIndex idx(2, 60);
+    EXPECT_TRUE(idx.lookup("a").empty());
+
+    idx.store("a", source, mtime, thumb);
+    EXPECT_EQ(idx.lookup("a"), thumb);
+
+    // Least recently used entries are evicted
+    idx.store("b", source, mtime, thumb);
+    idx.lookup("a");
+    idx.store("c", source, mtime, thumb);
+    EXPECT_TRUE(idx.lookup("b").empty());
+    EXPECT_EQ(idx.lookup("a"), thumb);
+    EXPECT_EQ(idx.lookup("c"), thumb);
+
+    const auto stats = idx.getStats();
+    EXPECT_EQ(stats.hits, 4);
+    EXPECT_EQ(stats.misses, 2);
+    EXPECT_EQ(stats.revalidations, 0);
+    EXPECT_EQ(stats.entries, 2);
+    EXPECT_DOUBLE_EQ(stats.hitRate(), 4.0 / 6.0);
+
+    idx.clear();
+    EXPECT_TRUE(idx.lookup("a").empty());
+}
+
+TEST(userCacheIndex, revalidate) {
+    TestArea ta(TEST_NAME, true);
+    const auto source = ta.getFolder() / "image.jpg";
+    const auto thumb = ta.getFolder() / "thumb.jpg";
+    touch(source);
+    touch(thumb);
+    const time_t mtime = io::Path(source).getModifiedTime();
+
+    // Always revalidate
+    UserCacheIndex idx(16, 0);
+    idx.store("a", source, mtime, thumb);
+    EXPECT_EQ(idx.lookup("a"), thumb);
+    EXPECT_EQ(idx.getStats().revalidations, 1);
+
+    // Source changed
+    io::Path(source).setModifiedTime(mtime + 10);
+    EXPECT_TRUE(idx.lookup("a").empty());
+
+    // Cached file was removed
+    idx.store("a", source, mtime + 10, thumb);
+    fs::remove(thumb);
+    EXPECT_TRUE(idx.lookup("a").empty());
+
+    // Source was removed
+    touch(thumb);
+    idx.store("a", source, mtime + 10, thumb);
+    fs::remove(source);
+    EXPECT_TRUE(idx.lookup("a").empty());
+    EXPECT_EQ(idx.getStats().entries, 0);
+}
+
+}
@@ -0,0 +1,291 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <fstream>
+#include <sstream>
+#include "gtest/gtest.h"
+#include "video.h"
+#include "thumbs.h"
+#include "test.h"
+#include "testarea.h"
+
+namespace {
+
+using namespace ddb;
+
+typedef std::vector<uint8_t> Bytes;
+
+void be32(Bytes &b, uint32_t v) {
+    for (int s = 24; s >= 0; s -= 8) b.push_back(static_cast<uint8_t>(v >> s));
+}
+
+void be16(Bytes &b, uint16_t v) {
+    b.push_back(static_cast<uint8_t>(v >> 8));
+    b.push_back(static_cast<uint8_t>(v));
+}
+
+Bytes box(const std::string &type, const Bytes &payload) {
+    Bytes b;
+    be32(b, static_cast<uint32_t>(payload.size() + 8));
+    b.insert(b.end(), type.begin(), type.end());
+    b.insert(b.end(), payload.begin(), payload.end());
+    return b;
+}
+
+Bytes concat(const std::vector<Bytes> &parts) {
+    Bytes b;
+    for (const auto &p : parts) b.insert(b.end(), p.begin(), p.end());
+    return b;
+}
+
+// Full box with a table of 32 bit entries
+Bytes table(const std::string &type, const std::vector<uint32_t> &entries, uint32_t count) {
+    Bytes b(4, 0);
+    be32(b, count);
+    for (auto e : entries) be32(b, e);
+    return box(type, b);
+}
+
+// Track with one sample per chunk, 1 second per sample
+Bytes trak(const std::string &handler, const std::string &format, int width, int height,
+           const std::vector<uint32_t> &sizes, const std::vector<uint32_t> &offsets,
+           const std::vector<uint32_t> &sync) {
+    Bytes tkhd(84, 0);
+    tkhd[76] = static_cast<uint8_t>(width >> 8);
+    tkhd[77] = static_cast<uint8_t>(width);
+    tkhd[80] = static_cast<uint8_t>(height >> 8);
+    tkhd[81] = static_cast<uint8_t>(height);
+
+    Bytes mdhd(12, 0);
+    be32(mdhd, 1000);
+    be32(mdhd, static_cast<uint32_t>(sizes.size() * 1000));
+    be32(mdhd, 0);
+
+    Bytes hdlr(8, 0);
+    hdlr.insert(hdlr.end(), handler.begin(), handler.end());
+    hdlr.resize(hdlr.size() + 13, 0);
+
+    Bytes stsd(4, 0);
+    be32(stsd, 1);
+    stsd = concat({ stsd, box(format, Bytes(8, 0)) });
+
+    Bytes stsz(4, 0);
+    be32(stsz, 0);
+    be32(stsz, static_cast<uint32_t>(sizes.size()));
+    for (auto s : sizes) be32(stsz, s);
+
+    std::vector<Bytes> stbl = {
+        box("stsd", stsd),
+        table("stts", { static_cast<uint32_t>(sizes.size()), 1000 }, 1),
+        table("stsc", { 1, 1, 1 }, 1),
+        box("stsz", stsz),
+        table("stco", offsets, static_cast<uint32_t>(offsets.size()))
+    };
+    if (!sync.empty()) stbl.push_back(table("stss", sync, static_cast<uint32_t>(sync.size())));
+
+    return box("trak", concat({
+        box("tkhd", tkhd),
+        box("mdia", concat({
+            box("mdhd", mdhd),
+            box("hdlr", hdlr),
+            box("minf", box("stbl", concat(stbl)))
+        }))
+    }));
+}
+
+Bytes textSample(const std::string &text) {
+    Bytes b;
+    be16(b, static_cast<uint16_t>(text.size()));
+    b.insert(b.end(), text.begin(), text.end());
+    return b;
+}
+
+void writeFile(const fs::path &p, const Bytes &b) {
+    std::ofstream f(p.string(), std::ios::binary);
+    f.write(reinterpret_cast<const char *>(b.data()), b.size());
+}
+
+TEST(video, srtTelemetry) {
+    std::stringstream ss;
+    ss << "1\r\n00:00:00,000 --> 00:00:00,033\r\n"
+          "<font size=\"28\">FrameCnt: 1, DiffTime: 33ms\r\n"
+          "[latitude: 46.842] [longitude: -91.994] [rel_alt: 10.0 abs_alt: 250.5]</font>\r\n\r\n"
+          "2\r\n00:00:00,033 --> 00:00:00,066\r\n"
+          "[latitude: 46.843] [longitude: -91.995] [rel_alt: 10.0 abs_alt: 251.0]\r\n\r\n"
+          "3\r\n00:00:01,001 --> 00:00:01,034\r\n"
+          "[latitude : 46.844] [longtitude : -91.996] [altitude: 252.0]\r\n\r\n"
+          "4\r\n00:00:02,500 --> 00:00:02,533\r\n"
+          "[latitude: 0.000] [longitude: 0.000] [rel_alt: 0.0 abs_alt: 0.0]\r\n\r\n"
+          "5\r\n00:00:03,000 --> 00:00:04,000\r\n"
+          "HOME(-91.9900,46.8400) 2018.09.01 12:00:00\r\n"
+          "GPS(-91.9970,46.8450,19) BAROMETER:25.7\r\n";
+
+    std::vector<VideoTrackPoint> track;
+    parseSrtTelemetry(ss, track, 1.0);
+
+    ASSERT_EQ(track.size(), 3);
+    EXPECT_DOUBLE_EQ(track[0].time, 0.0);
+    EXPECT_DOUBLE_EQ(track[0].latitude, 46.842);
+    EXPECT_DOUBLE_EQ(track[0].longitude, -91.994);
+    EXPECT_DOUBLE_EQ(track[0].altitude, 250.5);
+
+    EXPECT_DOUBLE_EQ(track[1].time, 1.001);
+    EXPECT_DOUBLE_EQ(track[1].longitude, -91.996);
+    EXPECT_DOUBLE_EQ(track[1].altitude, 252.0);
+
+    EXPECT_DOUBLE_EQ(track[2].time, 3.0);
+    EXPECT_DOUBLE_EQ(track[2].longitude, -91.997);
+    EXPECT_DOUBLE_EQ(track[2].latitude, 46.845);
+    EXPECT_DOUBLE_EQ(track[2].altitude, 19.0);
+}
+
+TEST(video, mp4) {
+    TestArea ta(TEST_NAME);
+
+    const std::vector<Bytes> frames = {
+        Bytes({ 0xFF, 0xD8, 0xFF, 'A' }), Bytes({ 0xFF, 0xD8, 0xFF, 'B' }),
+        Bytes({ 0xFF, 0xD8, 0xFF, 'C' }), Bytes({ 0xFF, 0xD8, 0xFF, 'D' })
+    };
+    const std::vector<Bytes> texts = {
+        textSample("[latitude: 46.1] [longitude: 11.1] [rel_alt: 1.0 abs_alt: 100.0]"),
+        textSample("[latitude: 46.2] [longitude: 11.2] [rel_alt: 1.0 abs_alt: 101.0]"),
+        textSample("[latitude: 46.3] [longitude: 11.3] [rel_alt: 1.0 abs_alt: 102.0]"),
+        textSample("no fix")
+    };
+
+    const Bytes ftyp = box("ftyp", Bytes({ 'i', 's', 'o', 'm', 0, 0, 0, 0 }));
+
+    // Media data comes first, the movie box at the end of the file
+    Bytes mdatPayload;
+    std::vector<uint32_t> frameSizes, frameOffsets, textSizes, textOffsets;
+    const uint32_t base = static_cast<uint32_t>(ftyp.size() + 8);
+    for (size_t i = 0; i < frames.size(); i++) {
+        frameOffsets.push_back(base + static_cast<uint32_t>(mdatPayload.size()));
+        frameSizes.push_back(static_cast<uint32_t>(frames[i].size()));
+        mdatPayload.insert(mdatPayload.end(), frames[i].begin(), frames[i].end());
+
+        textOffsets.push_back(base + static_cast<uint32_t>(mdatPayload.size()));
+        textSizes.push_back(static_cast<uint32_t>(texts[i].size()));
+        mdatPayload.insert(mdatPayload.end(), texts[i].begin(), texts[i].end());
+    }
+
+    Bytes mvhd(12, 0);
+    be32(mvhd, 1000);
+    be32(mvhd, 4000);
+    mvhd.resize(100, 0);
+
+    const auto moov = box("moov", concat({
+        box("mvhd", mvhd),
+        trak("vide", "jpeg", 640, 480, frameSizes, frameOffsets, { 1, 3 }),
+        trak("sbtl", "tx3g", 0, 0, textSizes, textOffsets, {})
+    }));
+
+    const auto mp4 = ta.getFolder() / "test.mp4";
+    writeFile(mp4, concat({ ftyp, box("mdat", mdatPayload), moov }));
+
+    VideoInfo info;
+    ASSERT_TRUE(getVideoInfo(mp4.string(), info));
+    EXPECT_DOUBLE_EQ(info.duration, 4.0);
+    EXPECT_EQ(info.width, 640);
+    EXPECT_EQ(info.height, 480);
+    ASSERT_EQ(info.track.size(), 3);
+    EXPECT_DOUBLE_EQ(info.track[1].time, 1.0);
+    EXPECT_DOUBLE_EQ(info.track[1].latitude, 46.2);
+    EXPECT_DOUBLE_EQ(info.track[2].altitude, 102.0);
+
+    // Closest sync frame
+    Bytes image;
+    ASSERT_TRUE(extractVideoStill(mp4.string(), image, 0.0));
+    EXPECT_EQ(image, frames[0]);
+    ASSERT_TRUE(extractVideoStill(mp4.string(), image, 0.5));
+    EXPECT_EQ(image, frames[2]);
+    ASSERT_TRUE(extractVideoStill(mp4.string(), image, 1.0));
+    EXPECT_EQ(image, frames[2]);
+
+    // Not a video
+    const auto txt = ta.getFolder() / "test.mov";
+    writeFile(txt, Bytes({ 'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd', '!' }));
+    EXPECT_FALSE(getVideoInfo(txt.string(), info));
+    EXPECT_FALSE(extractVideoStill(txt.string(), image));
+}
+
+TEST(video, corrupt) {
+    TestArea ta(TEST_NAME);
+    const Bytes ftyp = box("ftyp", Bytes({ 'i', 's', 'o', 'm', 0, 0, 0, 0 }));
+    const auto mp4 = ta.getFolder() / "corrupt.mp4";
+    VideoInfo info;
+
+    // Box smaller than its header
+    Bytes tiny;
+    be32(tiny, 4);
+    tiny.insert(tiny.end(), { 'f', 'r', 'e', 'e' });
+    writeFile(mp4, concat({ ftyp, tiny, tiny }));
+    EXPECT_FALSE(getVideoInfo(mp4.string(), info));
+
+    // Box past the end of the file
+    Bytes large;
+    be32(large, 0xFFFFFFF0);
+    large.insert(large.end(), { 'm', 'd', 'a', 't' });
+    writeFile(mp4, concat({ ftyp, large }));
+    EXPECT_FALSE(getVideoInfo(mp4.string(), info));
+
+    // 64 bit box size that would wrap the offset
+    Bytes wrap;
+    be32(wrap, 1);
+    wrap.insert(wrap.end(), { 'm', 'd', 'a', 't' });
+    be32(wrap, 0xFFFFFFFF);
+    be32(wrap, 0xFFFFFFF8);
+    writeFile(mp4, concat({ ftyp, wrap }));
+    EXPECT_FALSE(getVideoInfo(mp4.string(), info));
+
+    // Fixed size samples, far more than the file can hold
+    Bytes tkhd(84, 0);
+    tkhd[77] = 64;
+    tkhd[81] = 48;
+    Bytes stsz(4, 0);
+    be32(stsz, 1024);
+    be32(stsz, 0xFFFFFFFF);
+    const auto moov = box("moov", box("trak", concat({
+        box("tkhd", tkhd),
+        box("mdia", box("minf", box("stbl", box("stsz", stsz))))
+    })));
+    writeFile(mp4, concat({ ftyp, moov }));
+    ASSERT_TRUE(getVideoInfo(mp4.string(), info));
+    EXPECT_EQ(info.width, 0); // Track was rejected
+}
+
+TEST(video, sidecarSrt) {
+    TestArea ta(TEST_NAME);
+
+    // Video without a subtitle track
+    Bytes mvhd(12, 0);
+    be32(mvhd, 1000);
+    be32(mvhd, 2000);
+    mvhd.resize(100, 0);
+
+    const auto mp4 = ta.getFolder() / "DJI_0001.MP4";
+    writeFile(mp4, concat({ box("ftyp", Bytes(8, 0)), box("moov", box("mvhd", mvhd)) }));
+
+    std::ofstream srt((ta.getFolder() / "DJI_0001.SRT").string());
+    srt << "1\n00:00:00,000 --> 00:00:01,000\n[latitude: 46.1] [longitude: 11.1] [altitude: 100.0]\n\n"
+           "2\n00:00:01,000 --> 00:00:02,000\n[latitude: 46.2] [longitude: 11.2] [altitude: 101.0]\n";
+    srt.close();
+
+    VideoInfo info;
+    ASSERT_TRUE(getVideoInfo(mp4.string(), info));
+    EXPECT_DOUBLE_EQ(info.duration, 2.0);
+    EXPECT_EQ(info.track.size(), 2);
+
+    // No frames to extract
+    Bytes image;
+    EXPECT_FALSE(extractVideoStill(mp4.string(), image));
+
+    // Thumbnails fall back to a placeholder
+    const auto thumb = ta.getFolder() / "thumb.jpg";
+    fs::remove(thumb);
+    EXPECT_EQ(generateThumb(mp4, 64, thumb, true), thumb);
+    EXPECT_TRUE(fs::exists(thumb));
+}
+
+}